@@ -10,12 +10,14 @@ class CRandom;
 class CKeyboard;
 class CXBoxController;
 class CAudio;
+class CFrameArena;
 
 /// \brief The component accessor.
 ///
 /// This singleton class encapsulates the components commonly
 /// needed to create a game: A timer, a PRNG, an audio player, 
-/// a keyboard handler, and two particle engines. 
+/// a keyboard handler, an arena for memory that only
+/// lasts a frame, and two particle engines. 
 /// Classes that need these pointers simply need to
 /// be derived from CComponent. 
 
@@ -26,4 +28,5 @@ class CComponent{
     static CKeyboard* m_pKeyboard; ///< Pointer to a keyboard handler.
     static CXBoxController* m_pController; ///< Pointer to a XBox controller.
     static CAudio* m_pAudio; ///< Pointer to an audio player.
+    static CFrameArena* m_pFrameArena; ///< Pointer to the frame arena.
 }; //CComponent
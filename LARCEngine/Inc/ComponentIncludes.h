@@ -7,6 +7,11 @@
 
 #include "Timer.h"
 #include "Random.h"
-#include "Keyboard.h"
-#include "Controller.h"
+
+#ifndef HEADLESS //no keyboard or controller without a window
+  #include "Keyboard.h"
+  #include "Controller.h"
+#endif //HEADLESS
+
 #include "Sound.h"
+#include "FrameArena.h"
@@ -6,6 +6,10 @@
 
 #pragma once
 
+#ifdef HEADLESS
+  #include "Defines.h" //sprite descriptors only need the math
+#else //HEADLESS
+
 #include <wrl/client.h>
 #include <wrl/event.h>
 
@@ -70,4 +74,6 @@ namespace DX{
       if(FAILED(hr))
         throw com_exception(hr);
     } //ThrowIfFailed
-} //DX
\ No newline at end of file
+} //DX
+
+#endif //HEADLESS
@@ -6,6 +6,10 @@
 
 #pragma once
 
+#ifdef HEADLESS
+  #include "HeadlessDefines.h" //just the math, no Windows or Direct3D
+#else //HEADLESS
+
 #include <WinSDKVer.h>
 #define _WIN32_WINNT 0x0A00
 #include <SDKDDKVer.h>
@@ -41,6 +45,8 @@
 
 #include "SimpleMath.h"
 
+#endif //HEADLESS
+
 using namespace DirectX;
 using namespace SimpleMath;
 
@@ -0,0 +1,115 @@
+/// \file FrameArena.h
+/// \brief Interface for the per-frame arena allocator CFrameArena.
+
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+#include "Component.h"
+
+using namespace std;
+
+const size_t DEFAULT_FRAME_ARENA_SIZE = 1 << 20; ///< Default size of the frame arena in bytes.
+const unsigned char FRAME_ARENA_POISON = 0xFD; ///< Byte written over freed memory in Debug mode.
+
+/// \brief The frame arena.
+///
+/// The frame arena hands out memory that only needs to last until the
+/// end of the current frame, such as the scratch lists and strings used
+/// while rendering. Allocation just moves a pointer along a buffer that
+/// is allocated once in the constructor, and nothing is freed until the
+/// whole arena is reset by CTimer::BeginFrame at the start of the next
+/// frame. If the buffer runs out, the extra memory comes from the heap
+/// and is freed at the next reset. The most memory used in any one frame
+/// is recorded so that the buffer size can be tuned. In Debug mode the
+/// memory freed by a reset is filled with FRAME_ARENA_POISON so that
+/// anything hanging on to it after the end of the frame stands out.
+
+class CFrameArena{
+  private:
+    unsigned char* m_pBuffer = nullptr; ///< Memory for the arena.
+    size_t m_nSize = 0; ///< Size of m_pBuffer in bytes.
+    size_t m_nUsed = 0; ///< Number of bytes of m_pBuffer handed out this frame.
+
+    void* m_pOverflow = nullptr; ///< Linked list of heap blocks allocated this frame.
+    size_t m_nOverflowBytes = 0; ///< Number of bytes allocated from the heap this frame.
+
+    size_t m_nHighWater = 0; ///< Most bytes used in any one frame.
+    size_t m_nReported = 0; ///< High water mark last reported.
+
+  public:
+    CFrameArena(size_t size=DEFAULT_FRAME_ARENA_SIZE); ///< Constructor.
+    ~CFrameArena(); ///< Destructor.
+
+    void* allocate(size_t n, size_t align=alignof(max_align_t)); ///< Allocate memory.
+    const char* format(const char* fmt, ...); ///< Make a formatted string.
+    void reset(); ///< Free everything.
+
+    size_t GetUsed(); ///< Get bytes used this frame.
+    size_t GetHighWaterMark(); ///< Get most bytes used in a frame.
+}; //CFrameArena
+
+/// \brief An STL allocator that uses the frame arena.
+///
+/// Containers that use this allocator must not outlive the frame
+/// they were created in. Deallocation does nothing, since the memory
+/// is freed all at once when the arena is reset.
+/// \tparam T Type of object allocated.
+
+template<class T> class CFrameAllocator: public CComponent{
+  template<class U> friend class CFrameAllocator;
+
+  private:
+    CFrameArena* m_pArena = nullptr; ///< Pointer to the arena.
+
+  public:
+    typedef T value_type; ///< Type of object allocated.
+
+    /// Use the frame arena from CComponent.
+
+    CFrameAllocator(): m_pArena(m_pFrameArena){}
+
+    /// Use a given arena.
+    /// \param p Pointer to the arena.
+
+    CFrameAllocator(CFrameArena* p): m_pArena(p){}
+
+    /// Copy the arena from an allocator for another type.
+    /// \param a Allocator to copy.
+
+    template<class U> CFrameAllocator(const CFrameAllocator<U>& a): m_pArena(a.m_pArena){}
+
+    /// Allocate space for some objects.
+    /// \param n Number of objects.
+    /// \return Pointer to the space allocated.
+
+    T* allocate(size_t n){
+      return (T*)m_pArena->allocate(n*sizeof(T), alignof(T));
+    } //allocate
+
+    /// Do nothing, since the arena frees its memory all at once.
+
+    void deallocate(T*, size_t){}
+
+    /// Allocators are equal if they use the same arena.
+    /// \param a Allocator to compare with.
+    /// \return true if memory from one can be freed by the other.
+
+    template<class U> bool operator==(const CFrameAllocator<U>& a) const{
+      return m_pArena == a.m_pArena;
+    } //operator==
+
+    /// Allocators are unequal if they use different arenas.
+    /// \param a Allocator to compare with.
+    /// \return true if memory from one can't be freed by the other.
+
+    template<class U> bool operator!=(const CFrameAllocator<U>& a) const{
+      return m_pArena != a.m_pArena;
+    } //operator!=
+}; //CFrameAllocator
+
+/// \brief A vector whose memory comes from the frame arena.
+/// \tparam T Type of object in the vector.
+
+template<class T> using CFrameVector = vector<T, CFrameAllocator<T>>;
@@ -0,0 +1,55 @@
+/// \file HeadlessAudio.h
+/// \brief Interface for the silent audio player used in headless builds.
+
+#pragma once
+
+#include "Defines.h"
+#include "Settings.h"
+#include "Component.h"
+#include "Random.h"
+
+using namespace std;
+
+/// \brief The sound descriptor.
+///
+/// A sound descriptor contains the information needed
+/// to identify an instance of a sound effect.
+
+class CSoundDesc{
+  public:
+    int m_nEffectIndex = -1; ///< Effect index.
+    int m_nInstanceIndex = -1; ///< Instance index.
+}; //CSoundDesc
+
+/// \brief The silent Audio Player.
+///
+/// A headless build has no XAudio2, so this stands in for the Audio
+/// Player. It has the same interface but doesn't make a sound. It does
+/// draw from the PRNG wherever the real one does, so that the game
+/// plays out the same way with and without it.
+
+class CAudio: 
+  public CSettingsManager,
+  public CComponent{
+
+  public:
+    void Load(){} ///< Load sounds from list in XML document.
+    
+    CSoundDesc play(int, const Vector2&, float=1.0f, float=0.0f){return CSoundDesc();} ///< Play a sound.
+    CSoundDesc play(int, float=1.0f){return CSoundDesc();} ///< Play a sound.
+
+    CSoundDesc loop(int){return CSoundDesc();} ///< Loop a sound.
+    CSoundDesc loop(int, const Vector2&){return CSoundDesc();} ///< Loop a sound.
+    
+    CSoundDesc vary(int, float=0.1f, float=1.0f, float=0.0f){m_pRandom->randf(); return CSoundDesc();} ///< Play a randomly varied sound.
+    CSoundDesc vary(int, const Vector2&, float=0.1f, float=1.0f, float=0.0f){m_pRandom->randf(); return CSoundDesc();} ///< Play a randomly varied sound.
+
+    void BeginFrame(){} ///< Start of frame notification.
+    void mute(){} ///< Mute/unmute the sounds.
+    void stop(){} ///< Stop all sounds.
+    void stop(int){} ///< Stop a sound.
+    void stop(const CSoundDesc&){} ///< Stop a sound instance.
+
+    void SetListenerPos(const Vector2&){} ///< Set the listener position.
+    void SetPitch(int, float){} ///< Set pitch of first instance of sound.
+}; //CAudio
@@ -0,0 +1,120 @@
+/// \file HeadlessDefines.h
+/// \brief Essential defines and includes for headless builds.
+///
+/// A headless build, made by defining HEADLESS, runs the simulation
+/// without a window, Direct3D 12, or XAudio2, so that it can be built
+/// and soak tested anywhere, including on Linux. All it needs from
+/// DirectX is the math, that is, DirectXMath and SimpleMath from
+/// DirectXTK 12, which are header-only. Anywhere other than Windows
+/// DirectXMath also needs sal.h, which comes with the DirectX-Headers
+/// project on github. This file stands in for the few parts of the
+/// Windows headers and the Microsoft C runtime that the simulation uses.
+
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <float.h>
+#include <math.h>
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+  #define NOMINMAX //use the C++ standard templated min/max
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+#else //_WIN32
+  #include <sal.h>
+#endif //_WIN32
+
+#include <DirectXMath.h>
+#include <DirectXColors.h>
+#include <DirectXCollision.h>
+
+#include "SimpleMath.h"
+
+#ifndef _WIN32
+  #define MAX_PATH 260 ///< Longest file name.
+
+  typedef unsigned char BYTE; ///< An unsigned byte.
+
+  /// Debug output goes to the console.
+  /// \param s String to output.
+
+  inline void OutputDebugStringA(const char* s){
+    fputs(s, stderr);
+  } //OutputDebugStringA
+
+  /// Open a file, Microsoft style.
+  /// \param f [OUT] File handle, nullptr if the file can't be opened.
+  /// \param name File name.
+  /// \param mode Mode, as for fopen.
+  /// \return Zero if successful, otherwise an error code.
+
+  inline int fopen_s(FILE** f, const char* name, const char* mode){
+    *f = fopen(name, mode);
+    return *f? 0: errno;
+  } //fopen_s
+
+  /// Copy at most n characters of a string, Microsoft style.
+  /// \param dest Destination buffer.
+  /// \param size Size of the destination buffer.
+  /// \param src Source string.
+  /// \param n Maximum number of characters to copy.
+  /// \return Zero if successful, otherwise an error code.
+
+  inline int strncpy_s(char* dest, size_t size, const char* src, size_t n){
+    if(dest == nullptr || size == 0)return EINVAL;
+
+    const size_t len = std::min(strlen(src), std::min(n, size - 1));
+    memcpy(dest, src, len);
+    dest[len] = '\0';
+
+    return 0;
+  } //strncpy_s
+
+  #define _TRUNCATE ((size_t)-1) ///< Truncate rather than fail.
+
+  /// Convert a multibyte string to a wide one, Microsoft style.
+  /// \param n [OUT] Number of wide characters written, including the terminator.
+  /// \param dest Destination buffer.
+  /// \param size Size of the destination buffer.
+  /// \param src Source string.
+  /// \param count Maximum number of characters to convert.
+  /// \return Zero if successful, otherwise an error code.
+
+  inline int mbstowcs_s(size_t* n, wchar_t* dest, size_t size, const char* src, size_t count){
+    if(dest == nullptr || size == 0)return EINVAL;
+
+    const size_t len = mbstowcs(dest, src, std::min(count, size - 1));
+    if(len == (size_t)-1)return EILSEQ;
+    
+    dest[std::min(len, size - 1)] = L'\0';
+    if(n)*n = len + 1;
+
+    return 0;
+  } //mbstowcs_s
+
+  /// Formatted print into a fixed size buffer, Microsoft style.
+  /// \tparam N Size of the buffer.
+  /// \param buffer Buffer.
+  /// \param fmt Printf style format string.
+  /// \return Number of characters written.
+
+  template<size_t N> int sprintf_s(char (&buffer)[N], const char* fmt, ...){
+    va_list args;
+    va_start(args, fmt);
+    const int n = vsnprintf(buffer, N, fmt, args);
+    va_end(args);
+    return n;
+  } //sprintf_s
+#endif //_WIN32
@@ -0,0 +1,75 @@
+/// \file HeadlessSpriteRenderer.h
+/// \brief Interface for the sprite renderer used in headless builds.
+
+#pragma once
+
+#include <vector>
+
+#include "Defines.h"
+#include "Settings.h"
+#include "Component.h"
+#include "Sprite.h"
+#include "SpriteDesc.h"
+
+using namespace std;
+
+///\brief The headless sprite renderer class.
+///
+/// A headless build has no Direct3D, so this stands in for the sprite
+/// renderer. Drawing does nothing, but the simulation still needs the
+/// size of each sprite, since that is what bounding boxes are made
+/// from. Sprites are loaded from the same tags in gamesettings.xml as
+/// usual, except that only the size of each frame is read. It comes
+/// from width and height attributes in the sprite tag if there are any,
+/// otherwise from the header of the image file.
+
+class CSpriteRenderer:
+  public CComponent,
+  public CSettingsManager
+{
+  public:
+    enum eRenderMode{Batched2D, Unbatched2D, Unbatched3D}; ///< Render mode type.
+
+  protected: 
+    eRenderMode m_eRenderMode; ///< Sprite render mode.
+    Vector3 m_vCameraPos = Vector3::Zero; ///< Camera position.
+    
+    CSprite** m_pSprite = nullptr; ///< Sprite pointers.
+    size_t m_nNumSprites = 0; ///< Number of sprites.
+
+    CSprite* Load(unsigned index, const char* file, const char* ext, int frames); ///< Load sprite.
+
+  public:
+    CSpriteRenderer(eRenderMode mode); ///< Constructor.
+    virtual ~CSpriteRenderer(); ///< Destructor.
+    
+    void Initialize(size_t n); ///< Initialize.
+
+    void BeginResourceUpload(){} ///< Begin uploading textures.
+    void EndResourceUpload(){} ///< End uploading textures.
+
+    void BeginFrame(){} ///< Begin frame.
+    void EndFrame(){} ///< End frame.
+    
+    void Draw(const CSpriteDesc2D&){} ///< Draw single 2D sprite.
+    void Draw(int, const Vector2&, float=0.0f){} ///< Draw single 2D sprite.
+    void DrawLine(unsigned, const Vector2&, const Vector2&){} ///< Draw 2D line.
+
+    void Draw(const CSpriteDesc3D&){} ///< Draw single 3D sprite.
+    void Draw(vector<CSpriteDesc3D>&){} ///< Draw list of 3D sprites.
+
+    void SetCameraPos(const Vector3& pos); ///< Set camera position.
+    const Vector3& GetCameraPos(); ///< Get camera position.
+
+    void Load(unsigned n, const char* name); ///< Load sprite.
+    
+    float GetWidth(unsigned n); ///< Get sprite width.
+    float GetHeight(unsigned n); ///< Get sprite height.
+    void GetSize(unsigned n, float& x, float& y); ///< Get sprite size.
+    void GetSize(unsigned n, unsigned m, float& x, float& y); ///< Get sprite size.
+
+    size_t GetNumFrames(unsigned n);  ///< Get number of frames.
+
+    BoundingBox GetAabb(int n, int m); ///< Get bounding box.
+    bool BoxInFrustum(const BoundingBox&){return true;} ///< Does the box overlap the view frustum?
+}; //CSpriteRenderer
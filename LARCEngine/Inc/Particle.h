@@ -29,6 +29,49 @@ class CParticleDesc: public SPRITEDESC{
     float m_fFadeOutFrac = 0.0f; ///< Fraction of life fading out.
 }; //CParticleDesc
 
+/// \brief Scale of a particle at a given point in its life.
+///
+/// It grows to its maximum scale for the first scale-in fraction
+/// of its life, and shrinks to zero for the last scale-out fraction.
+/// \param f Fraction of lifespan lived, from 0.0f to 1.0f inclusive.
+/// \param maxscale Maximum scale.
+/// \param in Fraction of life growing in.
+/// \param out Fraction of life shrinking out.
+/// \return Scale.
+
+inline float GetParticleScale(float f, float maxscale, float in, float out){
+  float fScale = maxscale; //initial scale
+
+  if(f < in) //growing in
+    fScale *= f/in;
+
+  if(f > 1.0f - out) //shrinking out
+    fScale *= (1.0f - f)/out;
+
+  return fScale;
+} //GetParticleScale
+
+/// \brief Alpha channel of a particle at a given point in its life.
+///
+/// It fades in over the first fade-in fraction of its life and
+/// fades out over the last fade-out fraction. In between, the
+/// alpha channel is left as it was.
+/// \param f Fraction of lifespan lived, from 0.0f to 1.0f inclusive.
+/// \param alpha Current alpha channel.
+/// \param in Fraction of life fading in.
+/// \param out Fraction of life fading out.
+/// \return Alpha channel.
+
+inline float GetParticleAlpha(float f, float alpha, float in, float out){
+  if(f < in) //fading in
+    alpha = f/in;
+
+  if(f > 1.0f - out) //fading out
+    alpha = (1.0f - f)/out;
+
+  return alpha;
+} //GetParticleAlpha
+
 /// \brief A particle.
 ///
 /// A particle is a sprite that exists for a brief time.
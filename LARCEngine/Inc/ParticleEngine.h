@@ -8,12 +8,14 @@
 #include "Component.h"
 #include "Particle.h"
 #include "SpriteRenderer.h"
+#include "ParticleKernel.h"
 
-#include <list>
 #include <vector>
 
 using namespace std;
 
+const size_t DEFAULT_PARTICLE_CAPACITY = 4096; ///< Default size of the particle pool.
+
 /// \brief An abstract particle engine.
 ///
 /// A particle engine is responsible for managing 
@@ -21,6 +23,18 @@ using namespace std;
 /// be called once per animation frame. Templates
 /// are used to make this class independent of
 /// operating system and renderer implementation.
+///
+/// Particles are kept in a fixed-capacity pool stored as a
+/// structure of arrays, one array per field that changes from
+/// frame to frame, so that the step function can stream through
+/// them. The live particles are always the first
+/// m_nCount entries of each array. A dead particle is removed by
+/// moving the last live particle into its place. The rest of each
+/// particle descriptor, which doesn't change, is kept in m_vDesc.
+/// The class PARTICLE describes the behavior of a single particle,
+/// which the pool reproduces field by field. The math is done by a
+/// particle kernel, which uses the widest SIMD instructions that the
+/// CPU supports unless told otherwise.
 /// \tparam PARTICLE Partice class.
 /// \tparam PARTICLEDESC Partice descriptor.
 /// \tparam VECTOR Vector.
@@ -28,16 +42,40 @@ using namespace std;
 template<class PARTICLE, class PARTICLEDESC, class VECTOR>
 class CParticleEngine: public CComponent{
   protected:
-    list<PARTICLE*> m_stdList; ///< Particle list.
-    
-    void move(); ///< Move all particles.
-    float GetLifeFraction(const PARTICLE* p); ///< Get life fraction as a float between 0.0f and 1.0f.
-    void cull(); ///< Cull old dead particles
-    void rescale(); //< Compute new particle scales.
-    void fade(); //< Compute new particle alpha channel.
+    size_t m_nCapacity = 0; ///< Maximum number of particles.
+    size_t m_nCount = 0; ///< Number of live particles.
+
+    vector<PARTICLEDESC> m_vDesc; ///< Particle descriptors, for the fields that don't change.
+
+    vector<VECTOR> m_vPos; ///< Positions.
+    vector<VECTOR> m_vVel; ///< Velocities.
+    vector<VECTOR> m_vAccel; ///< Accelerations.
+    vector<float> m_vFriction; ///< Coefficients of friction.
+    vector<float> m_vRSpeed; ///< Rotational speeds.
+    vector<float> m_vRoll; ///< Orientations.
+
+    vector<float> m_vBirthTime; ///< Times of creation.
+    vector<float> m_vLifeSpan; ///< Times they will live for.
+
+    vector<float> m_vMaxScale; ///< Maximum scales.
+    vector<float> m_vScaleInFrac; ///< Fractions of life growing in.
+    vector<float> m_vScaleOutFrac; ///< Fractions of life shrinking out.
+    vector<float> m_vScale; ///< Current scales.
+
+    vector<float> m_vFadeInFrac; ///< Fractions of life fading in.
+    vector<float> m_vFadeOutFrac; ///< Fractions of life fading out.
+    vector<float> m_vAlpha; ///< Current alpha channels.
+
+    vector<float> m_vLifeFrac; ///< Fractions of life lived, filled in by the kernel.
+    ParticleKernelFn m_pKernel = nullptr; ///< Kernel used by the step function.
+    unsigned m_nFeatures = PARTICLE_ALL; ///< Mask of eParticleFeature flags the kernel handles.
+
+    void remove(size_t i); ///< Remove a particle.
+    template<class SPRITEDESC> void GetSpriteDesc(size_t i, SPRITEDESC& d); ///< Get a particle's sprite descriptor.
 
   public:
-    CParticleEngine(); ///< Constructor.
+    CParticleEngine(size_t capacity=DEFAULT_PARTICLE_CAPACITY,
+      unsigned features=PARTICLE_ALL); ///< Constructor.
     virtual ~CParticleEngine(); ///< Destructor.
     
     void create(const PARTICLEDESC& d); //< Create particle.
@@ -47,6 +85,7 @@ class CParticleEngine: public CComponent{
     void clear(int n); ///< Clear out a particular kind of particle. 
     
     void translate(const VECTOR& delta);
+    void SetKernel(eParticleKernel k); ///< Choose the kernel.
 }; //CParticleEngine
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -63,7 +102,8 @@ class CParticleEngine2D:
     CSpriteRenderer* m_pRenderer; ///< Pointer to a 2D renderer.
 
   public:
-    CParticleEngine2D(CSpriteRenderer* p); ///< Constructor.
+    CParticleEngine2D(CSpriteRenderer* p, size_t capacity=DEFAULT_PARTICLE_CAPACITY,
+      unsigned features=PARTICLE_ALL); ///< Constructor.
     void Draw(); ///< Draw particles.
 }; //CParticleEngine2D
 
@@ -0,0 +1,79 @@
+/// \file ParticleKernel.h
+/// \brief Interface for the particle step kernels.
+
+#pragma once
+
+#include <stddef.h>
+
+/// \brief Pointers to the particle pool's arrays.
+///
+/// Vector fields are stored as m_nDim floats per particle, one
+/// particle after the other, so that a Vector2 or Vector3 array
+/// can be handed over as it is. Everything else is one float
+/// per particle.
+
+struct ParticleStreams{
+  unsigned m_nDim = 2; ///< Number of floats in a vector.
+
+  float* m_pPos = nullptr; ///< Positions.
+  float* m_pVel = nullptr; ///< Velocities.
+  const float* m_pAccel = nullptr; ///< Accelerations.
+  const float* m_pFriction = nullptr; ///< Coefficients of friction.
+  const float* m_pRSpeed = nullptr; ///< Rotational speeds.
+  float* m_pRoll = nullptr; ///< Orientations.
+
+  const float* m_pBirthTime = nullptr; ///< Times of creation.
+  const float* m_pLifeSpan = nullptr; ///< Times they will live for.
+  float* m_pLifeFrac = nullptr; ///< [OUT] Fractions of life lived.
+
+  const float* m_pMaxScale = nullptr; ///< Maximum scales.
+  const float* m_pScaleInFrac = nullptr; ///< Fractions of life growing in.
+  const float* m_pScaleOutFrac = nullptr; ///< Fractions of life shrinking out.
+  float* m_pScale = nullptr; ///< Current scales.
+
+  const float* m_pFadeInFrac = nullptr; ///< Fractions of life fading in.
+  const float* m_pFadeOutFrac = nullptr; ///< Fractions of life fading out.
+  float* m_pAlpha = nullptr; ///< Current alpha channels.
+}; //ParticleStreams
+
+/// \brief Instruction set used by a particle kernel.
+
+enum class eParticleKernel{
+  SCALAR, SSE2, AVX2
+}; //eParticleKernel
+
+/// \brief Particle features.
+///
+/// Each feature is a stage of the particle step that can be compiled
+/// out of a kernel. A particle engine whose particles never use, say,
+/// friction or rotation can ask for a kernel without those stages.
+
+enum eParticleFeature{
+  PARTICLE_MOVE = 1, ///< Translate by velocity.
+  PARTICLE_ACCEL = 2, ///< Accelerate.
+  PARTICLE_FRICTION = 4, ///< Slow down by friction.
+  PARTICLE_SPIN = 8, ///< Rotate by rotational speed.
+  PARTICLE_SCALE = 16, ///< Scale in and out.
+  PARTICLE_FADE = 32, ///< Fade in and out.
+
+  PARTICLE_ALL = 63, ///< Everything.
+  PARTICLE_BASIC = PARTICLE_MOVE | PARTICLE_SCALE | PARTICLE_FADE, ///< Sprites that drift, scale, and fade, like sparks.
+  PARTICLE_STILL = PARTICLE_SCALE | PARTICLE_FADE ///< Sprites that stay put, scale, and fade, like puffs of smoke.
+}; //eParticleFeature
+
+/// \brief A particle step kernel.
+///
+/// Moves, rescales and fades n particles and writes the fraction of
+/// its life that each one has lived into m_pLifeFrac, leaving it to
+/// the caller to cull the ones that have reached 1.0f. The math is
+/// the same as CParticle's move, rescale, and fade, less any stages
+/// that the kernel was compiled without.
+/// \param s The particle arrays.
+/// \param n Number of particles.
+/// \param now Current time.
+/// \param t Frame time.
+
+typedef void (*ParticleKernelFn)(const ParticleStreams& s, size_t n, float now, float t);
+
+eParticleKernel GetBestParticleKernel(); ///< Best kernel that this CPU supports.
+ParticleKernelFn GetParticleKernel(eParticleKernel k, unsigned features=PARTICLE_ALL); ///< Get a kernel.
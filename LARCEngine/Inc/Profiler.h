@@ -0,0 +1,121 @@
+/// \file Profiler.h
+/// \brief Interface for the profiler CProfiler, its clock CProfileClock, and the PROFILE_SCOPE macro.
+
+#pragma once
+
+//#define PROFILE ///< Define this to compile in the PROFILE_SCOPE zones.
+
+#include <stdint.h>
+
+#include <chrono>
+
+using namespace std;
+
+/// \brief The profile clock.
+///
+/// The highest resolution clock available, which on Windows is the
+/// performance counter, read in nanoseconds. Anything that times
+/// itself should use this, so it is here whether PROFILE is defined
+/// or not.
+
+class CProfileClock{
+  public:
+    /// Get the time since the clock was first read.
+    /// \return Time in nanoseconds.
+
+    static int64_t now(){
+      static const chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+      return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count();
+    } //now
+}; //CProfileClock
+
+#ifdef PROFILE
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+const size_t PROFILE_BUFFER_SIZE = 1 << 16; ///< Zones kept for each thread, a power of two.
+const char DEFAULT_PROFILE_FILE[] = "profile.json"; ///< Default trace file name.
+
+/// \brief A profile zone.
+///
+/// A named span of time on one thread, recorded when it ends.
+
+struct CProfileZone{
+  const char* m_pName = nullptr; ///< Name, which must be a string literal.
+  int64_t m_nStart = 0; ///< Start time in nanoseconds.
+  int64_t m_nEnd = 0; ///< End time in nanoseconds.
+}; //CProfileZone
+
+/// \brief A ring buffer of profile zones for a single thread.
+///
+/// Only the thread that owns it writes to it, so no locking is needed
+/// to record a zone. When it is full the oldest zones are overwritten.
+
+struct CProfileBuffer{
+  vector<CProfileZone> m_vZones; ///< The ring buffer.
+  atomic<size_t> m_nCount{0}; ///< Number of zones ever recorded.
+  unsigned m_nThread = 0; ///< Thread number, in order of first zone recorded.
+}; //CProfileBuffer
+
+/// \brief The profiler.
+///
+/// The profiler records the zones made by PROFILE_SCOPE into a ring
+/// buffer for each thread, with times taken from the highest resolution
+/// clock available, CProfileClock, and saves the most recent ones as a Chrome trace
+/// that can be viewed in chrome://tracing or Perfetto. Everything here
+/// is compiled out unless PROFILE is defined, in which case
+/// PROFILE_SCOPE costs two reads of the clock and a store.
+
+class CProfiler{
+  private:
+    static mutex m_mutex; ///< Guards the list of buffers.
+    static vector<unique_ptr<CProfileBuffer>> m_vBuffers; ///< A buffer for each thread that has recorded a zone.
+    static thread_local CProfileBuffer* m_pBuffer; ///< This thread's buffer.
+
+    static CProfileBuffer* GetBuffer(); ///< Get this thread's buffer.
+
+  public:
+    static void record(const char* name, int64_t start, int64_t end); ///< Record a zone.
+
+    static bool Save(const char* filename=DEFAULT_PROFILE_FILE); ///< Save as a Chrome trace.
+    static void clear(); ///< Forget all zones.
+}; //CProfiler
+
+/// \brief A profile scope.
+///
+/// Times its own scope and records it as a zone when it goes out of
+/// scope. Use it through PROFILE_SCOPE rather than directly.
+
+class CProfileScope{
+  private:
+    const char* m_pName; ///< Zone name.
+    int64_t m_nStart; ///< Start time in nanoseconds.
+
+  public:
+    /// Start timing.
+    /// \param name Zone name, which must be a string literal.
+
+    CProfileScope(const char* name): m_pName(name), m_nStart(CProfileClock::now()){
+    } //constructor
+
+    /// Stop timing and record the zone.
+
+    ~CProfileScope(){
+      CProfiler::record(m_pName, m_nStart, CProfileClock::now());
+    } //destructor
+}; //CProfileScope
+
+#define PROFILE_CONCAT2(a, b) a##b ///< Paste tokens, after expanding them.
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b) ///< Paste tokens.
+
+/// Time the rest of the enclosing scope as a zone with the given name.
+#define PROFILE_SCOPE(name) CProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+
+#else //PROFILE
+
+#define PROFILE_SCOPE(name) ///< Compiled out.
+
+#endif //PROFILE
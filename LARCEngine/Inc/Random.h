@@ -10,18 +10,23 @@
 ///
 /// CRandom is a simple pseudorandom number generator based on
 /// xorshift128. It can be seeded with the time or, if reproducability
-/// is desired (eg. when debugging), with a fixed seed.
+/// is desired (eg. when debugging or replaying), with a fixed seed.
+/// The state depends only on the seed, so the same seed always gives
+/// the same sequence, whatever the platform.
 /// It has functions for generating pseudorandom unsigned integers,
 /// floats, unit-length vectors, and colors.
 
 class CRandom: public CComponent{
   private: 
     unsigned m_uState[4]; ///< Current state.
+    int m_nSeed = 0; ///< Last seed used.
 
   public:
     CRandom(); ///< Constructor.
 
     void srand(int seed=-1); ///< Seed the random number generator.
+    int GetSeed(); ///< Get the last seed used.
+    void GetState(unsigned state[4]); ///< Get the current state.
 
     unsigned randn(); ///< Get a random unsigned integer.
     unsigned randn(unsigned i, unsigned j); ///< Get random integer in \f$[i,j]\f$.
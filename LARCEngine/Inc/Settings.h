@@ -3,10 +3,12 @@
 
 #pragma once
 
-#include <Windows.h>
+#ifndef HEADLESS
+  #include <Windows.h>
+#endif //HEADLESS
 
 #include "tinyxml2.h"
-#include "defines.h"
+#include "Defines.h"
 
 using namespace tinyxml2;
 
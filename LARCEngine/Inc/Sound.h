@@ -3,6 +3,10 @@
 
 #pragma once
 
+#ifdef HEADLESS
+  #include "HeadlessAudio.h" //no XAudio2
+#else //HEADLESS
+
 #include <Audio.h>
 
 #include "Defines.h"
@@ -91,4 +95,6 @@ class CAudio:
 
     void SetListenerPos(const Vector2& pos); ///< Set the listener position.
     void SetPitch(int i, float f); ///< Set pitch of first instance of sound.
-}; //CAudio
\ No newline at end of file
+}; //CAudio
+
+#endif //HEADLESS
@@ -3,6 +3,10 @@
 
 #pragma once
 
+#ifdef HEADLESS
+  #include "HeadlessSpriteRenderer.h" //sprite sizes without Direct3D
+#else //HEADLESS
+
 #include "Sprite.h"
 #include "Renderer3D.h"
 
@@ -77,3 +81,5 @@ class CSpriteRenderer: public CRenderer3D{
     BoundingBox GetAabb(int n, int m); ///< Get bounding box.
     bool BoxInFrustum(const BoundingBox& box); ///< Does the box overlap the view frustum?
 }; //CSpriteRenderer
+
+#endif //HEADLESS
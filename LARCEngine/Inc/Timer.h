@@ -5,16 +5,22 @@
 
 #include "Defines.h"
 
+class CFrameArena;
+
 /// \brief The timer. 
 ///
 /// The timer allows you to manage game events by duration, rather than
 /// on a frame-by-frame basis. This simple version of the timer is based on
 /// the Windows API function timeGetTime, which is notoriously inaccurate
-/// but perfectly adequate for a simple game demo.
+/// but perfectly adequate for a simple game demo. If the timer is given
+/// a frame arena, it resets the arena at the start of each frame.
+/// The time can also be set by hand, for example to run the simulation
+/// headless as fast as it will go, in which case the clock is ignored.
 
 class CTimer{ 
   private:
     bool m_bStarted = false; ///< Whether timer has been started.
+    bool m_bManual = false; ///< Whether the time is set by hand instead of read from the clock.
 
     //time variables
     unsigned m_nStartTime = 0; ///< When timer was started, in milliseconds.
@@ -26,11 +32,13 @@ class CTimer{
     float m_fStartFrameRate = 0; ///< When frame rate counting for the current second began, in seconds.
     unsigned m_nFrameCount = 0; ///< Number of frames so far in this second.
 
+    CFrameArena* m_pFrameArena = nullptr; ///< Arena to reset each frame, if any.
+
   protected:
     void start(); ///< Start the timer.
 
   public:
-    CTimer(); ///< Constructor.
+    CTimer(CFrameArena* arena=nullptr); ///< Constructor.
     
     float time(); ///< Return the time in seconds at the start of the current frame.
     float actualtime(); ///< Return the time in seconds.
@@ -42,4 +50,7 @@ class CTimer{
 
     void BeginFrame(); ///< Beginning of frame.
     void EndFrame(); ///< End of frame.
+
+    void SetTime(float t); ///< Set the time by hand.
+    void SetFrameTime(float t); ///< Set the frame time by hand.
 }; //CTimer
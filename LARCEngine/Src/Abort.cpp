@@ -1,10 +1,16 @@
 /// \file abort.cpp
 /// \brief Code for aborting when something catastrophic goes wrong.
 
-#include "abort.h"
+#include "Abort.h"
 
 #include <stdio.h>
-#include <windows.h>
+
+#ifdef HEADLESS
+  #include <stdlib.h>
+  #include "Defines.h"
+#else //HEADLESS
+  #include <windows.h>
+#endif //HEADLESS
 
 /// \brief The real abort function.
 ///
@@ -14,10 +20,20 @@
 /// This allows an error message to be displayed in a dialog box (provided things 
 /// don't go TOO wrong) last thing on exit by calling the 
 /// ABORT macro anyplace in the code. The parameters to this function
-/// are identical to those of the stdio function printf.
+/// are identical to those of the stdio function printf. In a headless
+/// build, which has no window to put a dialog box in, the message goes
+/// to the console instead.
 /// \param fmt Printf style format string.
 
 void reallyAbort(_In_ const char *fmt, ...){ 
+#ifdef HEADLESS
+  va_list ap;
+  va_start(ap, fmt);
+  vfprintf(stderr, fmt, ap);
+  va_end(ap);
+  fputc('\n', stderr);
+  exit(1);
+#else //HEADLESS
   char buffer[1024];
 
   //format the error message into our buffer
@@ -27,12 +43,21 @@ void reallyAbort(_In_ const char *fmt, ...){
   va_end(ap);
   //flag the error so the app exits cleanly
   FatalAppExit(0, buffer); //this is the magic Windows API incantation to abort. Thanks, Bill Gates.
+#endif //HEADLESS
 } //reallyAbort
 
 /// \brief Wide character version of reallyAbort.
 /// \param fmt Printf style format string.
 
 void reallyAbortW(_In_ const wchar_t *fmt, ...){ 
+#ifdef HEADLESS
+  va_list ap;
+  va_start(ap, fmt);
+  vfwprintf(stderr, fmt, ap);
+  va_end(ap);
+  fputwc(L'\n', stderr);
+  exit(1);
+#else //HEADLESS
   wchar_t buffer[1024];
 
   //format the error message into our buffer
@@ -42,4 +67,5 @@ void reallyAbortW(_In_ const wchar_t *fmt, ...){
   va_end(ap);
   //flag the error so the app exits cleanly
   FatalAppExitW(0, buffer); //this is the magic Windows API incantation to abort. Thanks, Bill Gates.
+#endif //HEADLESS
 } //reallyAbort
\ No newline at end of file
@@ -2,22 +2,33 @@
 /// \brief Code for the component class CComponent.
 ///
 /// This file contains declarations for a timer, a PRNG, 
-/// an audio player, a keyboard handler, and
+/// an audio player, a keyboard handler, a frame arena, and
 /// two particle engines, which are then used to initialize 
 /// the corresponding static member variables of CComponent. 
 
 #include "ComponentIncludes.h"
 
 namespace{
-  static CTimer cTimer;
+  static CFrameArena cFrameArena; //before the timer, which resets it
+  static CTimer cTimer(&cFrameArena);
   static CRandom cRandom;
-  static CKeyboard cKeyboard;
-  static CXBoxController cController;
   static CAudio cAudio;
+
+  #ifndef HEADLESS
+    static CKeyboard cKeyboard;
+    static CXBoxController cController;
+  #endif //HEADLESS
 } //namespace
 
 CTimer* CComponent::m_pTimer = &cTimer;
 CRandom* CComponent::m_pRandom = &cRandom;
-CKeyboard* CComponent::m_pKeyboard = &cKeyboard;
-CXBoxController* CComponent::m_pController = &cController; 
 CAudio* CComponent::m_pAudio = &cAudio;
+
+#ifdef HEADLESS
+  CKeyboard* CComponent::m_pKeyboard = nullptr;
+  CXBoxController* CComponent::m_pController = nullptr;
+#else //HEADLESS
+  CKeyboard* CComponent::m_pKeyboard = &cKeyboard;
+  CXBoxController* CComponent::m_pController = &cController; 
+#endif //HEADLESS
+CFrameArena* CComponent::m_pFrameArena = &cFrameArena;
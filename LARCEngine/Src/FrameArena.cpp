@@ -0,0 +1,140 @@
+/// \file FrameArena.cpp
+/// \brief Code for the per-frame arena allocator CFrameArena.
+
+#include "Defines.h" //for OutputDebugStringA()
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "FrameArena.h"
+
+/// \brief Header of a heap block allocated when the buffer is full.
+
+struct FrameArenaBlock{
+  void* m_pNext; ///< Next block in the list.
+  max_align_t m_Align; ///< Makes sure what follows the header is aligned.
+}; //FrameArenaBlock
+
+/// Allocate the buffer. This is all of the memory that the
+/// arena needs unless a frame asks for more than it holds.
+/// \param size Size of the buffer in bytes.
+
+CFrameArena::CFrameArena(size_t size):
+  m_nSize(size)
+{
+  m_pBuffer = new unsigned char[size];
+} //constructor
+
+/// Free the buffer and anything allocated from the heap, and in debug
+/// builds report the high water mark so that the buffer size can be tuned.
+
+CFrameArena::~CFrameArena(){
+  reset();
+  delete [] m_pBuffer;
+
+  #ifdef _DEBUG
+    char buffer[128];
+    sprintf_s(buffer, "Frame arena high water mark %u of %u bytes\n",
+      (unsigned)m_nHighWater, (unsigned)m_nSize);
+    OutputDebugStringA(buffer);
+  #endif //_DEBUG
+} //destructor
+
+/// Allocate memory that lasts until the next reset. If there's
+/// no room left in the buffer then it comes from the heap.
+/// \param n Number of bytes.
+/// \param align Alignment, which must be a power of two.
+/// \return Pointer to the memory allocated.
+
+void* CFrameArena::allocate(size_t n, size_t align){
+  const uintptr_t base = (uintptr_t)m_pBuffer;
+  const uintptr_t p = (base + m_nUsed + align - 1) & ~(uintptr_t)(align - 1);
+  const size_t used = (size_t)(p - base) + n;
+
+  if(used <= m_nSize){ //fits in the buffer
+    m_nUsed = used;
+    return (void*)p;
+  } //if
+
+  //out of room, so fall back to the heap, allowing enough extra to
+  //align the memory after the header the same way as in the buffer
+
+  FrameArenaBlock* b = (FrameArenaBlock*)new unsigned char[sizeof(FrameArenaBlock) + n + align - 1];
+  b->m_pNext = m_pOverflow;
+  m_pOverflow = b;
+  m_nOverflowBytes += n;
+
+  const uintptr_t q = (uintptr_t)&b->m_Align;
+  return (void*)((q + align - 1) & ~(uintptr_t)(align - 1));
+} //allocate
+
+/// Make a string with printf style formatting, for example for text
+/// to be drawn this frame.
+/// \param fmt Format string.
+/// \return The formatted string, which lasts until the next reset.
+
+const char* CFrameArena::format(const char* fmt, ...){
+  va_list args;
+
+  va_start(args, fmt);
+  const int n = vsnprintf(nullptr, 0, fmt, args);
+  va_end(args);
+
+  if(n < 0)return "";
+
+  char* s = (char*)allocate(n + 1, 1);
+
+  va_start(args, fmt);
+  vsnprintf(s, n + 1, fmt, args);
+  va_end(args);
+
+  return s;
+} //format
+
+/// Free everything allocated since the last reset. This is called by
+/// the timer at the start of each frame. In Debug mode the memory freed
+/// is poisoned, and a new high water mark is reported.
+
+void CFrameArena::reset(){
+  const size_t total = m_nUsed + m_nOverflowBytes;
+
+  if(total > m_nHighWater)
+    m_nHighWater = total;
+
+  #ifdef _DEBUG
+    memset(m_pBuffer, FRAME_ARENA_POISON, m_nUsed);
+
+    if(m_nHighWater > m_nSize && m_nHighWater > m_nReported){
+      char buffer[128];
+      sprintf_s(buffer, "Frame arena overflowed: %u of %u bytes used in one frame\n",
+        (unsigned)m_nHighWater, (unsigned)m_nSize);
+      OutputDebugStringA(buffer);
+      m_nReported = m_nHighWater;
+    } //if
+  #endif //_DEBUG
+
+  while(m_pOverflow){ //free the heap blocks
+    FrameArenaBlock* b = (FrameArenaBlock*)m_pOverflow;
+    m_pOverflow = b->m_pNext;
+    delete [] (unsigned char*)b;
+  } //while
+
+  m_nUsed = 0;
+  m_nOverflowBytes = 0;
+} //reset
+
+/// Reader function for the number of bytes allocated this frame.
+/// \return Number of bytes allocated since the last reset.
+
+size_t CFrameArena::GetUsed(){
+  return m_nUsed + m_nOverflowBytes;
+} //GetUsed
+
+/// Reader function for the high water mark.
+/// \return Most bytes used in any one frame so far.
+
+size_t CFrameArena::GetHighWaterMark(){
+  return m_nHighWater;
+} //GetHighWaterMark
@@ -0,0 +1,230 @@
+/// \file HeadlessSpriteRenderer.cpp
+/// \brief Code for the sprite renderer used in headless builds.
+
+#include "SpriteRenderer.h"
+#include "Abort.h"
+
+#include <string>
+
+/// Read a big-endian 32-bit unsigned integer.
+/// \param p Pointer to the first of 4 bytes.
+/// \return The integer.
+
+static unsigned ReadBigEndian(const unsigned char* p){
+  return (unsigned)p[0] << 24 | (unsigned)p[1] << 16 | (unsigned)p[2] << 8 | p[3];
+} //ReadBigEndian
+
+/// Read a little-endian 32-bit unsigned integer.
+/// \param p Pointer to the first of 4 bytes.
+/// \return The integer.
+
+static unsigned ReadLittleEndian(const unsigned char* p){
+  return (unsigned)p[3] << 24 | (unsigned)p[2] << 16 | (unsigned)p[1] << 8 | p[0];
+} //ReadLittleEndian
+
+/// Get the width and height of an image from its header without
+/// loading it. PNG and DDS files are understood.
+/// \param filename Name of the image file.
+/// \param w [OUT] Width in pixels.
+/// \param h [OUT] Height in pixels.
+/// \return true if the file exists and its size could be read.
+
+static bool GetImageSize(const char* filename, unsigned& w, unsigned& h){
+  FILE* input = nullptr;
+  fopen_s(&input, filename, "rb");
+  if(input == nullptr)return false;
+
+  unsigned char header[24]; //enough for a PNG IHDR chunk or the start of a DDS header
+  const size_t n = fread(header, 1, sizeof(header), input);
+  fclose(input);
+
+  if(n < sizeof(header))return false;
+
+  if(memcmp(header, "\x89PNG", 4) == 0){ //IHDR chunk comes first
+    w = ReadBigEndian(header + 16);
+    h = ReadBigEndian(header + 20);
+    return true;
+  } //if
+
+  if(memcmp(header, "DDS ", 4) == 0){ //height comes before width
+    h = ReadLittleEndian(header + 12);
+    w = ReadLittleEndian(header + 16);
+    return true;
+  } //if
+
+  return false;
+} //GetImageSize
+
+/// Put the camera in the middle of the window, as the real renderer does.
+/// \param mode Sprite render mode.
+
+CSpriteRenderer::CSpriteRenderer(eRenderMode mode):
+  m_eRenderMode(mode),
+  m_vCameraPos(m_vWinCenter.x, m_vWinCenter.y, 0.0f){
+} //constructor
+
+/// Delete the sprites.
+
+CSpriteRenderer::~CSpriteRenderer(){
+  for(size_t i=0; i<m_nNumSprites; i++)
+    delete m_pSprite[i];
+
+  delete [] m_pSprite;
+} //destructor
+
+/// Reserve space for the sprites.
+/// \param n Number of sprites.
+
+void CSpriteRenderer::Initialize(size_t n){
+  m_nNumSprites = n;
+  m_pSprite = new CSprite*[n];
+
+  for(size_t i=0; i<n; i++)
+    m_pSprite[i] = nullptr;
+} //Initialize
+
+/// Make a sprite and read the size of each of its frames from the
+/// image file headers.
+/// \param index Sprite index.
+/// \param file File name prefix.
+/// \param ext File name extension, or nullptr for a single frame.
+/// \param frames Number of frames.
+/// \return Pointer to the sprite, or nullptr if a frame's size can't be read.
+
+CSprite* CSpriteRenderer::Load(unsigned index, const char* file, const char* ext, int frames){
+  m_pSprite[index] = new CSprite(frames);
+
+  for(int i=0; i<frames; i++){ //for each frame
+    const string s = ext? file + to_string(i) + "." + ext: string(file);
+    CTextureDesc& t = m_pSprite[index]->GetTextureDesc(i);
+
+    if(!GetImageSize(s.c_str(), t.m_nWidth, t.m_nHeight))
+      return nullptr;
+  } //for
+
+  return m_pSprite[index]; 
+} //Load
+
+/// Load the size of a sprite using the information in g_xmlSettings.
+/// Sizes given in the sprite tag win, otherwise they are read from
+/// the image files, which are expected to be where gamesettings.xml
+/// says. Abort if something goes wrong.
+/// \param index Sprite index.
+/// \param name Object name in XML file.
+
+void CSpriteRenderer::Load(unsigned index, const char* name){
+  if(m_pXmlSettings == nullptr)
+    ABORT("Cannot access gamesettings.xml.");
+
+  XMLElement* pSpritesTag = m_pXmlSettings->FirstChildElement("sprites"); //sprites tag
+
+  if(pSpritesTag == nullptr)
+    ABORT("Cannot find <sprites> tag in gamesettings.xml");
+
+  string path(pSpritesTag->Attribute("path")); //get path
+
+  XMLElement* pSpriteTag = pSpritesTag->FirstChildElement("sprite");
+
+  while(pSpriteTag != nullptr && strcmp(name, pSpriteTag->Attribute("name")))
+    pSpriteTag = pSpriteTag->NextSiblingElement("sprite");
+
+  CSprite* pSprite = nullptr;
+
+  if(pSpriteTag != nullptr){ //got <sprite> tag with right name
+    const int frames = max(1, pSpriteTag->IntAttribute("frames"));
+    const unsigned w = pSpriteTag->UnsignedAttribute("width");
+    const unsigned h = pSpriteTag->UnsignedAttribute("height");
+
+    if(w > 0 && h > 0){ //size given, no need for the image
+      pSprite = m_pSprite[index] = new CSprite(frames);
+
+      for(int i=0; i<frames; i++){
+        pSprite->GetTextureDesc(i).m_nWidth = w;
+        pSprite->GetTextureDesc(i).m_nHeight = h;
+      } //for
+    } //if
+
+    else{ //read it from the image, with slashes that work everywhere
+      string file = path + "/" + pSpriteTag->Attribute("file");
+      replace(file.begin(), file.end(), '\\', '/');
+
+      pSprite = Load(index, file.c_str(), pSpriteTag->Attribute("ext"), frames);
+    } //else
+  } //if
+
+  if(pSprite == nullptr)
+    ABORT("Cannot load sprite \"%s\".\n", name);
+} //Load
+
+/// \param pos New camera position.
+
+void CSpriteRenderer::SetCameraPos(const Vector3& pos){
+  m_vCameraPos = pos;
+} //SetCameraPos
+
+/// \return Camera position.
+
+const Vector3& CSpriteRenderer::GetCameraPos(){
+  return m_vCameraPos;
+} //GetCameraPos
+
+/// Reader function for number of frames in sprite.
+/// \param n Sprite index.
+/// \return Number of frames in sprite.
+
+size_t CSpriteRenderer::GetNumFrames(unsigned n){
+  return m_pSprite[n]? m_pSprite[n]->GetNumFrames(): 0;
+} //GetNumFrames
+
+/// Construct the AABB for a sprite frame.
+/// \param n Sprite index.
+/// \param m Frame number.
+/// \return AABB for sprite frame.
+
+BoundingBox CSpriteRenderer::GetAabb(int n, int m){
+  BoundingBox aabb;
+  aabb.Center = Vector3::Zero;
+
+  Vector3 v = Vector3(0.0f, 0.0f, 0.001f);
+  GetSize(n, m, v.x, v.y);
+  aabb.Extents = v;
+
+  return aabb;
+} //GetAabb
+
+/// Reader function for the width and height of frame zero of a sprite.
+/// \param n [in] Sprite index, assumed to be in range.
+/// \param x [out] Width of frame in pixels.
+/// \param y [out] Height of frame in pixels.
+
+void CSpriteRenderer::GetSize(unsigned n, float& x, float& y){
+  return GetSize(n, 0, x, y);
+} //GetSize
+
+/// Reader function for the width and height of a sprite frame.
+/// \param n [in] Sprite index, assumed to be in range.
+/// \param m [in] Frame number, assumed to be in range.
+/// \param x [out] Width of frame in pixels.
+/// \param y [out] Height of frame in pixels.
+
+void CSpriteRenderer::GetSize(unsigned n, unsigned m, float& x, float& y){
+  if(m_pSprite[n] == nullptr)
+    x = y = 0;
+  else m_pSprite[n]->GetSize(m, x, y);
+} //GetSize
+
+/// Reader function for the height of frame zero of a sprite.
+/// \param n Sprite index, assumed to be in range.
+/// \return Height in pixels.
+
+float CSpriteRenderer::GetHeight(unsigned n){
+  return m_pSprite[n]? m_pSprite[n]->GetHeight(): 0;
+} //GetHeight
+
+/// Reader function for the width of frame zero of a sprite.
+/// \param n Sprite index, assumed to be in range.
+/// \return Width in pixels.
+
+float CSpriteRenderer::GetWidth(unsigned n){
+  return m_pSprite[n]? m_pSprite[n]->GetWidth(): 0;
+} //GetWidth
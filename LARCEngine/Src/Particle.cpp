@@ -34,13 +34,8 @@ template<T0> void CParticle<T1>::move(float t){
 /// \param f Fraction of lifespan lived, from 0.0f to 1.0f inclusive.
 
 template<T0> void CParticle<T1>::rescale(float f){
-  float fScale = CParticle<T1>::m_fMaxScale; //initial scale
-
-  if(f < CParticle<T1>::m_fScaleInFrac) //growing in
-    fScale *= f/CParticle<T1>::m_fScaleInFrac;
-
-  if(f > 1.0f - CParticle<T1>::m_fScaleOutFrac) //shrinking out
-    fScale *= (1.0f - f)/CParticle<T1>::m_fScaleOutFrac;
+  const float fScale = GetParticleScale(f, CParticle<T1>::m_fMaxScale,
+    CParticle<T1>::m_fScaleInFrac, CParticle<T1>::m_fScaleOutFrac);
 
   CParticle<T1>::m_fXScale = CParticle<T1>::m_fYScale = fScale; //scale both directions
 } //rescale
@@ -49,11 +44,8 @@ template<T0> void CParticle<T1>::rescale(float f){
 /// \param f Fraction of lifespan lived, from 0.0f to 1.0f inclusive.
 
 template<T0> void CParticle<T1>::fade(float f){
-  if(f < CParticle<T1>::m_fFadeInFrac) //fading in
-    CParticle<T1>::m_fAlpha = f/CParticle<T1>::m_fFadeInFrac;
-
-  if(f > 1.0f - CParticle<T1>::m_fFadeOutFrac) //fading out
-    CParticle<T1>::m_fAlpha = (1.0f - f)/CParticle<T1>::m_fFadeOutFrac;
+  CParticle<T1>::m_fAlpha = GetParticleAlpha(f, CParticle<T1>::m_fAlpha,
+    CParticle<T1>::m_fFadeInFrac, CParticle<T1>::m_fFadeOutFrac);
 } //fade
 
 /// Move particle by a given distance and direction.
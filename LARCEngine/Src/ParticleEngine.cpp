@@ -4,28 +4,60 @@
 #include "Helpers.h"
 #include "ParticleEngine.h"
 #include "Particle.h"
+#include "Profiler.h"
 
 #define T0 class PARTICLE, class PARTICLEDESC, class VECTOR ///< Abbreviation.
 #define T1 PARTICLE, PARTICLEDESC, VECTOR ///< Abbreviation.
 
-template<T0> CParticleEngine<T1>::CParticleEngine(){
+/// Allocate the particle pool. All of the memory that the particle
+/// engine will ever need is allocated here.
+/// \param capacity Maximum number of particles.
+/// \param features Mask of eParticleFeature flags for the things
+/// particles do. Anything left out is compiled out of the kernel.
+
+template<T0> CParticleEngine<T1>::CParticleEngine(size_t capacity, unsigned features):
+  m_nCapacity(capacity), m_nFeatures(features)
+{
+  m_vDesc.resize(capacity);
+
+  m_vPos.resize(capacity);
+  m_vVel.resize(capacity);
+  m_vAccel.resize(capacity);
+  m_vFriction.resize(capacity);
+  m_vRSpeed.resize(capacity);
+  m_vRoll.resize(capacity);
+
+  m_vBirthTime.resize(capacity);
+  m_vLifeSpan.resize(capacity);
+
+  m_vMaxScale.resize(capacity);
+  m_vScaleInFrac.resize(capacity);
+  m_vScaleOutFrac.resize(capacity);
+  m_vScale.resize(capacity);
+
+  m_vFadeInFrac.resize(capacity);
+  m_vFadeOutFrac.resize(capacity);
+  m_vAlpha.resize(capacity);
+
+  m_vLifeFrac.resize(capacity);
+  SetKernel(GetBestParticleKernel());
 } //constructor
 
 template<T0> CParticleEngine<T1>::~CParticleEngine(){
-  for(auto const& p: m_stdList)
-    delete p;
 } //destructor
 
 /// Pre-emptively trigger scale out of all particles of a given type.
 /// \param n Sprite type of particle to be cleared.
 
 template<T0> void CParticleEngine<T1>::clear(int n){
-  for(auto const& p: m_stdList) //for each particle
-    if(p->m_nSpriteIndex == n){ //if this is the droid we are looking for
-      p->m_fBirthTime = m_pTimer->time(); 
-      p->m_fLifeSpan *= p->m_fScaleOutFrac; 
-      p->m_fScaleInFrac = 0.0f;
-      p->m_fScaleOutFrac = 1.0f;
+  const float t = m_pTimer->time();
+
+  for(size_t i=0; i<m_nCount; i++) //for each particle
+    if(m_vDesc[i].m_nSpriteIndex == n){ //if this is the droid we are looking for
+      m_vBirthTime[i] = t; 
+      m_vLifeSpan[i] *= m_vScaleOutFrac[i]; 
+      m_vScaleInFrac[i] = 0.0f;
+      m_vScaleOutFrac[i] = 1.0f;
     } //if
 } //clear
 
@@ -33,88 +65,152 @@ template<T0> void CParticleEngine<T1>::clear(int n){
 /// \param t Time over which to fade out.
 
 template<T0> void CParticleEngine<T1>::clear(float t){
-  for(auto const& p: m_stdList){ //for each particle
-    p->m_fBirthTime = m_pTimer->time(); 
-    p->m_fLifeSpan = t; 
-    p->m_fFadeInFrac = 0.0f;
-    p->m_fFadeOutFrac = 1.0f;
+  const float now = m_pTimer->time();
+
+  for(size_t i=0; i<m_nCount; i++){ //for each particle
+    m_vBirthTime[i] = now; 
+    m_vLifeSpan[i] = t; 
+    m_vFadeInFrac[i] = 0.0f;
+    m_vFadeOutFrac[i] = 1.0f;
   } //for
 } //clear
 
-/// Create a particle given its particle descriptor.
+/// Create a particle given its particle descriptor. If the pool
+/// is full then the particle is quietly dropped.
 /// \param d Particle descriptor.
 
 template<T0> void CParticleEngine<T1>::create(const PARTICLEDESC& d){
-  PARTICLE* p = new PARTICLE(d, m_pTimer->time()); //create new particle
-  p->rescale(0.0f); //scale it correctly 
-  m_stdList.push_back(p);
+  if(m_nCount >= m_nCapacity)return; //no room
+
+  const size_t i = m_nCount++;
+
+  m_vDesc[i] = d;
+
+  m_vPos[i] = d.m_vPos;
+  m_vVel[i] = d.m_vVel;
+  m_vAccel[i] = d.m_vAccel;
+  m_vFriction[i] = d.m_fFriction;
+  m_vRSpeed[i] = d.m_fRSpeed;
+  m_vRoll[i] = d.m_fRoll;
+
+  m_vBirthTime[i] = m_pTimer->time();
+  m_vLifeSpan[i] = d.m_fLifeSpan;
+
+  m_vMaxScale[i] = d.m_fMaxScale;
+  m_vScaleInFrac[i] = d.m_fScaleInFrac;
+  m_vScaleOutFrac[i] = d.m_fScaleOutFrac;
+  m_vScale[i] = (m_nFeatures & PARTICLE_SCALE)? //scale it correctly
+    GetParticleScale(0.0f, d.m_fMaxScale, d.m_fScaleInFrac, d.m_fScaleOutFrac): d.m_fMaxScale;
+
+  m_vFadeInFrac[i] = d.m_fFadeInFrac;
+  m_vFadeOutFrac[i] = d.m_fFadeOutFrac;
+  m_vAlpha[i] = d.m_fAlpha;
 } //create
 
-/// Get the remaining fraction of a particle's lifespan.
-/// \param p Pointer to a particle.
-/// \return Particle's age as a float between 0.0f and 1.0f.
+/// Remove a particle from the pool by moving the last
+/// live particle into its place.
+/// \param i Index of particle to be removed.
+
+template<T0> void CParticleEngine<T1>::remove(size_t i){
+  const size_t j = --m_nCount; //index of last particle
+  if(i == j)return;
+
+  m_vDesc[i] = m_vDesc[j];
+
+  m_vPos[i] = m_vPos[j];
+  m_vVel[i] = m_vVel[j];
+  m_vAccel[i] = m_vAccel[j];
+  m_vFriction[i] = m_vFriction[j];
+  m_vRSpeed[i] = m_vRSpeed[j];
+  m_vRoll[i] = m_vRoll[j];
+
+  m_vBirthTime[i] = m_vBirthTime[j];
+  m_vLifeSpan[i] = m_vLifeSpan[j];
 
-template<T0> float CParticleEngine<T1>::GetLifeFraction(const PARTICLE* p){
-  const float age = m_pTimer->time() - p->m_fBirthTime;
-  return clamp(0.0f, age/p->m_fLifeSpan, 1.0f);
-} //GetLifeFraction
+  m_vMaxScale[i] = m_vMaxScale[j];
+  m_vScaleInFrac[i] = m_vScaleInFrac[j];
+  m_vScaleOutFrac[i] = m_vScaleOutFrac[j];
+  m_vScale[i] = m_vScale[j];
 
-/// Move all particles, cull any that have exceeded their lifespan,
-/// and recompute the scale and transparency of the ones remaining.
+  m_vFadeInFrac[i] = m_vFadeInFrac[j];
+  m_vFadeOutFrac[i] = m_vFadeOutFrac[j];
+  m_vAlpha[i] = m_vAlpha[j];
+
+  m_vLifeFrac[i] = m_vLifeFrac[j];
+} //remove
+
+/// Move, rescale and fade all particles using the kernel, then cull
+/// any that have reached the end of their lifespan. This takes two
+/// passes. Culling inside the kernel would stop it handling particles
+/// a SIMD register at a time, and culling each block straight after
+/// the kernel has been through it measured no faster.
 
 template<T0> void CParticleEngine<T1>::step(){
-  move(); //move all particles
-  cull(); //cull the dead ones
-  rescale(); //rescale the remainder
-  fade(); //fade out
-} //step
+  PROFILE_SCOPE("CParticleEngine::step");
 
-/// Move all particles in the particle list.
+  ParticleStreams s;
+  s.m_nDim = sizeof(VECTOR)/sizeof(float);
 
-template<T0> void CParticleEngine<T1>::move(){ 
-  for(auto const& p: m_stdList)
-    p->move(m_pTimer->frametime()); 
-} //move
+  s.m_pPos = (float*)m_vPos.data();
+  s.m_pVel = (float*)m_vVel.data();
+  s.m_pAccel = (const float*)m_vAccel.data();
+  s.m_pFriction = m_vFriction.data();
+  s.m_pRSpeed = m_vRSpeed.data();
+  s.m_pRoll = m_vRoll.data();
 
-/// Remove from the particle list and delete those
-/// particles that have reached or exceeded their lifespan.
+  s.m_pBirthTime = m_vBirthTime.data();
+  s.m_pLifeSpan = m_vLifeSpan.data();
+  s.m_pLifeFrac = m_vLifeFrac.data();
 
-template<T0> void CParticleEngine<T1>::cull(){ 
-  for(auto i=m_stdList.begin(); i!=m_stdList.end();)
-    if(GetLifeFraction(*i) < 1.0f) //not dead
-      ++i; //next particle
-    else{ //"He's dead, Dave." --- Holly, from Red Dwarf
-      delete *i; //delete particle
-      i = m_stdList.erase(i); //remove from particle  list
-    } //else
-} //cull
+  s.m_pMaxScale = m_vMaxScale.data();
+  s.m_pScaleInFrac = m_vScaleInFrac.data();
+  s.m_pScaleOutFrac = m_vScaleOutFrac.data();
+  s.m_pScale = m_vScale.data();
 
-/// Rescale all of the particles in the particle list
-/// according to how much of their lifespans they have
-/// lived up to this point.
+  s.m_pFadeInFrac = m_vFadeInFrac.data();
+  s.m_pFadeOutFrac = m_vFadeOutFrac.data();
+  s.m_pAlpha = m_vAlpha.data();
 
-template<T0> void CParticleEngine<T1>::rescale(){ 
-  for(auto const& p: m_stdList)
-    p->rescale(GetLifeFraction(p)); 
-} //rescale
+  m_pKernel(s, m_nCount, m_pTimer->time(), m_pTimer->frametime());
+
+  for(size_t i=0; i<m_nCount;)
+    if(m_vLifeFrac[i] < 1.0f) //not dead
+      i++; //next particle
+    else remove(i); //"He's dead, Dave." --- Holly, from Red Dwarf
+} //step
 
-/// Fade out all particles in the particle list
-/// according to how much of their lifespans they have
-/// lived up to this point.
+/// Choose which kernel the step function uses, for example to compare
+/// the SIMD kernels against the scalar one. The kernel is specialized
+/// for the features given to the constructor.
+/// \param k Instruction set, which the CPU must support.
 
-template<T0> void CParticleEngine<T1>::fade(){ 
-  for(auto const& p: m_stdList)
-    p->fade(GetLifeFraction(p)); 
-} //fade
+template<T0> void CParticleEngine<T1>::SetKernel(eParticleKernel k){
+  m_pKernel = GetParticleKernel(k, m_nFeatures);
+} //SetKernel
 
 /// Translate all particles simultaneously by the same amount.
 /// \param delta Translation amount.
 
 template<T0> void CParticleEngine<T1>::translate(const VECTOR& delta){ 
-  for(auto const& p: m_stdList)
-    p->translate(delta); 
+  for(size_t i=0; i<m_nCount; i++)
+    m_vPos[i] += delta; 
 } //translate
 
+/// Get the sprite descriptor for a particle, which is the sprite
+/// descriptor it was created with with the fields that change
+/// brought up to date.
+/// \param i Index of particle.
+/// \param d [OUT] Sprite descriptor.
+
+template<T0> template<class SPRITEDESC>
+void CParticleEngine<T1>::GetSpriteDesc(size_t i, SPRITEDESC& d){
+  d = m_vDesc[i];
+  d.m_vPos = m_vPos[i];
+  d.m_fRoll = m_vRoll[i];
+  d.m_fXScale = d.m_fYScale = m_vScale[i];
+  d.m_fAlpha = m_vAlpha[i];
+} //GetSpriteDesc
+
 //explicit template instantiations
 
 template class CParticleEngine<CParticle2D, CParticleDesc2D, Vector2>;
@@ -125,16 +221,23 @@ template class CParticleEngine<CParticle3D, CParticleDesc3D, Vector3>;
 /// Save a pointer to the 2D renderer so that particles
 /// can be drawn on command.
 /// \param p Pointer to the 2D renderer.
+/// \param capacity Maximum number of particles.
+/// \param features Mask of eParticleFeature flags.
 
-CParticleEngine2D::CParticleEngine2D(CSpriteRenderer* p):
+CParticleEngine2D::CParticleEngine2D(CSpriteRenderer* p, size_t capacity, unsigned features):
+  CParticleEngine(capacity, features),
   m_pRenderer(p){
 } //constructor
 
 /// Draw all particles using the 2D renderer supplied in the constructor.
 
 void CParticleEngine2D::Draw(){
-  for(auto const& p: m_stdList) //for each object
-    m_pRenderer->Draw((CSpriteDesc2D)*p); //append to render list
+  CSpriteDesc2D d;
+
+  for(size_t i=0; i<m_nCount; i++){ //for each particle
+    GetSpriteDesc(i, d);
+    m_pRenderer->Draw(d); //append to render list
+  } //for
 } //Draw
     
 /////////////////////////////////////////////////////////////////////////////////////
@@ -144,6 +247,10 @@ void CParticleEngine2D::Draw(){
 /// \param renderlist A vector of 3D sprite descriptors.
 
 void CParticleEngine3D::GetRenderList(vector<CSpriteDesc3D>& renderlist){
-  for(auto const& p: m_stdList) //for each object
-    renderlist.push_back(*(CSpriteDesc3D*)p); //append to render list
+  CSpriteDesc3D d;
+
+  for(size_t i=0; i<m_nCount; i++){ //for each particle
+    GetSpriteDesc(i, d);
+    renderlist.push_back(d); //append to render list
+  } //for
 } //GetRenderList
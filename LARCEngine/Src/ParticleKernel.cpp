@@ -0,0 +1,410 @@
+/// \file ParticleKernel.cpp
+/// \brief Code for the particle step kernels.
+///
+/// The SIMD kernels do exactly the same arithmetic as the scalar one,
+/// in the same order, so they agree with it to within rounding. The
+/// "if" statements in GetParticleScale and GetParticleAlpha become
+/// compare-and-select so that every lane runs the same instructions.
+/// The vector fields are only vectorized for 2D particles, since then
+/// 4 particles fill exactly two SSE registers, and 8 particles fill
+/// exactly two AVX registers. Anything else falls back to a scalar
+/// loop for the vector fields only.
+///
+/// Every kernel is a template on a mask of eParticleFeature flags.
+/// The tests on the mask are constant, so the compiler drops the
+/// stages that aren't wanted, and the loads and stores that go with
+/// them. GetParticleKernel picks the instantiation at run time.
+
+#include "ParticleKernel.h"
+#include "Particle.h"
+
+#include <algorithm>
+#include <utility>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+  #define PARTICLE_KERNEL_X86 ///< Have SSE2 and maybe AVX2.
+  #include <immintrin.h>
+
+  #ifdef _MSC_VER
+    #include <intrin.h>
+    #define TARGET_AVX2 ///< MSVC doesn't need permission to use AVX2 intrinsics.
+  #else
+    #include <cpuid.h>
+    #define TARGET_AVX2 __attribute__((target("avx2"))) ///< Allow AVX2 in this function only.
+  #endif
+#endif
+
+#define VELOCITY_FEATURES (PARTICLE_MOVE | PARTICLE_ACCEL | PARTICLE_FRICTION) ///< Features that need the velocity.
+
+/// Move the vector fields of a range of particles.
+/// \tparam F Feature mask.
+/// \param s The particle arrays.
+/// \param i0 Index of first particle.
+/// \param i1 One past the index of the last particle.
+/// \param t Frame time.
+
+template<unsigned F> static void MoveVectors(const ParticleStreams& s, size_t i0, size_t i1, float t){
+  if(!(F & VELOCITY_FEATURES))return;
+
+  const unsigned d = s.m_nDim;
+  const float accel = t*100.0f;
+
+  for(size_t i=i0; i<i1; i++){
+    const float k = (F & PARTICLE_FRICTION)? 1.0f - t*s.m_pFriction[i]: 1.0f;
+
+    for(size_t j=i*d; j<(i + 1)*d; j++){
+      if(F & PARTICLE_MOVE)s.m_pPos[j] += t*s.m_pVel[j]; //translate
+      if(F & PARTICLE_ACCEL)s.m_pVel[j] += accel*s.m_pAccel[j]; //accelerate
+      if(F & PARTICLE_FRICTION)s.m_pVel[j] *= k; //friction
+    } //for
+  } //for
+} //MoveVectors
+
+/// Step a range of particles one at a time.
+/// \tparam F Feature mask.
+/// \param s The particle arrays.
+/// \param i0 Index of first particle.
+/// \param i1 One past the index of the last particle.
+/// \param now Current time.
+/// \param t Frame time.
+
+template<unsigned F> static void StepRange(const ParticleStreams& s, size_t i0, size_t i1, float now, float t){
+  const float spin = t*XM_2PI;
+
+  MoveVectors<F>(s, i0, i1, t);
+
+  for(size_t i=i0; i<i1; i++){
+    const float f = std::max(0.0f, (now - s.m_pBirthTime[i])/s.m_pLifeSpan[i]);
+    s.m_pLifeFrac[i] = f;
+
+    if(F & PARTICLE_SPIN)
+      s.m_pRoll[i] += spin*s.m_pRSpeed[i]; //rotate
+
+    if(F & PARTICLE_SCALE)
+      s.m_pScale[i] = GetParticleScale(f, s.m_pMaxScale[i],
+        s.m_pScaleInFrac[i], s.m_pScaleOutFrac[i]);
+
+    if(F & PARTICLE_FADE)
+      s.m_pAlpha[i] = GetParticleAlpha(f, s.m_pAlpha[i],
+        s.m_pFadeInFrac[i], s.m_pFadeOutFrac[i]);
+  } //for
+} //StepRange
+
+/// The scalar kernel.
+/// \tparam F Feature mask.
+/// \param s The particle arrays.
+/// \param n Number of particles.
+/// \param now Current time.
+/// \param t Frame time.
+
+template<unsigned F> static void StepParticlesScalar(const ParticleStreams& s, size_t n, float now, float t){
+  StepRange<F>(s, 0, n, now, t);
+} //StepParticlesScalar
+
+#ifdef PARTICLE_KERNEL_X86
+
+/// Select from two SSE registers without SSE4.1's blendv.
+/// \param mask Lanes that are all ones select a, all zeros select b.
+/// \param a First register.
+/// \param b Second register.
+/// \return The selected lanes.
+
+static inline __m128 Select(__m128 mask, __m128 a, __m128 b){
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+} //Select
+
+/// The SSE2 kernel, which does 4 particles at a time.
+/// \tparam F Feature mask.
+/// \param s The particle arrays.
+/// \param n Number of particles.
+/// \param now Current time.
+/// \param t Frame time.
+
+template<unsigned F> static void StepParticlesSSE2(const ParticleStreams& s, size_t n, float now, float t){
+  const __m128 vZero = _mm_setzero_ps();
+  const __m128 vOne = _mm_set1_ps(1.0f);
+  const __m128 vNow = _mm_set1_ps(now);
+  const __m128 vT = _mm_set1_ps(t);
+  const __m128 vAccel = _mm_set1_ps(t*100.0f);
+  const __m128 vSpin = _mm_set1_ps(t*XM_2PI);
+
+  size_t i = 0;
+
+  for(; i + 4 <= n; i += 4){
+    //life fraction
+
+    const __m128 f = _mm_max_ps(_mm_div_ps(_mm_sub_ps(vNow,
+      _mm_loadu_ps(s.m_pBirthTime + i)), _mm_loadu_ps(s.m_pLifeSpan + i)), vZero);
+    _mm_storeu_ps(s.m_pLifeFrac + i, f);
+
+    //move
+
+    if(F & VELOCITY_FEATURES){
+      if(s.m_nDim == 2){
+        __m128 kk[2] = {vOne, vOne}; //friction, one per float
+
+        if(F & PARTICLE_FRICTION){
+          const __m128 k = _mm_sub_ps(vOne, _mm_mul_ps(vT, _mm_loadu_ps(s.m_pFriction + i)));
+          kk[0] = _mm_unpacklo_ps(k, k);
+          kk[1] = _mm_unpackhi_ps(k, k);
+        } //if
+
+        for(int h=0; h<2; h++){
+          float* pPos = s.m_pPos + 2*i + 4*h;
+          float* pVel = s.m_pVel + 2*i + 4*h;
+
+          __m128 v = _mm_loadu_ps(pVel);
+
+          if(F & PARTICLE_MOVE)
+            _mm_storeu_ps(pPos, _mm_add_ps(_mm_loadu_ps(pPos), _mm_mul_ps(vT, v)));
+
+          if(F & PARTICLE_ACCEL)
+            v = _mm_add_ps(v, _mm_mul_ps(vAccel, _mm_loadu_ps(s.m_pAccel + 2*i + 4*h)));
+
+          if(F & PARTICLE_FRICTION)
+            v = _mm_mul_ps(v, kk[h]);
+
+          if(F & (PARTICLE_ACCEL | PARTICLE_FRICTION))
+            _mm_storeu_ps(pVel, v);
+        } //for
+      } //if
+
+      else MoveVectors<F>(s, i, i + 4, t);
+    } //if
+
+    if(F & PARTICLE_SPIN){
+      __m128 roll = _mm_loadu_ps(s.m_pRoll + i);
+      roll = _mm_add_ps(roll, _mm_mul_ps(vSpin, _mm_loadu_ps(s.m_pRSpeed + i)));
+      _mm_storeu_ps(s.m_pRoll + i, roll);
+    } //if
+
+    const __m128 f1 = _mm_sub_ps(vOne, f); //life remaining
+
+    //rescale
+
+    if(F & PARTICLE_SCALE){
+      const __m128 sin = _mm_loadu_ps(s.m_pScaleInFrac + i);
+      const __m128 sout = _mm_loadu_ps(s.m_pScaleOutFrac + i);
+
+      __m128 scale = _mm_loadu_ps(s.m_pMaxScale + i);
+      scale = _mm_mul_ps(scale, Select(_mm_cmplt_ps(f, sin), _mm_div_ps(f, sin), vOne));
+      scale = _mm_mul_ps(scale, Select(_mm_cmpgt_ps(f, _mm_sub_ps(vOne, sout)), _mm_div_ps(f1, sout), vOne));
+      _mm_storeu_ps(s.m_pScale + i, scale);
+    } //if
+
+    //fade
+
+    if(F & PARTICLE_FADE){
+      const __m128 fin = _mm_loadu_ps(s.m_pFadeInFrac + i);
+      const __m128 fout = _mm_loadu_ps(s.m_pFadeOutFrac + i);
+
+      __m128 alpha = _mm_loadu_ps(s.m_pAlpha + i);
+      alpha = Select(_mm_cmplt_ps(f, fin), _mm_div_ps(f, fin), alpha);
+      alpha = Select(_mm_cmpgt_ps(f, _mm_sub_ps(vOne, fout)), _mm_div_ps(f1, fout), alpha);
+      _mm_storeu_ps(s.m_pAlpha + i, alpha);
+    } //if
+  } //for
+
+  StepRange<F>(s, i, n, now, t); //leftovers
+} //StepParticlesSSE2
+
+/// The AVX2 kernel, which does 8 particles at a time.
+/// \tparam F Feature mask.
+/// \param s The particle arrays.
+/// \param n Number of particles.
+/// \param now Current time.
+/// \param t Frame time.
+
+template<unsigned F> TARGET_AVX2 static void StepParticlesAVX2(const ParticleStreams& s, size_t n, float now, float t){
+  const __m256 vZero = _mm256_setzero_ps();
+  const __m256 vOne = _mm256_set1_ps(1.0f);
+  const __m256 vNow = _mm256_set1_ps(now);
+  const __m256 vT = _mm256_set1_ps(t);
+  const __m256 vAccel = _mm256_set1_ps(t*100.0f);
+  const __m256 vSpin = _mm256_set1_ps(t*XM_2PI);
+
+  const __m256i vLo = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3); //spread first 4 lanes
+  const __m256i vHi = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7); //spread last 4 lanes
+
+  size_t i = 0;
+
+  for(; i + 8 <= n; i += 8){
+    //life fraction
+
+    const __m256 f = _mm256_max_ps(_mm256_div_ps(_mm256_sub_ps(vNow,
+      _mm256_loadu_ps(s.m_pBirthTime + i)), _mm256_loadu_ps(s.m_pLifeSpan + i)), vZero);
+    _mm256_storeu_ps(s.m_pLifeFrac + i, f);
+
+    //move
+
+    if(F & VELOCITY_FEATURES){
+      if(s.m_nDim == 2){
+        __m256 kk[2] = {vOne, vOne}; //friction, one per float
+
+        if(F & PARTICLE_FRICTION){
+          const __m256 k = _mm256_sub_ps(vOne, _mm256_mul_ps(vT, _mm256_loadu_ps(s.m_pFriction + i)));
+          kk[0] = _mm256_permutevar8x32_ps(k, vLo);
+          kk[1] = _mm256_permutevar8x32_ps(k, vHi);
+        } //if
+
+        for(int h=0; h<2; h++){
+          float* pPos = s.m_pPos + 2*i + 8*h;
+          float* pVel = s.m_pVel + 2*i + 8*h;
+
+          __m256 v = _mm256_loadu_ps(pVel);
+
+          if(F & PARTICLE_MOVE)
+            _mm256_storeu_ps(pPos, _mm256_add_ps(_mm256_loadu_ps(pPos), _mm256_mul_ps(vT, v)));
+
+          if(F & PARTICLE_ACCEL)
+            v = _mm256_add_ps(v, _mm256_mul_ps(vAccel, _mm256_loadu_ps(s.m_pAccel + 2*i + 8*h)));
+
+          if(F & PARTICLE_FRICTION)
+            v = _mm256_mul_ps(v, kk[h]);
+
+          if(F & (PARTICLE_ACCEL | PARTICLE_FRICTION))
+            _mm256_storeu_ps(pVel, v);
+        } //for
+      } //if
+
+      else MoveVectors<F>(s, i, i + 8, t);
+    } //if
+
+    if(F & PARTICLE_SPIN){
+      __m256 roll = _mm256_loadu_ps(s.m_pRoll + i);
+      roll = _mm256_add_ps(roll, _mm256_mul_ps(vSpin, _mm256_loadu_ps(s.m_pRSpeed + i)));
+      _mm256_storeu_ps(s.m_pRoll + i, roll);
+    } //if
+
+    const __m256 f1 = _mm256_sub_ps(vOne, f); //life remaining
+
+    //rescale
+
+    if(F & PARTICLE_SCALE){
+      const __m256 sin = _mm256_loadu_ps(s.m_pScaleInFrac + i);
+      const __m256 sout = _mm256_loadu_ps(s.m_pScaleOutFrac + i);
+
+      __m256 scale = _mm256_loadu_ps(s.m_pMaxScale + i);
+      scale = _mm256_mul_ps(scale, _mm256_blendv_ps(vOne, _mm256_div_ps(f, sin),
+        _mm256_cmp_ps(f, sin, _CMP_LT_OQ)));
+      scale = _mm256_mul_ps(scale, _mm256_blendv_ps(vOne, _mm256_div_ps(f1, sout),
+        _mm256_cmp_ps(f, _mm256_sub_ps(vOne, sout), _CMP_GT_OQ)));
+      _mm256_storeu_ps(s.m_pScale + i, scale);
+    } //if
+
+    //fade
+
+    if(F & PARTICLE_FADE){
+      const __m256 fin = _mm256_loadu_ps(s.m_pFadeInFrac + i);
+      const __m256 fout = _mm256_loadu_ps(s.m_pFadeOutFrac + i);
+
+      __m256 alpha = _mm256_loadu_ps(s.m_pAlpha + i);
+      alpha = _mm256_blendv_ps(alpha, _mm256_div_ps(f, fin), _mm256_cmp_ps(f, fin, _CMP_LT_OQ));
+      alpha = _mm256_blendv_ps(alpha, _mm256_div_ps(f1, fout),
+        _mm256_cmp_ps(f, _mm256_sub_ps(vOne, fout), _CMP_GT_OQ));
+      _mm256_storeu_ps(s.m_pAlpha + i, alpha);
+    } //if
+  } //for
+
+  StepRange<F>(s, i, n, now, t); //leftovers
+} //StepParticlesAVX2
+
+/// Ask the CPU what it can do.
+/// \param info [OUT] EAX, EBX, ECX, and EDX.
+/// \param leaf CPUID leaf.
+/// \param subleaf CPUID subleaf.
+
+static void GetCPUID(int info[4], int leaf, int subleaf){
+#ifdef _MSC_VER
+  __cpuidex(info, leaf, subleaf);
+#else
+  unsigned a = 0, b = 0, c = 0, d = 0;
+  __cpuid_count(leaf, subleaf, a, b, c, d);
+  info[0] = (int)a; info[1] = (int)b; info[2] = (int)c; info[3] = (int)d;
+#endif
+} //GetCPUID
+
+/// Ask the operating system which register states it saves.
+/// \return The XCR0 register.
+
+static unsigned long long GetXCR0(){
+#ifdef _MSC_VER
+  return _xgetbv(0);
+#else
+  unsigned lo = 0, hi = 0;
+  __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+  return ((unsigned long long)hi << 32) | lo;
+#endif
+} //GetXCR0
+
+/// Find the fastest kernel that this CPU and operating system
+/// support. AVX2 needs the CPU to have it and the operating system
+/// to save the YMM registers on a context switch.
+/// \return The best kernel.
+
+eParticleKernel GetBestParticleKernel(){
+  int info[4];
+  GetCPUID(info, 0, 0);
+  const int nMaxLeaf = info[0];
+
+  GetCPUID(info, 1, 0);
+  const bool bSSE2 = (info[3] & (1 << 26)) != 0;
+  const bool bOSXSAVE = (info[2] & (1 << 27)) != 0;
+  const bool bAVX = (info[2] & (1 << 28)) != 0;
+
+  if(nMaxLeaf >= 7 && bOSXSAVE && bAVX && (GetXCR0() & 6) == 6){ //YMM state saved
+    GetCPUID(info, 7, 0);
+
+    if(info[1] & (1 << 5)) //AVX2
+      return eParticleKernel::AVX2;
+  } //if
+
+  return bSSE2? eParticleKernel::SSE2: eParticleKernel::SCALAR;
+} //GetBestParticleKernel
+
+#else //not x86, so scalar only
+
+template<unsigned F> static void StepParticlesSSE2(const ParticleStreams& s, size_t n, float now, float t){
+  StepRange<F>(s, 0, n, now, t);
+} //StepParticlesSSE2
+
+template<unsigned F> static void StepParticlesAVX2(const ParticleStreams& s, size_t n, float now, float t){
+  StepRange<F>(s, 0, n, now, t);
+} //StepParticlesAVX2
+
+eParticleKernel GetBestParticleKernel(){
+  return eParticleKernel::SCALAR;
+} //GetBestParticleKernel
+
+#endif //PARTICLE_KERNEL_X86
+
+/// Look up a kernel in tables of every instantiation, one table
+/// per instruction set, indexed by feature mask.
+/// \param k Instruction set.
+/// \param features Feature mask, at most PARTICLE_ALL.
+/// \return Pointer to the kernel.
+
+template<size_t... I> static ParticleKernelFn LookUpKernel(eParticleKernel k,
+  unsigned features, std::index_sequence<I...>)
+{
+  static const ParticleKernelFn scalar[] = {StepParticlesScalar<I>...};
+  static const ParticleKernelFn sse2[] = {StepParticlesSSE2<I>...};
+  static const ParticleKernelFn avx2[] = {StepParticlesAVX2<I>...};
+
+  switch(k){
+    case eParticleKernel::AVX2: return avx2[features];
+    case eParticleKernel::SSE2: return sse2[features];
+    default: return scalar[features];
+  } //switch
+} //LookUpKernel
+
+/// Get the kernel for an instruction set and set of features. The
+/// caller is responsible for checking that the CPU supports it.
+/// \param k Instruction set.
+/// \param features Feature mask made from eParticleFeature flags.
+/// \return Pointer to the kernel.
+
+ParticleKernelFn GetParticleKernel(eParticleKernel k, unsigned features){
+  return LookUpKernel(k, features & PARTICLE_ALL,
+    std::make_index_sequence<PARTICLE_ALL + 1>());
+} //GetParticleKernel
@@ -0,0 +1,98 @@
+/// \file Profiler.cpp
+/// \brief Code for the profiler CProfiler.
+
+#include "Profiler.h"
+
+#ifdef PROFILE
+
+#include <stdio.h>
+
+#include "Defines.h"
+
+mutex CProfiler::m_mutex;
+vector<unique_ptr<CProfileBuffer>> CProfiler::m_vBuffers;
+thread_local CProfileBuffer* CProfiler::m_pBuffer = nullptr;
+
+/// Get this thread's buffer, making it the first time the thread
+/// records a zone. This is the only time that the mutex is locked
+/// while recording.
+/// \return Pointer to this thread's buffer.
+
+CProfileBuffer* CProfiler::GetBuffer(){
+  if(m_pBuffer == nullptr){
+    unique_ptr<CProfileBuffer> p(new CProfileBuffer);
+    p->m_vZones.resize(PROFILE_BUFFER_SIZE);
+
+    lock_guard<mutex> lock(m_mutex);
+    p->m_nThread = (unsigned)m_vBuffers.size();
+    m_pBuffer = p.get();
+    m_vBuffers.push_back(move(p));
+  } //if
+
+  return m_pBuffer;
+} //GetBuffer
+
+/// Record a zone in this thread's buffer, overwriting the oldest
+/// if the buffer is full.
+/// \param name Zone name, which must be a string literal.
+/// \param start Start time in nanoseconds.
+/// \param end End time in nanoseconds.
+
+void CProfiler::record(const char* name, int64_t start, int64_t end){
+  CProfileBuffer* p = GetBuffer();
+  const size_t n = p->m_nCount.load(memory_order_relaxed);
+
+  CProfileZone& z = p->m_vZones[n & (PROFILE_BUFFER_SIZE - 1)];
+  z.m_pName = name;
+  z.m_nStart = start;
+  z.m_nEnd = end;
+
+  p->m_nCount.store(n + 1, memory_order_release);
+} //record
+
+/// Save the zones in every thread's buffer as complete events in the
+/// Chrome trace event format, with times in microseconds. This is
+/// best done between frames, since zones recorded by other threads
+/// while it is saving may be missed, or come out half written.
+/// \param filename File name.
+/// \return true if the file was written.
+
+bool CProfiler::Save(const char* filename){
+  FILE* fp = nullptr;
+  fopen_s(&fp, filename, "wt");
+  if(fp == nullptr)return false;
+
+  fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+
+  lock_guard<mutex> lock(m_mutex);
+  bool bFirst = true; //whether no events have been written yet
+
+  for(auto const& p: m_vBuffers){ //for each thread
+    const size_t n = p->m_nCount.load(memory_order_acquire);
+    const size_t first = n > PROFILE_BUFFER_SIZE? n - PROFILE_BUFFER_SIZE: 0; //oldest zone kept
+
+    for(size_t i=first; i<n; i++){ //for each zone
+      const CProfileZone& z = p->m_vZones[i & (PROFILE_BUFFER_SIZE - 1)];
+
+      fprintf(fp, "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+        bFirst? "": ",\n", z.m_pName, p->m_nThread, z.m_nStart/1000.0, (z.m_nEnd - z.m_nStart)/1000.0);
+      bFirst = false;
+    } //for
+  } //for
+
+  fprintf(fp, "\n]}\n");
+  fclose(fp);
+  return true;
+} //Save
+
+/// Forget all zones recorded so far, for example to start a trace
+/// from a particular moment. The buffers are kept.
+
+void CProfiler::clear(){
+  lock_guard<mutex> lock(m_mutex);
+
+  for(auto const& p: m_vBuffers)
+    p->m_nCount.store(0, memory_order_release);
+} //clear
+
+#endif //PROFILE
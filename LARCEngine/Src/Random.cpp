@@ -1,7 +1,7 @@
 /// \file Random.cpp
 /// \brief Code for the pseudorandom number generator CRandom.
 
-#include "random.h"
+#include "Random.h"
 #include "Timer.h"
 #include "Helpers.h"
 
@@ -15,20 +15,42 @@ CRandom::CRandom(){
 /// If the seed is negative (which it is by default
 /// if no parameter is supplied), then use the raw time
 /// of day, which is assumed to be somewhat unpredictable.
-/// The state variables for xorshift128 are initialized using
-/// the C Standard Library function rand() which is
-/// seeded using the pro-offered seed value.
+/// The state variables for xorshift128 are initialized from
+/// the seed in the style of splitmix, which unlike the C
+/// Standard Library function rand() gives the same numbers
+/// on every platform.
 /// \param seed The seed, defaults to -1.
 
 void CRandom::srand(int seed){ 
-  ::srand((seed >= 0)? seed: m_pTimer->rawtime() & 0x7FFF);
+  m_nSeed = (seed >= 0)? seed: int(m_pTimer->rawtime() & 0x7FFFFFFF);
 
-  m_uState[0] = m_pTimer->rawtime() & 0xFFFFFFFF;
+  unsigned s = (unsigned)m_nSeed;
 
-  for(int i=1; i<=3; i++)
-    m_uState[i] = m_uState[i - 1]*(unsigned)::rand();
+  for(int i=0; i<4; i++){ //golden ratio step, then the murmur3 mix
+    unsigned z = (s += 0x9E3779B9);
+    z = (z ^ (z >> 16))*0x85EBCA6B;
+    z = (z ^ (z >> 13))*0xC2B2AE35;
+    m_uState[i] = z ^ (z >> 16);
+  } //for
 } //srand
 
+/// Reader function for the seed, so that a sequence
+/// seeded from the time can be reproduced later.
+/// \return The seed last given to srand, or the one it chose.
+
+int CRandom::GetSeed(){
+  return m_nSeed;
+} //GetSeed
+
+/// Reader function for the state, for example to check that two
+/// runs of the simulation drew the same pseudorandom numbers.
+/// \param state [OUT] The 4 words of xorshift128 state.
+
+void CRandom::GetState(unsigned state[4]){
+  for(int i=0; i<4; i++)
+    state[i] = m_uState[i];
+} //GetState
+
 /// Generate a pseudorandom unsigned integer using xorshift128.
 /// This is the one that does the actual work here: The other
 /// psuedorandom generation functions rely on this one.
@@ -21,7 +21,7 @@ Vector2 CSettings::m_vWinCenter = Vector2(0.0f);
 
 void CSettingsManager::Load(){    
   //load settings file
-  if(m_xmlDoc.LoadFile("Media\\xml\\gamesettings.xml"))
+  if(m_xmlDoc.LoadFile("Media/xml/gamesettings.xml"))
     ABORT("Cannot load settings file gamesettings.xml.");
 
   //get settings tag
@@ -2,7 +2,6 @@
 /// \brief Code for the sprite class CSprite.
 
 #include "Sprite.h"
-#include "Renderer3D.h"
 
 #include "Abort.h"
 
@@ -3,6 +3,7 @@
 
 #include "SpriteRenderer.h"
 #include "Abort.h"
+#include "FrameArena.h"
 
 /// Construct a 3D renderer and a base camera.
 /// \param mode Sprite render mode.
@@ -277,26 +278,34 @@ void CSpriteRenderer::Draw(const CSpriteDesc3D& sd){
 
 /// \brief Comparison for depth sorting sprites.
 ///
-/// Compare the sprites' Z coordinates.
+/// Compare the sprites' Z coordinates. Sprites at the same depth
+/// are kept in render list order, which is the order of the pointers.
 /// \param p0 Pointer to sprite descriptor 0.
 /// \param p1 Pointer to sprite descriptor 1.
 /// \return true If sprite 0 is behind sprite 1.
 
 bool IsBehind(const CSpriteDesc3D* p0, const CSpriteDesc3D* p1){
-  return p0->m_vPos.z > p1->m_vPos.z;
+  if(p0->m_vPos.z != p1->m_vPos.z)
+    return p0->m_vPos.z > p1->m_vPos.z;
+
+  return p0 < p1;
 } //IsBehind
 
 /// Depth sort a render list using a vector of pointers, then
-/// draw them from back to front.
+/// draw them from back to front. The pointers live in the frame
+/// arena, and since IsBehind breaks ties by render list order an
+/// ordinary sort gives the same result as a stable sort without
+/// the stable sort's temporary buffer.
 /// \param renderlist A vector of 3D sprite descriptors of the sprites to be rendered.
 
 void CSpriteRenderer::Draw(vector<CSpriteDesc3D>& renderlist){
-  vector<CSpriteDesc3D*> sortedlist; //use pointers for faster sorting
+  CFrameVector<CSpriteDesc3D*> sortedlist; //use pointers for faster sorting
+  sortedlist.reserve(renderlist.size());
 
   for(int i=0; i<renderlist.size(); i++) //duplicate render list but with pointers
     sortedlist.push_back(&(renderlist[i]));
 
-  stable_sort(sortedlist.begin(), sortedlist.end(), IsBehind); //depth sort
+  sort(sortedlist.begin(), sortedlist.end(), IsBehind); //depth sort
   
   for(auto p: sortedlist) //from back to front
     Draw(*p); //draw them
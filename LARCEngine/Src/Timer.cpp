@@ -1,12 +1,30 @@
 /// \file timer.cpp
 /// \brief Code for timer class CTimer.
 
-#include <windows.h> //for timeGetTime()
-#pragma comment(lib, "winmm.lib") //for timeGetTime()
-
-#include "timer.h"
-
-CTimer::CTimer(){
+#ifdef _WIN32
+  #include <windows.h> //for timeGetTime()
+  #pragma comment(lib, "winmm.lib") //for timeGetTime()
+#else //_WIN32
+  #include <chrono>
+
+  /// Stand-in for the Windows API function timeGetTime.
+  /// \return Time in milliseconds from some fixed point.
+
+  static unsigned timeGetTime(){
+    using namespace std::chrono;
+    return (unsigned)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+  } //timeGetTime
+#endif //_WIN32
+
+#include "Timer.h"
+#include "FrameArena.h"
+
+/// \param arena Pointer to a frame arena to be reset at the start
+/// of each frame, or nullptr for none.
+
+CTimer::CTimer(CFrameArena* arena):
+  m_pFrameArena(arena)
+{
   m_nStartTime = timeGetTime();
 } //constructor
 
@@ -81,10 +99,16 @@ bool CTimer::elapsed(float &start, float interval){
 } //elapsed
 
 /// This must be called before each animation frame
-/// to record the time that it started.
+/// to record the time that it started, unless the time
+/// is being set by hand. Anything allocated from the
+/// frame arena during the last frame is freed.
 
 void CTimer::BeginFrame(){ 
-  m_fFrameStartTime = actualtime();
+  if(!m_bManual)
+    m_fFrameStartTime = actualtime();
+
+  if(m_pFrameArena)
+    m_pFrameArena->reset();
 } //BeginFrame
 
 /// This must be called after each animation frame to
@@ -94,7 +118,9 @@ void CTimer::EndFrame(){
   if(!m_bStarted)start(); //start the timer on the first frame
 
   ++m_nFrameCount; //one more frame for frame rate
-  m_fFrameTime = actualtime() - m_fFrameStartTime; //frame time
+
+  if(!m_bManual) //otherwise the frame time was set by SetTime
+    m_fFrameTime = actualtime() - m_fFrameStartTime; //frame time
 
   if(elapsed(m_fStartFrameRate, 1.0f)){ //adjust frame rate each second
     m_nFrameRate = m_nFrameCount;
@@ -103,3 +129,24 @@ void CTimer::EndFrame(){
 
   m_fFrameTime = min(m_fFrameTime, 0.033333f); //even out big bumps
 } //EndFrame
+
+/// Set the time at the start of the current frame by hand. From now
+/// on the clock is ignored, and the frame time is the time since the
+/// time was last set. Call this before BeginFrame to run the game at
+/// other than real time, for example to step the simulation as fast
+/// as it will go in a headless build.
+/// \param t Time at the start of the current frame, in seconds.
+
+void CTimer::SetTime(float t){
+  m_bStarted = m_bManual = true;
+  m_fFrameTime = max(0.0f, t - m_fFrameStartTime);
+  m_fFrameStartTime = t;
+} //SetTime
+
+/// Set the frame time by hand, after SetTime, for example to play back
+/// a recording of the frame times as well as the times.
+/// \param t Frame time in seconds.
+
+void CTimer::SetFrameTime(float t){
+  m_fFrameTime = t;
+} //SetFrameTime
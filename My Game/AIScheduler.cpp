@@ -0,0 +1,134 @@
+/// \file AIScheduler.cpp
+/// \brief Code for the AI scheduler CAIScheduler.
+
+#include "AIScheduler.h"
+
+#include <algorithm>
+#include <cfloat>
+
+/// Reserve some space for agents.
+/// \param budget Maximum number of perception updates per frame.
+
+CAIScheduler::CAIScheduler(size_t budget):
+  m_nBudget(budget)
+{
+  m_vAgents.reserve(256);
+  m_vCandidates.reserve(256);
+} //constructor
+
+/// Add an agent. It is due for a perception update straight away.
+/// \param p Pointer to the agent.
+/// \param interval Time between perception updates.
+
+void CAIScheduler::insert(CObject* p, float interval){
+  AIAgent a;
+  a.m_pAgent = p;
+  a.m_fInterval = interval;
+
+  p->m_nAISlot = m_vAgents.size();
+  m_vAgents.push_back(a);
+} //insert
+
+/// Remove an agent by moving the last agent into its place.
+/// \param p Pointer to the agent.
+
+void CAIScheduler::remove(CObject* p){
+  const size_t i = p->m_nAISlot;
+  if(i >= m_vAgents.size() || m_vAgents[i].m_pAgent != p)return; //not an agent
+
+  m_vAgents[i] = m_vAgents.back();
+  m_vAgents[i].m_pAgent->m_nAISlot = i;
+  m_vAgents.pop_back();
+} //remove
+
+/// Remove all agents.
+
+void CAIScheduler::clear(){
+  m_vAgents.clear();
+} //clear
+
+/// Pick the agents that get to update their perception in this frame.
+/// This should be called once per frame, not once per physics step.
+/// Each agent that is due gets an urgency that grows with the number
+/// of intervals it is overdue and shrinks with its distance from the
+/// nearest player, and the most urgent ones are picked up to the
+/// budget. Distant agents still get their turn once they fall far
+/// enough behind.
+/// \param t Current time.
+/// \param players The characters that agents look for.
+
+void CAIScheduler::schedule(float t, const vector<CObject*>& players){
+  m_vCandidates.clear();
+
+  for(size_t i=0; i<m_vAgents.size(); i++){
+    AIAgent& a = m_vAgents[i];
+    a.m_bDue = false;
+    if(t < a.m_fNextTime)continue; //not yet
+
+    float d = FLT_MAX; //distance to nearest player
+
+    for(auto const& c: players)
+      d = min(d, (c->m_vPos - a.m_pAgent->m_vPos).Length());
+
+    const float lateness = (t - a.m_fNextTime)/max(a.m_fInterval, 0.001f);
+    const float nearness = m_fNearRange/(m_fNearRange + d);
+    m_vCandidates.push_back(make_pair((1.0f + lateness)*nearness, i));
+  } //for
+
+  if(m_vCandidates.size() > m_nBudget){ //most urgent first
+    nth_element(m_vCandidates.begin(), m_vCandidates.begin() + m_nBudget,
+      m_vCandidates.end(), [](const pair<float, size_t>& a, const pair<float, size_t>& b){
+        return a.first > b.first;
+      });
+
+    m_vCandidates.resize(m_nBudget);
+  } //if
+
+  for(auto const& c: m_vCandidates)
+    m_vAgents[c.second].m_bDue = true;
+} //schedule
+
+/// Find out whether an agent was picked to update its perception in
+/// this frame and hasn't done so yet.
+/// \param p Pointer to the agent.
+/// \return true if the agent should update its perception.
+
+bool CAIScheduler::IsDue(CObject* p){
+  const size_t i = p->m_nAISlot;
+  return i < m_vAgents.size() && m_vAgents[i].m_pAgent == p && m_vAgents[i].m_bDue;
+} //IsDue
+
+/// Cache an agent's perception and schedule its next update.
+/// \param p Pointer to the agent.
+/// \param r What the agent perceived, stamped with the current time.
+
+void CAIScheduler::SetPerception(CObject* p, const AIPerception& r){
+  AIAgent& a = m_vAgents[p->m_nAISlot];
+  a.m_Perception = r;
+  a.m_fNextTime = r.m_fTime + a.m_fInterval;
+  a.m_bDue = false;
+} //SetPerception
+
+/// Get the last thing an agent perceived. The target may have died
+/// since, so the caller should check that it is still around.
+/// \param p Pointer to the agent.
+/// \return The agent's latest perception.
+
+const AIPerception& CAIScheduler::GetPerception(CObject* p){
+  return m_vAgents[p->m_nAISlot].m_Perception;
+} //GetPerception
+
+/// Set the maximum number of perception updates per frame.
+/// \param n Number of updates.
+
+void CAIScheduler::SetBudget(size_t n){
+  m_nBudget = n;
+} //SetBudget
+
+/// Set the time between an agent's perception updates.
+/// \param p Pointer to the agent.
+/// \param interval Time between perception updates.
+
+void CAIScheduler::SetInterval(CObject* p, float interval){
+  m_vAgents[p->m_nAISlot].m_fInterval = interval;
+} //SetInterval
@@ -0,0 +1,67 @@
+/// \file AIScheduler.h
+/// \brief Interface for the AI scheduler CAIScheduler.
+
+#pragma once
+
+#include <vector>
+
+#include "Object.h"
+
+using namespace std;
+
+const size_t DEFAULT_AI_BUDGET = 16; ///< Default number of perception updates per frame.
+const float DEFAULT_AI_NEAR_RANGE = 512.0f; ///< Default distance from a player that counts as near.
+
+/// \brief What an agent last perceived.
+
+struct AIPerception{
+  CObject* m_pTarget = nullptr; ///< Character chosen as the target, if any.
+  bool m_bSeen = false; ///< Whether any character was seen.
+  float m_fTime = 0.0f; ///< When this was perceived.
+}; //AIPerception
+
+/// \brief The AI scheduler.
+///
+/// Choosing a target means casting sight lines, which is far too
+/// expensive to do for every enemy in every physics step. Instead each
+/// agent has an update interval, and once per frame the scheduler
+/// picks which of the agents that are due get to update their
+/// perception in this frame. No more than a fixed budget of agents are
+/// picked, the ones nearest to a player and the ones furthest behind
+/// first, so the time spent on perception stays about the same however
+/// many enemies there are. In between updates each agent acts on the
+/// last thing that it perceived, which is cached here.
+
+class CAIScheduler{
+  private:
+    /// \brief Scheduling information for an agent.
+
+    struct AIAgent{
+      CObject* m_pAgent = nullptr; ///< The agent.
+      float m_fInterval = 0.0f; ///< Time between perception updates.
+      float m_fNextTime = 0.0f; ///< When the next update is due.
+      bool m_bDue = false; ///< Whether picked to update this frame.
+      AIPerception m_Perception; ///< Latest perception.
+    }; //AIAgent
+
+    size_t m_nBudget = DEFAULT_AI_BUDGET; ///< Maximum updates per frame.
+    float m_fNearRange = DEFAULT_AI_NEAR_RANGE; ///< Distance from a player that counts as near.
+
+    vector<AIAgent> m_vAgents; ///< The agents.
+    vector<pair<float, size_t>> m_vCandidates; ///< Scheduling scratch space, urgency and index.
+
+  public:
+    CAIScheduler(size_t budget=DEFAULT_AI_BUDGET); ///< Constructor.
+
+    void insert(CObject* p, float interval); ///< Add an agent.
+    void remove(CObject* p); ///< Remove an agent.
+    void clear(); ///< Remove all agents.
+
+    void schedule(float t, const vector<CObject*>& players); ///< Pick the agents to update this frame.
+    bool IsDue(CObject* p); ///< Whether an agent should update its perception.
+    void SetPerception(CObject* p, const AIPerception& r); ///< Cache an agent's perception.
+    const AIPerception& GetPerception(CObject* p); ///< Get an agent's latest perception.
+
+    void SetBudget(size_t n); ///< Set the maximum updates per frame.
+    void SetInterval(CObject* p, float interval); ///< Set an agent's update interval.
+}; //CAIScheduler
@@ -0,0 +1,129 @@
+/// \file Benchmark.cpp
+/// \brief Code for the benchmark classes CBenchmark and CBenchmarkTimer.
+
+#include "Benchmark.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+/// Add a time sample.
+/// \param t Timer.
+/// \param us Time in microseconds.
+
+void CBenchmark::add(eBenchmarkTimer t, double us){
+  m_vSamples[t].push_back(us);
+} //add
+
+/// Clear all samples, for example between levels.
+
+void CBenchmark::clear(){
+  for(auto& v: m_vSamples)
+    v.clear();
+} //clear
+
+/// Reserve space for samples so that timing a step doesn't allocate
+/// memory, which would upset CHECK_STEP_ALLOCATIONS in HeapCheck.h.
+/// \param n Number of samples to reserve space for, for each timer.
+
+void CBenchmark::reserve(size_t n){
+  for(auto& v: m_vSamples)
+    v.reserve(n);
+} //reserve
+
+/// Reader function for the number of samples.
+/// \param t Timer.
+/// \return Number of samples.
+
+size_t CBenchmark::GetCount(eBenchmarkTimer t){
+  return m_vSamples[t].size();
+} //GetCount
+
+/// Get the mean of the samples.
+/// \param t Timer.
+/// \return Mean time in microseconds, or zero if there are no samples.
+
+double CBenchmark::GetMean(eBenchmarkTimer t){
+  const vector<double>& v = m_vSamples[t];
+  if(v.empty())return 0.0;
+
+  double sum = 0.0;
+
+  for(auto const& x: v)
+    sum += x;
+
+  return sum/v.size();
+} //GetMean
+
+/// Get a percentile of the samples using the nearest rank method,
+/// so that the result is always one of the samples. The samples are
+/// sorted in place, which doesn't change anything else.
+/// \param t Timer.
+/// \param p Percentile, between 0 and 100.
+/// \return Time in microseconds, or zero if there are no samples.
+
+double CBenchmark::GetPercentile(eBenchmarkTimer t, double p){
+  vector<double>& v = m_vSamples[t];
+  if(v.empty())return 0.0;
+
+  sort(v.begin(), v.end()); //quick if already sorted
+
+  size_t rank = (size_t)ceil(p*v.size()/100.0); //nearest rank, from 1
+  rank = min(max(rank, (size_t)1), v.size());
+
+  return v[rank - 1];
+} //GetPercentile
+
+/// Write a JSON object with a member for each timer, which is itself
+/// an object holding the number of samples and their mean, median,
+/// 95th and 99th percentiles in microseconds.
+/// \param fp File pointer.
+/// \param indent Indentation of the object's members.
+
+void CBenchmark::WriteJSON(FILE* fp, const char* indent){
+  fprintf(fp, "{\n");
+
+  for(int i=0; i<NUM_BENCHMARK_TIMERS; i++){ //for each timer
+    const eBenchmarkTimer t = (eBenchmarkTimer)i;
+
+    fprintf(fp, "%s\"%s\": {\"count\": %u, \"mean\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f}%s\n",
+      indent, GetName(t), (unsigned)GetCount(t), GetMean(t),
+      GetPercentile(t, 50.0), GetPercentile(t, 95.0), GetPercentile(t, 99.0),
+      i + 1 < NUM_BENCHMARK_TIMERS? ",": "");
+  } //for
+
+  fprintf(fp, "%.*s}", max(0, (int)strlen(indent) - 2), indent);
+} //WriteJSON
+
+/// Get the name of a timer, which is used as its key in the JSON.
+/// \param t Timer.
+/// \return Timer name.
+
+const char* CBenchmark::GetName(eBenchmarkTimer t){
+  switch(t){
+    case MOVE_TIMER: return "move";
+    case BROADPHASE_TIMER: return "broadphase";
+    case CULL_TIMER: return "cull";
+    case PARTICLE_TIMER: return "particles";
+    case LOAD_TIMER: return "load";
+    default: return "unknown";
+  } //switch
+} //GetName
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+/// Start timing if a benchmark is running.
+/// \param t Timer.
+
+CBenchmarkTimer::CBenchmarkTimer(eBenchmarkTimer t): m_nTimer(t){
+  if(m_pBenchmark)
+    m_nStart = CProfileClock::now();
+} //constructor
+
+/// Stop timing and add the time to the benchmark, if one is running.
+
+CBenchmarkTimer::~CBenchmarkTimer(){
+  if(m_pBenchmark)
+    m_pBenchmark->add(m_nTimer, (CProfileClock::now() - m_nStart)/1000.0);
+} //destructor
@@ -0,0 +1,68 @@
+/// \file Benchmark.h
+/// \brief Interface for the benchmark classes CBenchmark and CBenchmarkTimer.
+
+#pragma once
+
+#include <stdio.h>
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "Common.h"
+#include "Profiler.h"
+
+using namespace std;
+
+/// \brief The parts of the simulation that the benchmark times.
+
+enum eBenchmarkTimer{
+  MOVE_TIMER, ///< CObjectManager::move, which includes the next two.
+  BROADPHASE_TIMER, ///< CObjectManager::BroadPhase.
+  CULL_TIMER, ///< CObjectManager::CullDeadObjects.
+  PARTICLE_TIMER, ///< CParticleEngine::step.
+  LOAD_TIMER, ///< CObjectManager::LoadMap.
+  NUM_BENCHMARK_TIMERS ///< Number of timers.
+}; //eBenchmarkTimer
+
+/// \brief The benchmark.
+///
+/// A benchmark is a collection of time samples, in microseconds,
+/// for each of the parts of the simulation in eBenchmarkTimer. It
+/// collects samples only while it is the one pointed to by
+/// CCommon::m_pBenchmark, which it never is in the Windows build,
+/// and reports the mean and percentiles of each as JSON.
+
+class CBenchmark{
+  private:
+    vector<double> m_vSamples[NUM_BENCHMARK_TIMERS]; ///< Samples for each timer, in microseconds.
+
+  public:
+    void add(eBenchmarkTimer t, double us); ///< Add a sample.
+    void clear(); ///< Clear all samples.
+    void reserve(size_t n); ///< Reserve space for samples.
+
+    size_t GetCount(eBenchmarkTimer t); ///< Get number of samples.
+    double GetMean(eBenchmarkTimer t); ///< Get mean.
+    double GetPercentile(eBenchmarkTimer t, double p); ///< Get percentile.
+
+    void WriteJSON(FILE* fp, const char* indent); ///< Write statistics as JSON.
+    static const char* GetName(eBenchmarkTimer t); ///< Get timer name.
+}; //CBenchmark
+
+/// \brief The benchmark timer.
+///
+/// A benchmark timer times its own scope with the profiler's clock,
+/// the same way that a CProfileScope does, and adds the result to the
+/// benchmark as it goes out of scope. If no benchmark is running it
+/// does nothing, not even reading the clock.
+
+class CBenchmarkTimer: public CCommon{
+  private:
+    eBenchmarkTimer m_nTimer; ///< Which timer.
+    int64_t m_nStart = 0; ///< Time the scope was entered, in nanoseconds.
+
+  public:
+    CBenchmarkTimer(eBenchmarkTimer t); ///< Constructor.
+    ~CBenchmarkTimer(); ///< Destructor.
+}; //CBenchmarkTimer
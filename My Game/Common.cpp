@@ -9,6 +9,7 @@
 CRenderer* CCommon::m_pRenderer = nullptr;
 CObjectManager* CCommon::m_pObjectManager = nullptr;
 CParticleEngine2D* CCommon::m_pParticleEngine = nullptr;
+CBenchmark* CCommon::m_pBenchmark = nullptr;
 
 Vector2 CCommon::m_vWorldSize = Vector2::Zero;
 bool CCommon::m_bDrawAABBs = false;
@@ -3,7 +3,7 @@
 
 #pragma once
 
-#include "SndList.h"
+#include "Sndlist.h"
 
 enum gameState {
   TITLE_STATE, PAUSE_STATE, PLAY_STATE, WIN_STATE, LOSE_STATE,
@@ -16,6 +16,7 @@ class CObjectManager;
 class CRenderer;
 class CParticleEngine2D;
 class CObject;
+class CBenchmark;
 
 /// \brief The common variables class.
 ///
@@ -33,6 +34,7 @@ class CCommon{
     static CRenderer* m_pRenderer; ///< Pointer to the renderer.
     static CObjectManager* m_pObjectManager; ///< Pointer to the object manager.
     static CParticleEngine2D* m_pParticleEngine; ///< Pointer to particle engine.    
+    static CBenchmark* m_pBenchmark; ///< Pointer to the benchmark, if one is running.
 
     static bool m_bDrawAABBs; ///< Whether to draw AABBs.
     static Vector2 m_vWorldSize; ///< World height and width.
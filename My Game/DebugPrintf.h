@@ -3,6 +3,12 @@
 
 #pragma once
 
+#ifdef HEADLESS
+  #include <stdio.h>
+
+  #define DEBUGPRINTF printf ///< No debug client in a headless build, so use the console.
+#else //HEADLESS
+
 #include "debug.h"
 
 #define USE_DEBUGPRINTF ///< Define this to use the DEBUGPRINTF macro.
@@ -16,3 +22,5 @@
   #define DEBUGPRINTF ;
 #endif //USE_DEBUGPRINTF
 /**** END <DO NOT MESS WITH THIS CODE ZONE> ****/
+
+#endif //HEADLESS
@@ -147,5 +147,5 @@ void Key::unlockDoors()
 /// \brief shame really...
 void Key::kill()
 {
-  m_bDead = true;
+  MarkDead();
 }
\ No newline at end of file
@@ -7,14 +7,15 @@
 #include "Renderer.h"
 #include "ComponentIncludes.h"
 #include "ParticleEngine.h"
+#include "Profiler.h"
 
 #include "DebugPrintf.h"
 
-#define NUM_LEVELS 5
-
-/// Delete the renderer and the object manager.
+/// Save the replay being recorded, if there is one, and
+/// delete the renderer and the object manager.
 
 CGame::~CGame(){
+  m_cReplay.EndRecording(); //save replay, if recording
   delete m_pParticleEngine;
   delete m_pRenderer;
   delete m_pObjectManager;
@@ -64,7 +65,8 @@ void CGame::Initialize(){
   m_pObjectManager = new CObjectManager; //set up the object manager 
   m_pAudio->Load(); //load the sounds for this game
 
-  m_pParticleEngine = new CParticleEngine2D((CSpriteRenderer*)m_pRenderer);
+  m_pParticleEngine = new CParticleEngine2D((CSpriteRenderer*)m_pRenderer,
+    DEFAULT_PARTICLE_CAPACITY, PARTICLE_BASIC); //sparks and smoke only move, scale, and fade
 	BeginGame();
 } //Initialize
 
@@ -77,91 +79,71 @@ void CGame::CreateObjects(){
 /// Call this function to start a new game. This
 /// should be re-entrant so that you can start a
 /// new game without having to shut down and restart the
-/// program
+/// program. Restarting the level that is already loaded
+/// just restores it from the object manager's snapshot.
 
 void CGame::BeginGame(){
+  if(m_cReplay.EndRecording()) //the recording ends here, if there is one
+    DEBUGPRINTF("Saved replay in %s\n", DEFAULT_REPLAY_FILE);
+
   m_pParticleEngine->clear(); //clear old particles
-  m_pObjectManager->clear(); //clear old objects
-  m_pObjectManager->LoadMap(m_nCurrentLevel); //load map
+  m_pObjectManager->StartLevel(m_nCurrentLevel); //restore or load map
   CreateObjects(); //create new objects
 } //BeginGame
 
+/// Restart the current level and start recording a replay of it.
+/// The PRNG is reseeded and the level is restored from the snapshot,
+/// which leaves it in the same state as loading it fresh would, so
+/// that a replay can start from exactly the same state by doing the
+/// same. The accumulator starts empty, as it does when a replay is
+/// played back.
+
+void CGame::BeginRecording(){
+  m_bStartRecording = false;
+
+  m_pRandom->srand(); //seed from the time, and remember it
+  m_cReplay.BeginRecording(m_nCurrentLevel, m_pRandom->GetSeed(), m_pTimer->time());
+
+  m_pParticleEngine->clear(); //clear old particles
+  m_pObjectManager->StartLevel(m_nCurrentLevel); //restore or load map
+
+  accumulator = 0.0f;
+  DEBUGPRINTF("Recording level %d with seed %d\n", m_nCurrentLevel, m_pRandom->GetSeed());
+} //BeginRecording
+
 /// Poll the keyboard state and respond to the
 /// key presses that happened since the last frame.
+/// Anything the player does to the world is added to
+/// m_nInput for the object manager to act on.
 
 void CGame::KeyboardHandler(){
   m_pKeyboard->GetState(); //get current keyboard state 
 
-	//side to side movement
-	if (m_pKeyboard->Down('D') && m_pKeyboard->Down('A')){
-		/*dont fucking move*/
-	}
-	else {
-		if (m_pKeyboard->Down('D')) {
-			m_pPlayer->StrafeRight();
-			m_pPlayer->turn(RIGHT);
-		}
-		if (m_pKeyboard->Down('A')) {
-			m_pPlayer->StrafeLeft();
-			m_pPlayer->turn(LEFT);
-		}
-	}
+	//side to side movement, but not both ways at once
+	if (m_pKeyboard->Down('D') && !m_pKeyboard->Down('A'))
+		m_nInput |= INPUT_RIGHT;
+	if (m_pKeyboard->Down('A') && !m_pKeyboard->Down('D'))
+		m_nInput |= INPUT_LEFT;
 
 	//reset back to stationary
-	if (m_pKeyboard->TriggerUp('D')){
-		m_pPlayer->m_nCurrentFrame = 0;
-	}
-	if (m_pKeyboard->TriggerUp('A')){
-		m_pPlayer->m_nCurrentFrame = 4;
-	}
+	if (m_pKeyboard->TriggerUp('D'))
+		m_nInput |= INPUT_STOP_RIGHT;
+	if (m_pKeyboard->TriggerUp('A'))
+		m_nInput |= INPUT_STOP_LEFT;
 
 	//jump/climb up and down
-	CObject* elev = m_pObjectManager->isTouchingElevator();
 	if (m_pKeyboard->TriggerDown('W'))
-	{
-		if (m_pPlayer->m_nSpriteIndex == FAST_SPRITE && elev == nullptr) {
-			m_pPlayer->Jump();
-		}
-		else if (elev != nullptr){
-			((Elevator*)elev)->goUp();
-		}
-	}
-
+		m_nInput |= INPUT_JUMP;
 	if (m_pKeyboard->Down('W'))
-	{
-		if (m_pPlayer->isOnLadder()) {
-			m_pPlayer->climbUp();
-		}
-    else if (elev != nullptr) {
-      ((Elevator*)elev)->goUp();
-    }
-	}
-
+		m_nInput |= INPUT_UP;
 	if (m_pKeyboard->Down('S'))
-	{
-		if (m_pPlayer->isOnLadder())
-		{
-			m_pPlayer->climbDown();
-		}
-		else if (elev != nullptr) {
-			((Elevator*)elev)->goDown();
-		}
-	}
+		m_nInput |= INPUT_DOWN;
 
-	if (m_pPlayer->m_nSpriteIndex == FIGHTER_SPRITE && state == PLAY_STATE)
-	{
-		if (m_pKeyboard->TriggerDown(VK_SPACE))
-			m_pObjectManager->swingSword();
-		if(m_pKeyboard->TriggerDown('F'))
-			if (m_pTimer->elapsed(m_pPlayer->m_fGunTimer, 1.5f))
-				m_pObjectManager->FireGun(m_pPlayer, BULLET_SPRITE);
-	}
-
-	if (m_pPlayer->m_nSpriteIndex == SHIELD_SPRITE && state == PLAY_STATE)
-	{
-		if (m_pKeyboard->TriggerDown(VK_SPACE))
-			m_pObjectManager->flipShield();
-	}
+	//sword, shield, and gun
+	if (m_pKeyboard->TriggerDown(VK_SPACE))
+		m_nInput |= INPUT_ATTACK;
+	if (m_pKeyboard->TriggerDown('F'))
+		m_nInput |= INPUT_FIRE;
 
   if(m_pKeyboard->TriggerDown(VK_BACK))
     BeginGame();
@@ -170,15 +152,30 @@ void CGame::KeyboardHandler(){
     m_bDrawAABBs = !m_bDrawAABBs;
 
 	//switch active player
-	if (m_pKeyboard->TriggerDown(VK_TAB)){
-		whichPlayer = (whichPlayer + 1) % characters.size();
-		m_pPlayer = characters.at(whichPlayer);
-	}
+	if (m_pKeyboard->TriggerDown(VK_TAB))
+		m_nInput |= INPUT_NEXT_PLAYER;
 
 	if (m_pKeyboard->TriggerDown(VK_F3)) {
 		nextLevel();
 	}
 
+	//start recording a replay, or stop and save it
+	if (m_pKeyboard->TriggerDown(VK_F5) && state == PLAY_STATE) {
+		if (m_cReplay.IsRecording()) {
+			if (m_cReplay.EndRecording())
+				DEBUGPRINTF("Saved replay in %s\n", DEFAULT_REPLAY_FILE);
+		}
+		else m_bStartRecording = true;
+	}
+
+#ifdef PROFILE
+	//save the profile zones recorded so far as a Chrome trace
+	if (m_pKeyboard->TriggerDown(VK_F6)) {
+		if (CProfiler::Save())
+			DEBUGPRINTF("Saved profile in %s\n", DEFAULT_PROFILE_FILE);
+	}
+#endif //PROFILE
+
 	//an efficient way to handle keyboard input in different gamestates
 	switch (state)
 	{
@@ -310,17 +307,15 @@ void CGame::KeyboardHandler(){
     }
   }
 
-	m_pPlayer->m_bInteract = false;
-	if (m_pKeyboard->TriggerDown('E')) {
-		m_pPlayer->m_bInteract = true;
-	}
+	if (m_pKeyboard->TriggerDown('E'))
+		m_nInput |= INPUT_INTERACT;
 } //KeyboardHandler
 
 /// Poll the XBox controller state and respond to the
-/// controls there.
+/// controls there. Anything the player does to the world
+/// is added to m_nInput for the object manager to act on.
 
 void CGame::ControllerHandler(){
-	CObject* elev = m_pObjectManager->isTouchingElevator();
 	if(!m_pController->IsConnected())return;
 
 	m_pController->GetState(); //get state of controller's controls 
@@ -329,36 +324,15 @@ void CGame::ControllerHandler(){
 	if (state == PLAY_STATE)
 	{
 		if (m_pController->GetLThumb().x > .5f)
-		{
-			m_pPlayer->StrafeRight();
-			m_pPlayer->turn(RIGHT);
-		}
+			m_nInput |= INPUT_RIGHT;
 		else if (m_pController->GetLThumb().x < -.5f)
-		{
-			m_pPlayer->StrafeLeft();
-			m_pPlayer->turn(LEFT);
-		}
+			m_nInput |= INPUT_LEFT;
 
 		//up and down
 		if (m_pController->GetLThumb().y > .5f)
-		{
-			if (m_pPlayer->isOnLadder()) {
-				m_pPlayer->climbUp();
-			}
-			else if (elev != nullptr) {
-				((Elevator*)elev)->goUp();
-			}
-		}
+			m_nInput |= INPUT_UP;
 		else if (m_pController->GetLThumb().y < -.5f)
-		{
-			if (m_pPlayer->isOnLadder())
-			{
-				m_pPlayer->climbDown();
-			}
-			else if (elev != nullptr) {
-				((Elevator*)elev)->goDown();
-			}
-		}
+			m_nInput |= INPUT_DOWN;
 	}
 
 	//jump/ abilities
@@ -366,21 +340,11 @@ void CGame::ControllerHandler(){
 	{
 		if (state == PLAY_STATE)
 		{
-			if (m_pPlayer->m_nSpriteIndex == FAST_SPRITE && elev == nullptr) {
-				m_pPlayer->Jump();
-			}
-			else if (m_pPlayer->m_nSpriteIndex == FIGHTER_SPRITE && state == PLAY_STATE)
-			{
-				if (m_pTimer->elapsed(m_pPlayer->m_fGunTimer, 1.5f))
-					m_pObjectManager->FireGun(m_pPlayer, BULLET_SPRITE);
-			}
-			else if (m_pPlayer->m_nSpriteIndex == SHIELD_SPRITE && state == PLAY_STATE)
-			{
-				m_pObjectManager->flipShield();
-			}
-			else if (elev != nullptr) {
-				((Elevator*)elev)->goUp();
-			}
+			if (m_pPlayer->m_nSpriteIndex == FIGHTER_SPRITE)
+				m_nInput |= INPUT_FIRE;
+			else if (m_pPlayer->m_nSpriteIndex == SHIELD_SPRITE)
+				m_nInput |= INPUT_ATTACK; //flip shield
+			else m_nInput |= INPUT_JUMP; //jump, or send elevator up
 		}
 
 		switch (state)
@@ -454,19 +418,14 @@ void CGame::ControllerHandler(){
 	if (m_pController->GetButtonBToggle() && state == PLAY_STATE) // everything for the b button
 	{
 		if (m_pPlayer->m_nSpriteIndex == FIGHTER_SPRITE)
-		{
-			m_pObjectManager->swingSword();
-		}
+			m_nInput |= INPUT_ATTACK; //swing sword
 	}//if b button
 
 	//switch active player and change menu options
 	if (m_pController->GetButtonRSToggle())
 	{
 		if (state == PLAY_STATE)
-		{
-			whichPlayer = (whichPlayer + 1) % characters.size();
-			m_pPlayer = characters.at(whichPlayer);
-		}
+			m_nInput |= INPUT_NEXT_PLAYER;
 
 		switch (state)
 		{
@@ -494,11 +453,7 @@ void CGame::ControllerHandler(){
 	if (m_pController->GetButtonLSToggle())
 	{
 		if (state == PLAY_STATE)
-		{
-			whichPlayer = (whichPlayer - 1) < 0 ? (characters.size() - 1) : (whichPlayer - 1);
-			//whichPlayer = (whichPlayer - 1) % characters.size();
-			m_pPlayer = characters.at(whichPlayer);
-		}
+			m_nInput |= INPUT_PREV_PLAYER;
 
 		switch (state)
 		{
@@ -555,10 +510,8 @@ void CGame::ControllerHandler(){
 	}// if left shoulder toggle
 
 	//interaction
-	m_pPlayer->m_bInteract = false;
-	if (m_pController->GetButtonXToggle() && state == PLAY_STATE) {
-		m_pPlayer->m_bInteract = true;
-	}
+	if (m_pController->GetButtonXToggle() && state == PLAY_STATE)
+		m_nInput |= INPUT_INTERACT;
 } //ControllerHandler
 
 /// Ask the object manager to draw the game objects. RenderWorld
@@ -570,10 +523,10 @@ void CGame::RenderFrame(){
     m_pObjectManager->draw(); 
     m_pParticleEngine->Draw();
 
-    // draw fps
-    string s = to_string(m_pTimer->framerate()) + " fps";
+    // draw fps, with the text in the frame arena
+    const char* s = m_pFrameArena->format("%u fps", m_pTimer->framerate());
     Vector2 pos(m_nWinWidth - 128.0f, 30.0f);
-    m_pRenderer->DrawScreenText(s.c_str(), pos);
+    m_pRenderer->DrawScreenText(s, pos);
 
     //draw hud
 
@@ -600,7 +553,7 @@ void CGame::RenderFrame(){
         case SHIELD_SPRITE: text_pos = shieldPos; break;
       }
       // render the text
-			m_pRenderer->DrawScreenText(std::to_string(p->getHP()).c_str(), text_pos, Colors::Black);
+			m_pRenderer->DrawScreenText(m_pFrameArena->format("%d", p->getHP()), text_pos, Colors::Black);
 		}
 			 
     if (m_pPlayer) {
@@ -651,20 +604,31 @@ void CGame::nextLevel()
 /// thus if it was longer dt it will run another physics calculation
 
 void CGame::ProcessFrame(){
+	PROFILE_SCOPE("CGame::ProcessFrame");
+
 	switch (state) 
 	{
 		case PLAY_STATE:
 		{
+			if (m_bStartRecording)
+				BeginRecording(); //reload level and record from here
+
+			m_nInput = 0; //no input yet
 			KeyboardHandler(); //handle keyboard input
 			ControllerHandler(); //handle controller input
+			m_pObjectManager->ApplyInput(m_nInput); //act on it
 
 			m_pAudio->BeginFrame(); //notify audio player that frame has begun
 			m_pTimer->BeginFrame(); //notify timer that frame has begun
 
-			const float dt = 1 / 60.0f; // timestep
+			m_cReplay.RecordFrame(m_pTimer->time(), m_pTimer->frametime(), m_nInput); //if recording
+
+			const float dt = PHYSICS_STEP; // timestep
 
 			accumulator += m_pTimer->frametime() < 0.0f ? 0.0f : m_pTimer->frametime(); // make sure that is never negative and add it to the accumulator
 
+			m_pObjectManager->ScheduleAI(); //once per frame, not once per step
+
 			//while our accumulator still has a frame time left in it, do another step
 			while (accumulator >= dt) 
 			{
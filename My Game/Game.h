@@ -7,6 +7,7 @@
 #include "Common.h"
 #include "ObjectManager.h"
 #include "Settings.h"
+#include "Replay.h"
 
 /// \brief The game class.
 
@@ -23,12 +24,16 @@ class CGame:
 		int mainMenuIndex = 0; ///< where we are in the main menu
 		int winMenuIndex = 0; ///< where we are in the win menu
 		float accumulator = 0.0f; ///< float for the accumulator in process frame
+    unsigned m_nInput = 0; ///< Player input this frame, a mask of eInput flags.
+    CReplay m_cReplay; ///< Replay recorder.
+    bool m_bStartRecording = false; ///< Whether to start recording next frame.
     vector<eSpriteType> menuOptions; ///< vector of the different menu options
     vector<eSpriteType> pauseOptions; ///< vector of the different pause options
     vector<eSpriteType> loseOptions; ///< vector of the different lose options
 		vector<eSpriteType> winOptions; ///< Vector fo the different win screen options
 
     void BeginGame(); ///< Begin playing the game.
+    void BeginRecording(); ///< Reload the level and record a replay.
     void KeyboardHandler(); ///< The keyboard handler.
     void ControllerHandler(); ///< The controller handler.
     void RenderFrame(); ///< Render an animation frame.
@@ -5,6 +5,32 @@
 
 #include "Defines.h"
 
+#define NUM_LEVELS 5 ///< Number of levels.
+
+const float PHYSICS_STEP = 1/60.0f; ///< Fixed physics time step, in seconds.
+
+/// \brief Player input flags.
+///
+/// The player's input for a frame is a mask of these flags, made from
+/// the keyboard and the controller by CGame and acted on by
+/// CObjectManager::ApplyInput. Replays store the mask, so new flags
+/// must go on the end.
+
+enum eInput{
+  INPUT_LEFT = 1, ///< Move left.
+  INPUT_RIGHT = 1 << 1, ///< Move right.
+  INPUT_STOP_LEFT = 1 << 2, ///< Stopped moving left.
+  INPUT_STOP_RIGHT = 1 << 3, ///< Stopped moving right.
+  INPUT_JUMP = 1 << 4, ///< Jump, or send an elevator up.
+  INPUT_UP = 1 << 5, ///< Climb up a ladder or ride an elevator up.
+  INPUT_DOWN = 1 << 6, ///< Climb down a ladder or ride an elevator down.
+  INPUT_ATTACK = 1 << 7, ///< Swing the sword or flip the shield.
+  INPUT_FIRE = 1 << 8, ///< Fire the gun.
+  INPUT_NEXT_PLAYER = 1 << 9, ///< Switch to the next character.
+  INPUT_PREV_PLAYER = 1 << 10, ///< Switch to the previous character.
+  INPUT_INTERACT = 1 << 11 ///< Interact with a switch or a door.
+}; //eInput
+
 /// \brief Sprite type.
 ///
 /// Note: NUM_SPRITES must be last.
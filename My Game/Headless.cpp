@@ -0,0 +1,1356 @@
+/// \file Headless.cpp 
+/// \brief Every program has to have a main, even a headless one.
+///
+/// This is the main file for a headless build, which plays a level
+/// without a window, Direct3D 12, or XAudio2, and so can be built and
+/// run anywhere, including on Linux, for example to soak test the
+/// simulation or to measure how fast it runs. It is not part of the
+/// Visual Studio build. To make a headless build, define HEADLESS and
+/// compile the game's .cpp files except for Main.cpp and Game.cpp,
+/// together with the following files from the Engine's Src folder:
+/// Abort.cpp, Component.cpp, FrameArena.cpp, HeadlessSpriteRenderer.cpp,
+/// Helpers.cpp, Particle.cpp, ParticleEngine.cpp, ParticleKernel.cpp,
+/// Profiler.cpp, Random.cpp, Settings.cpp, Sprite.cpp, SpriteDesc.cpp, Timer.cpp,
+/// and tinyxml2.cpp. The include path needs the Engine's Inc folder,
+/// DirectXMath, SimpleMath.h from DirectXTK 12, and on anything other
+/// than Windows, sal.h from the DirectX-Headers project. For example,
+/// with g++ from the folder that contains the Engine and the game,
+/// all on one line,
+/// \verbatim
+/// g++ -std=c++14 -O2 -DHEADLESS -ILARCEngine/Inc -I"My Game"
+///   -I<DirectXMath>/Inc -I<DirectXTK12>/Inc -I<DirectX-Headers>/include/wsl/stubs
+///   <game files> <engine files> -o headless
+/// \endverbatim
+/// Run it from the folder that contains the Media folder, which is
+/// where the Windows build runs from too.
+///
+/// Usage: headless [-level n | -map file] [-seed n] [-steps n] [-script] [-replay file]
+///   [-check] [-hashes file] [-compare file] [-checkalloc] [-checkvis n] [-checkcull n] [-checkmesh] [-checkkernels] [-benchbroad] [-benchkernels] [-bench file]
+///   [-generate file [-width n] [-height n] [-density x]] [-profile file]
+///
+/// With -replay it plays back a replay recorded with the F5 key in the
+/// Windows build instead of playing a level with no input, and with
+/// -script it drives the characters with a scripted input track. The world is
+/// hashed after every step if asked to check determinism: -check plays
+/// the same thing twice, loading the level fresh the first time and
+/// restoring it from the object manager's snapshot the second, and
+/// reports the first step at which the hashes differ, -hashes saves the hashes to a file, and -compare reports the
+/// first step at which they differ from ones saved earlier, for example
+/// by a build from before an optimization. Hashing takes time, so leave
+/// these out when measuring speed. With -checkalloc it counts the heap
+/// allocations made by each step and fails if any step after the first
+/// STEP_ALLOCATION_WARMUP makes one, since once the scratch space has
+/// filled up a step shouldn't allocate anything. Hashing allocates, so
+/// this can't be combined with the hash checks.
+///
+/// With -checkvis it loads every level in turn, or just the one given
+/// with -map, and instead of playing it casts the given number of random
+/// sight lines and reports how often Visible() agrees with the old
+/// triangle test that it replaced, and what the potentially visible set
+/// made of them. It fails if the potentially visible set hides anything
+/// that the rays could see.
+///
+/// With -checkcull it loads every level in turn, or just the one given
+/// with -map, and instead of playing it creates twice the given number
+/// of objects, kills half of them in a single step, and checks that once
+/// they have been culled every list is consistent, every recorded index
+/// is right, and no dead object is left on any list. Use 1000 or more.
+///
+/// With -checkmesh it makes square levels of MESH_MIN_SIZE to MESH_MAX_SIZE
+/// tiles with the level generator instead, and for each one checks that
+/// the wall AABBs cover the wall tiles exactly, counts them, and times how
+/// long they take to make, comparing with the old way of making them.
+///
+/// With -checkkernels it steps random particles with the scalar, SSE2,
+/// and AVX2 particle kernels for every feature mask instead, and fails
+/// if any of them disagrees with CParticle's move, rescale, and fade.
+///
+/// With -benchbroad it scatters BROAD_MIN_OBJECTS to BROAD_MAX_OBJECTS
+/// objects of its own at random instead, and times how long the spatial
+/// grid takes to find the pairs of them that touch, against trying every
+/// pair. It fails if they don't find the same number of pairs.
+///
+/// With -benchkernels it times the particle engine's step function with
+/// the best kernel that the CPU supports for every feature mask instead,
+/// and reports particles per second for each, compared with the full mask.
+///
+/// With -bench it benchmarks every level in turn instead, loading it
+/// fresh LOAD_REPEATS times and then playing it with the scripted input track,
+/// or with a replay if one was given for that level with -replay, which
+/// can be repeated. The mean, median, 95th and 99th percentile times in
+/// microseconds for each step of CObjectManager::move, BroadPhase, and
+/// CullDeadObjects, for each particle step, and for each level load are
+/// written to the given file as JSON, along with the number of bullets
+/// that had to be removed to make room in a full projectile pool.
+///
+/// With -map it plays, or benchmarks, a level image of its own instead
+/// of one of the game's levels, for example one made with -generate,
+/// which writes a level image made by CLevelGenerator from the seed,
+/// the size in tiles, and a density scale, then stops. Generated levels
+/// can be much bigger and busier than the game's, which makes them good
+/// for finding out how the engine copes with big levels.
+///
+/// With -profile it saves the most recent PROFILE_SCOPE zones as a
+/// Chrome trace when it is done, which needs PROFILE to be defined
+/// in Profiler.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "HeadlessGame.h"
+#include "HeapCheck.h"
+#include "Benchmark.h"
+#include "LevelGenerator.h"
+#include "Profiler.h"
+#include "Particle.h"
+#include "ParticleKernel.h"
+#include "ParticleEngine.h"
+
+using namespace std;
+
+const int LOAD_REPEATS = 10; ///< Number of times each level is loaded for the benchmark.
+const int MESH_MIN_SIZE = 256; ///< Width and height in tiles of the smallest level in the meshing check.
+const int MESH_MAX_SIZE = 4096; ///< Width and height in tiles of the biggest level in the meshing check.
+const int MESH_REPEATS = 5; ///< Number of times each level is meshed in the meshing check.
+const float MESH_TILE_SIZE = 32.0f; ///< Tile size for the meshing check, as in the game.
+const int MESH_OLD_MAX_SIZE = 4096; ///< Biggest level that the old way is tried on in the meshing check.
+const int MESH_OLD_MAX_NOISY = 1024; ///< Biggest noisy level that the old way is tried on in the meshing check.
+const float MESH_NOISE = 0.1f; ///< Fraction of open tiles walled in for the noisy levels in the meshing check.
+const int BROAD_MIN_OBJECTS = 100; ///< Fewest objects in the broad phase benchmark.
+const int BROAD_MAX_OBJECTS = 10000; ///< Most objects in the broad phase benchmark.
+const int BROAD_REPEATS = 5; ///< Number of times each broad phase is timed in the broad phase benchmark.
+const float BROAD_CELL_SIZE = 32.0f; ///< Grid cell size for the broad phase benchmark, one tile as in the game.
+const float BROAD_SPACING = 48.0f; ///< Width and height in pixels of the space per object in the broad phase benchmark.
+const size_t KERNEL_PARTICLES = 1003; ///< Particles in the kernel check, not a multiple of 8 so that the tails get checked too.
+const int KERNEL_STEPS = 10; ///< Steps taken in the kernel check.
+const float KERNEL_TOLERANCE = 1.0e-5f; ///< Relative error allowed in the kernel check.
+const size_t KERNEL_BENCH_PARTICLES = 100000; ///< Particles in the kernel benchmark.
+const int KERNEL_BENCH_STEPS = 100; ///< Steps timed in each run of the kernel benchmark.
+const int KERNEL_BENCH_REPEATS = 5; ///< Runs of the kernel benchmark for each feature mask.
+
+static CHeadlessGame g_cGame; ///< The headless game class.
+
+/// Get the input for a step of the scripted input track, which repeats
+/// every eight seconds of game time. The character walks right for
+/// half of it and left for the other half, jumps and interacts now and
+/// then, holds up then down at the end of each walk so as to use any
+/// ladder or elevator nearby, attacks and fires every couple of seconds,
+/// and hands over to the next character at the end.
+/// \param step Step number.
+/// \return Mask of eInput flags.
+
+static unsigned ScriptedInput(unsigned step){
+  const unsigned t = step%480; //steps into the eight second cycle
+  const unsigned walk = t%240; //steps into this walk
+  unsigned input = 0;
+
+  if(walk < 180)input |= t < 240? INPUT_RIGHT: INPUT_LEFT;
+  else if(walk == 180)input |= t < 240? INPUT_STOP_RIGHT: INPUT_STOP_LEFT;
+  else if(walk < 210)input |= INPUT_UP;
+  else input |= INPUT_DOWN;
+
+  if(t%45 == 0)input |= INPUT_JUMP;
+  if(t%60 == 30)input |= INPUT_INTERACT;
+  if(t%120 == 90)input |= INPUT_ATTACK;
+  if(t%160 == 100)input |= INPUT_FIRE;
+  if(t == 479)input |= INPUT_NEXT_PLAYER;
+
+  return input;
+} //ScriptedInput
+
+/// Play a level from the start, or a replay if there is one.
+/// \param replay Pointer to a replay, or nullptr to play a level.
+/// \param level Level number, if there is no replay.
+/// \param mapfile Level image file name, or nullptr for the level's own.
+/// \param seed PRNG seed, if there is no replay.
+/// \param steps Maximum number of steps, if there is no replay.
+/// \param script Whether to use the scripted input track, if there is no replay.
+/// \param hashes [OUT] If not nullptr, the world hash after each step is appended to this.
+/// \param allocs [OUT] If not nullptr, the number of heap allocations made by each step,
+///   or by each frame of a replay, is appended to this.
+
+static void run(CReplay* replay, int level, const char* mapfile, int seed, unsigned steps,
+  bool script, vector<unsigned>* hashes, vector<unsigned>* allocs=nullptr)
+{
+  if(replay){
+    g_cGame.BeginReplay(*replay);
+
+    for(size_t i=0; i<replay->GetNumFrames(); i++){
+      const size_t n = GetAllocationCount();
+      g_cGame.PlayFrame(replay->GetFrame(i), hashes);
+
+      if(allocs)
+        allocs->push_back((unsigned)(GetAllocationCount() - n));
+    } //for
+  } //if
+
+  else{
+    g_cGame.BeginLevel(level, seed, mapfile);
+
+    while(g_cGame.GetStepCount() < steps && g_cGame.IsPlaying()){
+      const size_t n = GetAllocationCount();
+      g_cGame.step(script? ScriptedInput(g_cGame.GetStepCount()): 0, hashes);
+
+      if(allocs)
+        allocs->push_back((unsigned)(GetAllocationCount() - n));
+    } //while
+  } //else
+} //run
+
+/// Check that none of the steps after the first STEP_ALLOCATION_WARMUP,
+/// during which the scratch space fills up, made a heap allocation,
+/// and report the ones that did.
+/// \param allocs Number of heap allocations made by each step, or by each frame of a replay.
+/// \return true if there were no heap allocations after the warm up.
+
+static bool CheckAllocations(const vector<unsigned>& allocs){
+  unsigned bad = 0; //number of steps that allocated
+  unsigned total = 0; //number of allocations that they made
+  unsigned most = 0; //most allocations made by one of them
+  size_t first = 0; //first one of them
+
+  for(size_t i=STEP_ALLOCATION_WARMUP; i<allocs.size(); i++)
+    if(allocs[i] > 0){
+      if(bad++ == 0)first = i;
+      total += allocs[i];
+      most = max(most, allocs[i]);
+    } //if
+
+  const unsigned n = allocs.size() > STEP_ALLOCATION_WARMUP?
+    (unsigned)allocs.size() - STEP_ALLOCATION_WARMUP: 0; //steps checked
+
+  if(bad == 0)
+    printf("No heap allocations in %u steps after the first %u\n", n, STEP_ALLOCATION_WARMUP);
+
+  else printf("%u of %u steps after the first %u made %u heap allocations,"
+    " at most %u in one step, the first at step %u\n",
+    bad, n, STEP_ALLOCATION_WARMUP, total, most, (unsigned)first);
+
+  return bad == 0;
+} //CheckAllocations
+
+/// Save world hashes to a text file, one per line in hex.
+/// \param filename File name.
+/// \param hashes World hashes.
+/// \return true if the file was written.
+
+static bool SaveHashes(const char* filename, const vector<unsigned>& hashes){
+  FILE* fp = nullptr;
+  fopen_s(&fp, filename, "wt");
+  if(fp == nullptr)return false;
+
+  for(auto const& h: hashes)
+    fprintf(fp, "%08X\n", h);
+
+  fclose(fp);
+  return true;
+} //SaveHashes
+
+/// Load world hashes saved by SaveHashes.
+/// \param filename File name.
+/// \param hashes [OUT] World hashes.
+/// \return true if the file was read.
+
+static bool LoadHashes(const char* filename, vector<unsigned>& hashes){
+  FILE* fp = nullptr;
+  fopen_s(&fp, filename, "rt");
+  if(fp == nullptr)return false;
+
+  unsigned h;
+
+  while(fscanf(fp, "%x", &h) == 1)
+    hashes.push_back(h);
+
+  fclose(fp);
+  return true;
+} //LoadHashes
+
+/// Compare two sequences of world hashes and report the first step
+/// at which they differ, if any.
+/// \param a World hashes from this run.
+/// \param b World hashes to compare them with.
+/// \param name What b came from, for the report.
+/// \return true if they are the same.
+
+static bool CompareHashes(const vector<unsigned>& a, const vector<unsigned>& b, const char* name){
+  const size_t n = min(a.size(), b.size());
+
+  for(size_t i=0; i<n; i++)
+    if(a[i] != b[i]){
+      printf("Diverged from %s at step %u: %08X here, %08X there\n",
+        name, (unsigned)i, a[i], b[i]);
+      return false;
+    } //if
+
+  if(a.size() != b.size()){
+    printf("Same as %s for %u steps, but %u steps instead of %u\n",
+      name, (unsigned)n, (unsigned)a.size(), (unsigned)b.size());
+    return false;
+  } //if
+
+  printf("Same as %s for all %u steps, final hash %08X\n",
+    name, (unsigned)n, n > 0? a.back(): 0);
+  return true;
+} //CompareHashes
+
+/// Benchmark every level, or just a level image of our own, and write
+/// the results to a JSON file.
+/// \param filename File name.
+/// \param replays Replays, at most one per level, to use instead of the scripted input track.
+/// \param mapfile Level image file name, or nullptr for all of the game's levels.
+/// \param seed PRNG seed, for levels without a replay.
+/// \param steps Maximum number of steps, for levels without a replay.
+/// \return true if the file was written.
+
+static bool bench(const char* filename, vector<CReplay>& replays, const char* mapfile,
+  int seed, unsigned steps)
+{
+  FILE* fp = nullptr;
+  fopen_s(&fp, filename, "wt");
+  if(fp == nullptr)return false;
+
+  fprintf(fp, "{\n  \"units\": \"microseconds\",\n  \"seed\": %d,\n  \"steps\": %u,\n"
+    "  \"load_repeats\": %d,\n  \"levels\": [\n", seed, steps, LOAD_REPEATS);
+
+  CBenchmark benchmark;
+
+  const int first = mapfile? NUM_LEVELS: 0; //first level to benchmark
+  const int last = mapfile? NUM_LEVELS: NUM_LEVELS - 1; //last level to benchmark
+
+  for(int level=first; level<=last; level++){ //for each level
+    CReplay* pReplay = nullptr; //replay for this level, if any
+
+    for(auto& r: replays)
+      if(r.GetLevel() == level)
+        pReplay = &r;
+
+    benchmark.clear();
+    benchmark.reserve(pReplay? 2*pReplay->GetNumFrames() + LOAD_REPEATS: steps + LOAD_REPEATS); //about two steps per frame at 30 fps
+    g_cGame.SetBenchmark(&benchmark);
+
+    for(int i=0; i<LOAD_REPEATS; i++){ //the last of these is the one played
+      g_cGame.UnloadLevel(); //so that it is loaded, not restored
+      g_cGame.BeginLevel(level, seed, mapfile);
+    } //for
+
+    run(pReplay, level, mapfile, seed, steps, true, nullptr);
+    g_cGame.SetBenchmark(nullptr);
+
+    const char* mapname = mapfile? mapfile: CObjectManager::GetMapFileName(level);
+    const char* slash = strrchr(mapname, '/');
+
+    fprintf(fp, "    {\n      \"level\": %d,\n      \"map\": \"%s\",\n"
+      "      \"input\": \"%s\",\n      \"steps\": %u,\n      \"finished\": %s,\n"
+      "      \"projectile_evictions\": %u,\n      \"timers\": ",
+      level, slash? slash + 1: mapname, pReplay? "replay": "scripted",
+      g_cGame.GetStepCount(), g_cGame.IsPlaying()? "false": "true", g_cGame.GetEvictionCount());
+
+    benchmark.WriteJSON(fp, "        ");
+    fprintf(fp, "\n    }%s\n", level < last? ",": "");
+
+    printf("Level %d: %u steps, move %.2f us mean, %.2f us p99\n", level,
+      g_cGame.GetStepCount(), benchmark.GetMean(MOVE_TIMER), benchmark.GetPercentile(MOVE_TIMER, 99.0));
+  } //for
+
+  fprintf(fp, "  ]\n}\n");
+  fclose(fp);
+  return true;
+} //bench
+
+/// Compare Visible(), the potentially visible set, and the triangle test
+/// that Visible() replaced on random sight lines in every level, or just
+/// in a level image of our own, and report what they made of them.
+/// \param n Number of sight lines per level.
+/// \param seed Seed for the random sight lines.
+/// \param mapfile Level image file name, or nullptr for all of the game's levels.
+/// \return true if the potentially visible set never hid what the rays could see.
+
+static bool CheckVisibility(unsigned n, int seed, const char* mapfile){
+  const int first = mapfile? NUM_LEVELS: 0; //first level to check
+  const int last = mapfile? NUM_LEVELS: NUM_LEVELS - 1; //last level to check
+
+  VisibilityCheck total; //sums over all levels
+
+  for(int level=first; level<=last; level++){ //for each level
+    VisibilityCheck c;
+    g_cGame.BeginLevel(level, seed, mapfile);
+    g_cGame.CheckVisibility(n, seed, c);
+
+    const unsigned agree = c.m_nLines - c.m_nOnlyRays - c.m_nOnlyTriangles;
+    const unsigned hidden = c.m_nLines - c.m_nSeen;
+
+    printf("Level %d: %u sight lines, %u seen by Visible(), %u by VisibleTriangles()\n",
+      level, c.m_nLines, c.m_nSeen, c.m_nSeenTriangles);
+    printf("  Agree on %u (%.2f%%), %u seen only by Visible(), %u only by VisibleTriangles()\n",
+      agree, 100.0*agree/max(c.m_nLines, 1U), c.m_nOnlyRays, c.m_nOnlyTriangles);
+    printf("  Potentially visible set ruled out %u of %u hidden without casting rays (%.1f%%), %u wrongly\n",
+      c.m_nRejected, hidden, 100.0*c.m_nRejected/max(hidden, 1U), c.m_nWronglyHidden);
+
+    total.m_nLines += c.m_nLines;
+    total.m_nOnlyRays += c.m_nOnlyRays;
+    total.m_nOnlyTriangles += c.m_nOnlyTriangles;
+    total.m_nWronglyHidden += c.m_nWronglyHidden;
+  } //for
+
+  if(last > first){
+    const unsigned agree = total.m_nLines - total.m_nOnlyRays - total.m_nOnlyTriangles;
+
+    printf("All levels: agree on %u of %u (%.2f%%), %u wrongly hidden\n",
+      agree, total.m_nLines, 100.0*agree/max(total.m_nLines, 1U), total.m_nWronglyHidden);
+  } //if
+
+  return total.m_nWronglyHidden == 0;
+} //CheckVisibility
+
+/// Kill many objects in a single step in every level, or just in a level
+/// image of our own, and check that culling them left the object list,
+/// the typed lists, and the active list consistent.
+/// \param n Number of objects to kill in each level.
+/// \param seed Seed for the positions and the killing order.
+/// \param mapfile Level image file name, or nullptr for all of the game's levels.
+/// \return true if the lists were always consistent.
+
+static bool CheckCulling(unsigned n, int seed, const char* mapfile){
+  const int first = mapfile? NUM_LEVELS: 0; //first level to check
+  const int last = mapfile? NUM_LEVELS: NUM_LEVELS - 1; //last level to check
+
+  bool ok = true; //whether all checks passed
+
+  for(int level=first; level<=last; level++){ //for each level
+    CullCheck c;
+    g_cGame.BeginLevel(level, seed, mapfile);
+    g_cGame.CheckCulling(n, seed, c);
+
+    printf("Level %d: %u objects killed in one step, %u left on the object list\n",
+      level, c.m_nKilled, c.m_nSurvivors);
+    printf("  %u dead objects left behind, %u wrong slots, %u on the wrong lists\n",
+      c.m_nLeftBehind, c.m_nBadSlots, c.m_nMissing);
+
+    ok = ok && c.m_nLeftBehind == 0 && c.m_nBadSlots == 0 && c.m_nMissing == 0;
+  } //for
+
+  g_cGame.UnloadLevel(); //the survivors aren't part of the level
+
+  return ok;
+} //CheckCulling
+
+/// \brief Results of CheckBoundingBoxes().
+///
+/// The number of wall AABBs, and counts of the ways in which they fail
+/// to cover the wall tiles exactly.
+
+struct MeshCheck{
+  unsigned m_nBoxes = 0; ///< Number of AABBs.
+  unsigned m_nMissing = 0; ///< Wall tiles not in any AABB.
+  unsigned m_nOutside = 0; ///< Tiles in an AABB that aren't walls, or AABBs that stick out of the map.
+  unsigned m_nOverlaps = 0; ///< Tiles in more than one AABB, counted once for each extra AABB.
+}; //MeshCheck
+
+/// Make the AABBs for the walls of a map the old way, which
+/// CTileManager::MakeBoundingBoxes() replaced, for comparison only. Runs
+/// of two or more wall tiles down each column and then along each row are
+/// made into AABBs, each of which is merged with an earlier one of the
+/// same height or width next to it if there is one, which is found by
+/// searching all of them. What is left over is given an AABB a tile,
+/// except on the edges of the map, which are missed. This works on a copy
+/// of the map, with row 0 at the top, and leaves the tile manager alone.
+/// \param tiles Tile manager with a map loaded.
+/// \param walls [OUT] AABBs for the walls.
+
+static void MakeBoundingBoxesByRuns(const CTileManager& tiles, vector<BoundingBox>& walls){
+  const int w = tiles.GetWidth();
+  const int h = tiles.GetHeight();
+  const float size = tiles.GetTileSize();
+
+  vector<bool> map(w*h); //which tiles are walls, by row from the top
+  vector<bool> used(w*h, false); //which walls have been used in an AABB already
+
+  for(int i=0; i<h; i++)
+    for(int j=0; j<w; j++)
+      map[i*w + j] = tiles.IsWall(j, h - 1 - i);
+
+  auto wall = [&](int i, int j){ //whether a tile is a wall not yet used
+    return map[i*w + j] && !used[i*w + j];
+  }; //wall
+
+  walls.clear(); //no walls yet
+
+  BoundingBox aabb; //current bounding box
+  const Vector3 vTileExtents = 0.5f*Vector3(size, size, size);
+
+  //vertical walls with more than one tile
+  const Vector2 vstart = Vector2(size, size)/2 + Vector2(0, size*(h - 1)); //start position
+  Vector2 pos = vstart; //current position
+
+  for(int j=0; j<w; j++){
+    int i = 0;
+    pos.y = vstart.y;
+
+    while(i < h){
+      while(i < h && !wall(i, j)){
+        i++; pos.y -= size;
+      } //while
+
+      if(i < h){
+        aabb.Center = Vector3(pos.x, pos.y, 0);
+        aabb.Extents = vTileExtents;
+        used[i*w + j] = true;
+        const int single = i*w + j; //the tile, in case it is on its own
+        i++; pos.y -= size;
+
+        bool bSingleTile = true;
+
+        while(i < h && wall(i, j)){
+          BoundingBox b;
+          b.Center = Vector3(pos.x, pos.y, 0);
+          b.Extents = vTileExtents;
+          BoundingBox::CreateMerged(aabb, aabb, b);
+          used[i*w + j] = true;
+          bSingleTile = false;
+          i++; pos.y -= size;
+        } //while
+
+        if(bSingleTile)
+          used[single] = false; //leave it for the rows
+
+        else{
+          bool merged = false;
+
+          //merge with an earlier AABB of the same height next to it, if any
+          for(auto& b: walls)
+            if(b.Center.y == aabb.Center.y && b.Extents.y == aabb.Extents.y &&
+              b.Center.x + b.Extents.x == aabb.Center.x - aabb.Extents.x)
+            {
+              BoundingBox::CreateMerged(b, b, aabb);
+              merged = true;
+              break;
+            } //if
+
+          if(!merged)
+            walls.push_back(aabb);
+        } //else
+      } //if
+    } //while
+
+    pos.x += size;
+  } //for
+
+  //horizontal walls with more than one tile
+  pos = vstart;
+
+  for(int i=0; i<h; i++){
+    int j = 0;
+    pos.x = vstart.x;
+
+    while(j < w){
+      while(j < w && !wall(i, j)){
+        j++; pos.x += size;
+      } //while
+
+      if(j < w){
+        aabb.Center = Vector3(pos.x, pos.y, 0);
+        aabb.Extents = vTileExtents;
+        used[i*w + j] = true;
+        const int single = i*w + j; //the tile, in case it is on its own
+        j++; pos.x += size;
+
+        bool bSingleTile = true;
+
+        while(j < w && wall(i, j)){
+          BoundingBox b;
+          b.Center = Vector3(pos.x, pos.y, 0);
+          b.Extents = vTileExtents;
+          BoundingBox::CreateMerged(aabb, aabb, b);
+          used[i*w + j] = true;
+          bSingleTile = false;
+          j++; pos.x += size;
+        } //while
+
+        if(bSingleTile)
+          used[single] = false; //leave it for the orphans
+
+        else{
+          bool merged = false;
+
+          //merge with an earlier AABB of the same width next to it, if any
+          for(auto& b: walls)
+            if(b.Center.x == aabb.Center.x && b.Extents.x == aabb.Extents.x &&
+              b.Center.y - b.Extents.y == aabb.Center.y + aabb.Extents.y)
+            {
+              BoundingBox::CreateMerged(b, b, aabb);
+              merged = true;
+              break;
+            } //if
+
+          if(!merged)
+            walls.push_back(aabb);
+        } //else
+      } //if
+    } //while
+
+    pos.y -= size;
+  } //for
+
+  //orphaned single tiles that are not on an edge
+  pos = vstart + Vector2(size, -size);
+
+  for(int i=1; i<h - 1; i++){
+    for(int j=1; j<w - 1; j++){
+      if(wall(i, j)){
+        BoundingBox b;
+        b.Center = Vector3(pos.x, pos.y, 0);
+        b.Extents = vTileExtents;
+        walls.push_back(b);
+      } //if
+
+      pos.x += size;
+    } //for
+
+    pos.x = vstart.x + size;
+    pos.y -= size;
+  } //for
+} //MakeBoundingBoxesByRuns
+
+/// Check that some wall AABBs cover the wall tiles of a map exactly, that
+/// is, that every wall tile is in exactly one AABB and no AABB covers
+/// anything but wall tiles. This takes time and memory in proportion to
+/// the size of the map and the area of the AABBs.
+/// \param tiles Tile manager with a map loaded.
+/// \param walls AABBs for the walls.
+/// \param check [OUT] The number of AABBs, and what is wrong with them.
+
+static void CheckBoundingBoxes(const CTileManager& tiles, const vector<BoundingBox>& walls, MeshCheck& check){
+  const int w = tiles.GetWidth();
+  const int h = tiles.GetHeight();
+  const float size = tiles.GetTileSize();
+
+  check = MeshCheck();
+  check.m_nBoxes = (unsigned)walls.size();
+
+  vector<unsigned char> covered(w*h, 0); //AABBs covering each tile, up to 2
+
+  for(auto const& b: walls){
+    const int x0 = (int)roundf((b.Center.x - b.Extents.x)/size); //tiles covered
+    const int y0 = (int)roundf((b.Center.y - b.Extents.y)/size);
+    const int x1 = (int)roundf((b.Center.x + b.Extents.x)/size);
+    const int y1 = (int)roundf((b.Center.y + b.Extents.y)/size);
+
+    for(int y=max(y0, 0); y<min(y1, h); y++)
+      for(int x=max(x0, 0); x<min(x1, w); x++){
+        unsigned char& n = covered[y*w + x];
+
+        if(n > 0)check.m_nOverlaps++;
+        else n = 1;
+
+        if(!tiles.IsWall(x, y))check.m_nOutside++;
+      } //for
+
+    if(x0 < 0 || y0 < 0 || x1 > w || y1 > h)
+      check.m_nOutside++; //off the map
+  } //for
+
+  for(int y=0; y<h; y++)
+    for(int x=0; x<w; x++)
+      if(tiles.IsWall(x, y) && covered[y*w + x] == 0)
+        check.m_nMissing++;
+} //CheckBoundingBoxes
+
+/// Check that the wall AABBs made by MakeBoundingBoxes() cover the wall
+/// tiles exactly, compare their number with the old way that it replaced,
+/// and time both, on square levels made by the level generator from
+/// MESH_MIN_SIZE to MESH_MAX_SIZE tiles wide. Generated levels are all
+/// long straight walls, so each is also tried with a fraction MESH_NOISE
+/// of its open tiles walled in at random, which makes walls of every
+/// shape. The new way is timed at its best of MESH_REPEATS runs. The old
+/// way, which takes time quadratic in the number of wall runs, is timed
+/// once, and only up to MESH_OLD_MAX_SIZE, or MESH_OLD_MAX_NOISY with noise.
+/// \param seed Seed for the level generator and the noise.
+/// \return true if the AABBs always covered the wall tiles exactly.
+
+static bool CheckMeshing(int seed){
+  CTileManager tiles((size_t)MESH_TILE_SIZE);
+  MeshCheck c, old; //results for the new and old ways
+  vector<BoundingBox> walls; //AABBs made the old way
+  bool ok = true; //whether all checks passed
+
+  CRandom random;
+  random.srand(seed);
+
+  for(int n=MESH_MIN_SIZE; n<=MESH_MAX_SIZE; n*=2) //for each size
+    for(int noisy=0; noisy<2; noisy++){ //without and with noise
+      CLevelDesc desc;
+      desc.m_nWidth = desc.m_nHeight = n;
+      desc.m_nSeed = seed;
+
+      CLevelGenerator generator;
+
+      if(!generator.Generate(desc)){
+        fprintf(stderr, "Cannot generate a %d by %d level.\n", n, n);
+        return false;
+      } //if
+
+      vector<unsigned char> pixels(generator.GetPixels(), generator.GetPixels() + 3*n*n);
+
+      if(noisy)
+        for(size_t i=0; i<pixels.size(); i+=3)
+          if(random.randf() < MESH_NOISE)
+            pixels[i] = pixels[i + 1] = pixels[i + 2] = 0; //black is wall
+
+      tiles.LoadMapFromPixels(pixels.data(), n, n, 3);
+
+      int64_t best = INT64_MAX; //fastest time for the new way
+
+      for(int i=0; i<MESH_REPEATS; i++){
+        const int64_t start = CProfileClock::now();
+        tiles.MakeBoundingBoxes();
+        best = min(best, CProfileClock::now() - start);
+      } //for
+
+      CheckBoundingBoxes(tiles, tiles.GetWalls(), c);
+      ok = ok && c.m_nMissing == 0 && c.m_nOutside == 0 && c.m_nOverlaps == 0;
+
+      printf("%d by %d%s: %u AABBs in %.2f ms\n", n, n, noisy? " with noise": "",
+        c.m_nBoxes, best/1000000.0);
+      printf("  %u wall tiles missed, %u other tiles covered, %u overlaps\n",
+        c.m_nMissing, c.m_nOutside, c.m_nOverlaps);
+
+      if(n <= (noisy? MESH_OLD_MAX_NOISY: MESH_OLD_MAX_SIZE)){ //old way, if it finishes in reasonable time
+        const int64_t start = CProfileClock::now();
+        MakeBoundingBoxesByRuns(tiles, walls);
+        const int64_t t = CProfileClock::now() - start;
+
+        CheckBoundingBoxes(tiles, walls, old);
+
+        printf("  Old way %u AABBs in %.2f ms, %u wall tiles missed, %u other tiles covered, %u overlaps\n",
+          old.m_nBoxes, t/1000000.0, old.m_nMissing, old.m_nOutside, old.m_nOverlaps);
+      } //if
+    } //for
+
+  return ok;
+} //CheckMeshing
+
+/// Count the pairs of objects whose AABBs intersect, finding them
+/// the way that CObjectManager::BroadPhase does, with a spatial grid.
+/// \param grid Spatial grid, with every object filed in it.
+/// \param objects Objects.
+/// \param neighbors Scratch space for neighbors.
+/// \return Number of intersecting pairs.
+
+static unsigned CountPairsByGrid(CSpatialGrid& grid, vector<CObject*>& objects,
+  vector<CObject*>& neighbors)
+{
+  unsigned n = 0; //number of pairs
+
+  for(auto const& p: objects){
+    grid.GetNeighbors(p, neighbors);
+
+    for(auto const& q: neighbors)
+      if(q > p && p->GetBoundingBox().Intersects(q->GetBoundingBox())) //so that each pair is counted once
+        n++;
+  } //for
+
+  return n;
+} //CountPairsByGrid
+
+/// Count the pairs of objects whose AABBs intersect by trying every pair,
+/// which is what the broad phase did before it had a spatial grid.
+/// \param objects Objects.
+/// \return Number of intersecting pairs.
+
+static unsigned CountPairsByBruteForce(vector<CObject*>& objects){
+  unsigned n = 0; //number of pairs
+
+  for(size_t i=0; i<objects.size(); i++)
+    for(size_t j=i + 1; j<objects.size(); j++)
+      if(objects[i]->GetBoundingBox().Intersects(objects[j]->GetBoundingBox()))
+        n++;
+
+  return n;
+} //CountPairsByBruteForce
+
+/// Benchmark the spatial grid broad phase against trying every pair on
+/// BROAD_MIN_OBJECTS to BROAD_MAX_OBJECTS objects scattered at random
+/// over a square with room for BROAD_SPACING pixels each way per object,
+/// so that crowding is the same whatever the number of objects. The grid
+/// is timed from empty, filing every object and then finding the pairs.
+/// Each way is timed at its best of BROAD_REPEATS runs, and they have to
+/// find the same number of pairs.
+/// \param seed Seed for the object positions.
+/// \return true if both ways always found the same number of pairs.
+
+static bool BenchBroadPhase(int seed){
+  CRandom random;
+  random.srand(seed);
+
+  CSpatialGrid grid(BROAD_CELL_SIZE, 4096); //as big as the game's
+  vector<CObject*> neighbors; //scratch space
+  bool ok = true; //whether all checks passed
+
+  for(int n=BROAD_MIN_OBJECTS; n<=BROAD_MAX_OBJECTS; n*=10) //for each number of objects
+    for(int m: {n, 3*n}){ //and three times as many, to fill in between
+      if(m > BROAD_MAX_OBJECTS)break;
+
+      const float w = sqrtf((float)m)*BROAD_SPACING; //width and height of the square
+      vector<CObject*> objects(m);
+
+      for(auto& p: objects)
+        p = new CObject(FIGHTER_SPRITE, Vector2(w*random.randf(), w*random.randf()));
+
+      unsigned gridpairs = 0, pairs = 0; //pairs found by each way
+      int64_t gridbest = INT64_MAX, best = INT64_MAX; //fastest times for each way
+
+      for(int i=0; i<BROAD_REPEATS; i++){
+        int64_t start = CProfileClock::now();
+
+        grid.clear();
+
+        for(auto const& p: objects)
+          grid.update(p);
+
+        gridpairs = CountPairsByGrid(grid, objects, neighbors);
+        gridbest = min(gridbest, CProfileClock::now() - start);
+
+        start = CProfileClock::now();
+        pairs = CountPairsByBruteForce(objects);
+        best = min(best, CProfileClock::now() - start);
+
+        for(auto const& p: objects) //so that they are filed afresh next time
+          grid.remove(p);
+      } //for
+
+      printf("%d objects: grid %u pairs in %.1f us, every pair %u pairs in %.1f us\n",
+        m, gridpairs, gridbest/1000.0, pairs, best/1000.0);
+
+      if(gridpairs != pairs){
+        fprintf(stderr, "The grid found %u pairs of %d objects, not %u.\n", gridpairs, m, pairs);
+        ok = false;
+      } //if
+
+      for(auto const& p: objects)
+        delete p;
+    } //for
+
+  return ok;
+} //BenchBroadPhase
+
+/// Whether a value computed by a particle kernel is close enough to the
+/// one computed by CParticle.
+/// \param a Value computed by a kernel.
+/// \param b Value computed by CParticle.
+/// \return true if they agree to within rounding.
+
+static bool CloseEnough(float a, float b){
+  return fabsf(a - b) <= KERNEL_TOLERANCE*max(1.0f, fabsf(b));
+} //CloseEnough
+
+/// Step KERNEL_PARTICLES random particles KERNEL_STEPS times with a
+/// particle kernel, and at the same time with CParticle's move, rescale,
+/// and fade, and count the values on which they disagree. A kernel is
+/// only meant to handle particles that don't use the features it was
+/// compiled without, so in those particles the values that drive the
+/// missing features are zero, except that CParticle always moves, so
+/// the positions aren't compared for kernels without PARTICLE_MOVE.
+/// \tparam VECTOR Vector type, for 2D or 3D particles.
+/// \tparam SPRITEDESC Sprite descriptor type, for 2D or 3D particles.
+/// \param kernel Particle kernel.
+/// \param features Feature mask that the kernel was compiled with.
+/// \param random PRNG for the particles.
+/// \param values [OUT] Incremented by the number of values compared.
+/// \return Number of values on which the kernel and CParticle disagree.
+
+template<class VECTOR, class SPRITEDESC>
+static unsigned CheckParticleKernel(ParticleKernelFn kernel, unsigned features,
+  CRandom& random, unsigned& values)
+{
+  const unsigned d = sizeof(VECTOR)/sizeof(float); //floats per vector
+  const size_t n = KERNEL_PARTICLES;
+  const float t = 1.0f/60.0f; //frame time
+  float now = 10.0f; //current time
+
+  auto r = [&](float lo, float hi){return lo + (hi - lo)*random.randf();}; //random number in [lo, hi]
+  auto on = [&](unsigned f){return (features & f) != 0;}; //whether a feature is compiled in
+
+  vector<CParticle<VECTOR, SPRITEDESC>> particles; //the same particles, stepped by CParticle
+  particles.reserve(n);
+
+  vector<float> pos(n*d), vel(n*d), accel(n*d), friction(n), rspeed(n), roll(n),
+    birth(n), lifespan(n), lifefrac(n), maxscale(n), scalein(n), scaleout(n), scale(n),
+    fadein(n), fadeout(n), alpha(n);
+
+  for(size_t i=0; i<n; i++){
+    CParticleDesc<VECTOR, SPRITEDESC> desc;
+    float* v[3] = {(float*)&desc.m_vPos, (float*)&desc.m_vVel, (float*)&desc.m_vAccel};
+
+    for(unsigned j=0; j<d; j++){
+      v[0][j] = r(-100.0f, 100.0f);
+      v[1][j] = r(-50.0f, 50.0f);
+      v[2][j] = on(PARTICLE_ACCEL)? r(-1.0f, 1.0f): 0.0f;
+    } //for
+
+    desc.m_fFriction = on(PARTICLE_FRICTION)? r(0.0f, 2.0f): 0.0f;
+    desc.m_fRSpeed = on(PARTICLE_SPIN)? r(-1.0f, 1.0f): 0.0f;
+    desc.m_fRoll = r(0.0f, XM_2PI);
+    desc.m_fLifeSpan = r(1.0f, 4.0f);
+    desc.m_fMaxScale = r(0.5f, 2.0f);
+    desc.m_fScaleInFrac = on(PARTICLE_SCALE)? r(0.0f, 0.5f): 0.0f;
+    desc.m_fScaleOutFrac = on(PARTICLE_SCALE)? r(0.0f, 0.5f): 0.0f;
+    desc.m_fFadeInFrac = on(PARTICLE_FADE)? r(0.0f, 0.5f): 0.0f;
+    desc.m_fFadeOutFrac = on(PARTICLE_FADE)? r(0.0f, 0.5f): 0.0f;
+    desc.m_fAlpha = r(0.0f, 1.0f);
+
+    const float b = now - 0.8f*desc.m_fLifeSpan*random.randf(); //so that none die before the end
+
+    particles.emplace_back(desc, b);
+
+    for(unsigned j=0; j<d; j++){
+      pos[i*d + j] = v[0][j];
+      vel[i*d + j] = v[1][j];
+      accel[i*d + j] = v[2][j];
+    } //for
+
+    friction[i] = desc.m_fFriction;
+    rspeed[i] = desc.m_fRSpeed;
+    roll[i] = desc.m_fRoll;
+    birth[i] = b;
+    lifespan[i] = desc.m_fLifeSpan;
+    maxscale[i] = desc.m_fMaxScale;
+    scalein[i] = desc.m_fScaleInFrac;
+    scaleout[i] = desc.m_fScaleOutFrac;
+    scale[i] = desc.m_fMaxScale;
+    fadein[i] = desc.m_fFadeInFrac;
+    fadeout[i] = desc.m_fFadeOutFrac;
+    alpha[i] = desc.m_fAlpha;
+  } //for
+
+  ParticleStreams s;
+  s.m_nDim = d;
+  s.m_pPos = pos.data(); s.m_pVel = vel.data(); s.m_pAccel = accel.data();
+  s.m_pFriction = friction.data(); s.m_pRSpeed = rspeed.data(); s.m_pRoll = roll.data();
+  s.m_pBirthTime = birth.data(); s.m_pLifeSpan = lifespan.data(); s.m_pLifeFrac = lifefrac.data();
+  s.m_pMaxScale = maxscale.data(); s.m_pScaleInFrac = scalein.data();
+  s.m_pScaleOutFrac = scaleout.data(); s.m_pScale = scale.data();
+  s.m_pFadeInFrac = fadein.data(); s.m_pFadeOutFrac = fadeout.data(); s.m_pAlpha = alpha.data();
+
+  unsigned bad = 0; //number of values that disagree
+
+  auto compare = [&](float a, float b){ //compare a value
+    values++;
+    if(!CloseEnough(a, b))bad++;
+  }; //compare
+
+  for(int step=0; step<KERNEL_STEPS; step++){
+    now += t;
+    kernel(s, n, now, t);
+
+    for(size_t i=0; i<n; i++){
+      CParticle<VECTOR, SPRITEDESC>& p = particles[i];
+
+      p.move(t);
+      const float f = max(0.0f, (now - p.m_fBirthTime)/p.m_fLifeSpan);
+      p.rescale(f);
+      p.fade(f);
+
+      const float* v[2] = {(const float*)&p.m_vPos, (const float*)&p.m_vVel};
+
+      for(unsigned j=0; j<d; j++){
+        if(on(PARTICLE_MOVE))
+          compare(pos[i*d + j], v[0][j]);
+
+        compare(vel[i*d + j], v[1][j]);
+      } //for
+
+      compare(lifefrac[i], f);
+      compare(roll[i], p.m_fRoll);
+      compare(scale[i], p.m_fXScale);
+      compare(alpha[i], p.m_fAlpha);
+    } //for
+  } //for
+
+  return bad;
+} //CheckParticleKernel
+
+/// Check the scalar, SSE2, and AVX2 particle kernels for every feature
+/// mask against CParticle, for 2D and 3D particles, see CheckParticleKernel.
+/// Kernels that this CPU doesn't support are skipped.
+/// \param seed Seed for the particles.
+/// \return true if every kernel agreed with CParticle.
+
+static bool CheckParticleKernels(int seed){
+  const eParticleKernel best = GetBestParticleKernel();
+  const eParticleKernel kernels[] = {eParticleKernel::SCALAR, eParticleKernel::SSE2, eParticleKernel::AVX2};
+  const char* names[] = {"Scalar", "SSE2", "AVX2"};
+
+  CRandom random;
+  random.srand(seed);
+
+  bool ok = true; //whether all checks passed
+
+  for(int k=0; k<3; k++){ //for each instruction set
+    if(kernels[k] > best){
+      printf("%s kernels: not supported by this CPU\n", names[k]);
+      continue;
+    } //if
+
+    unsigned values = 0; //number of values compared
+    unsigned bad = 0; //number of values that disagree
+    unsigned badmasks = 0; //number of feature masks with a kernel that disagrees
+
+    for(unsigned f=0; f<=PARTICLE_ALL; f++){ //for each feature mask
+      const ParticleKernelFn kernel = GetParticleKernel(kernels[k], f);
+      const unsigned n = CheckParticleKernel<Vector2, CSpriteDesc2D>(kernel, f, random, values) +
+        CheckParticleKernel<Vector3, CSpriteDesc3D>(kernel, f, random, values);
+
+      if(n > 0){
+        fprintf(stderr, "%s kernel with features 0x%02x: %u values disagree with CParticle\n",
+          names[k], f, n);
+        bad += n;
+        badmasks++;
+      } //if
+    } //for
+
+    printf("%s kernels: %u feature masks, %u values compared, %u disagree with CParticle in %u masks\n",
+      names[k], PARTICLE_ALL + 1, values, bad, badmasks);
+
+    ok = ok && bad == 0;
+  } //for
+
+  return ok;
+} //CheckParticleKernels
+
+/// Time the particle engine's step function with the best kernel that
+/// this CPU supports for every feature mask, on KERNEL_BENCH_PARTICLES
+/// random 2D particles that live long enough not to die while they are
+/// being timed, and report how many particles each one steps per second,
+/// compared with the full feature mask. Each mask is timed at its best of
+/// KERNEL_BENCH_REPEATS runs of KERNEL_BENCH_STEPS steps. The particles
+/// don't age, since the timer isn't ticked, but the kernels do the same
+/// work at any age.
+/// \param seed Seed for the particles.
+
+static void BenchParticleKernels(int seed){
+  const char* names[] = {"scalar", "SSE2", "AVX2"};
+  const eParticleKernel best = GetBestParticleKernel();
+
+  CRandom random;
+  random.srand(seed);
+
+  auto r = [&](float lo, float hi){return lo + (hi - lo)*random.randf();}; //random number in [lo, hi]
+
+  vector<CParticleDesc2D> descs(KERNEL_BENCH_PARTICLES); //the same particles for every mask
+
+  for(auto& d: descs){
+    d.m_vPos = Vector2(r(-100.0f, 100.0f), r(-100.0f, 100.0f));
+    d.m_vVel = Vector2(r(-50.0f, 50.0f), r(-50.0f, 50.0f));
+    d.m_vAccel = Vector2(r(-1.0f, 1.0f), r(-1.0f, 1.0f));
+    d.m_fFriction = r(0.0f, 2.0f);
+    d.m_fRSpeed = r(-1.0f, 1.0f);
+    d.m_fLifeSpan = r(1000.0f, 2000.0f);
+    d.m_fMaxScale = r(0.5f, 2.0f);
+    d.m_fScaleInFrac = r(0.0f, 0.5f);
+    d.m_fScaleOutFrac = r(0.0f, 0.5f);
+    d.m_fFadeInFrac = r(0.0f, 0.5f);
+    d.m_fFadeOutFrac = r(0.0f, 0.5f);
+  } //for
+
+  double rate[PARTICLE_ALL + 1]; //particles per second for each feature mask
+
+  for(int f=PARTICLE_ALL; f>=0; f--){ //for each feature mask, full mask first
+    CParticleEngine2D engine(nullptr, KERNEL_BENCH_PARTICLES, f);
+
+    for(auto const& d: descs)
+      engine.create(d);
+
+    int64_t fastest = INT64_MAX; //fastest run
+
+    for(int i=0; i<KERNEL_BENCH_REPEATS; i++){
+      const int64_t start = CProfileClock::now();
+
+      for(int j=0; j<KERNEL_BENCH_STEPS; j++)
+        engine.step();
+
+      fastest = min(fastest, CProfileClock::now() - start);
+    } //for
+
+    rate[f] = 1000000000.0*KERNEL_BENCH_PARTICLES*KERNEL_BENCH_STEPS/max(fastest, (int64_t)1);
+  } //for
+
+  printf("%s kernels, %zu particles\n", names[(int)best], KERNEL_BENCH_PARTICLES);
+
+  for(int f=0; f<=PARTICLE_ALL; f++){
+    const char* name = f == PARTICLE_ALL? " (all)": f == PARTICLE_BASIC? " (basic)":
+      f == PARTICLE_STILL? " (still)": "";
+
+    printf("  Features 0x%02x%s: %.1f million particles/s, %.2f times the full mask\n",
+      f, name, rate[f]/1000000.0, rate[f]/rate[PARTICLE_ALL]);
+  } //for
+} //BenchParticleKernels
+
+/// Save the profile zones as a Chrome trace, if the profiler is compiled in.
+/// \param filename File name.
+/// \return true if the file was written.
+
+static bool SaveProfile(const char* filename){
+#ifdef PROFILE
+  return CProfiler::Save(filename);
+#else //PROFILE
+  (void)filename; //unused
+  fprintf(stderr, "Define PROFILE in Profiler.h to record profile zones.\n");
+  return false;
+#endif //PROFILE
+} //SaveProfile
+
+/// Play a level for a given number of steps, or until the player
+/// wins or loses, or play a replay, then report how long it took,
+/// and whether it was deterministic if asked.
+/// \param argc Number of command line arguments.
+/// \param argv Command line arguments.
+/// \return 0 If this application terminates correctly and any checks pass, otherwise 1.
+
+int main(int argc, char* argv[]){
+  int level = 0; //level to play
+  int seed = 0; //PRNG seed
+  unsigned steps = 36000; //ten minutes of game time
+  bool script = false; //whether to use the scripted input track
+  vector<const char*> replayfiles; //replay file names, if any
+  bool check = false; //whether to play twice and compare
+  const char* hashfile = nullptr; //file to save hashes to, if any
+  const char* comparefile = nullptr; //file of hashes to compare with, if any
+  bool checkalloc = false; //whether to check that steps don't allocate
+  unsigned checkvis = 0; //number of sight lines to check visibility on, if any
+  bool checkmesh = false; //whether to check the wall AABBs on generated levels
+  bool checkkernels = false; //whether to check the particle kernels against CParticle
+  unsigned checkcull = 0; //number of objects to kill at once, if any
+  bool benchbroad = false; //whether to benchmark the broad phase on objects of our own
+  bool benchkernels = false; //whether to benchmark the particle kernels
+  const char* benchfile = nullptr; //file to write benchmark results to, if any
+  const char* mapfile = nullptr; //level image to play instead, if any
+  const char* generatefile = nullptr; //file to write a generated level image to, if any
+  const char* profilefile = nullptr; //file to save profile zones to, if any
+  CLevelDesc desc; //descriptor for the generated level
+  float density = 1.0f; //density scale for the generated level
+
+  for(int i=1; i<argc; i++){ //for each command line argument
+    if(!strcmp(argv[i], "-level") && i + 1 < argc)
+      level = atoi(argv[++i]);
+
+    else if(!strcmp(argv[i], "-seed") && i + 1 < argc)
+      seed = atoi(argv[++i]);
+
+    else if(!strcmp(argv[i], "-steps") && i + 1 < argc)
+      steps = (unsigned)strtoul(argv[++i], nullptr, 10);
+
+    else if(!strcmp(argv[i], "-script"))
+      script = true;
+
+    else if(!strcmp(argv[i], "-replay") && i + 1 < argc)
+      replayfiles.push_back(argv[++i]);
+
+    else if(!strcmp(argv[i], "-check"))
+      check = true;
+
+    else if(!strcmp(argv[i], "-hashes") && i + 1 < argc)
+      hashfile = argv[++i];
+
+    else if(!strcmp(argv[i], "-compare") && i + 1 < argc)
+      comparefile = argv[++i];
+
+    else if(!strcmp(argv[i], "-checkalloc"))
+      checkalloc = true;
+
+    else if(!strcmp(argv[i], "-checkvis") && i + 1 < argc)
+      checkvis = (unsigned)strtoul(argv[++i], nullptr, 10);
+
+    else if(!strcmp(argv[i], "-checkcull") && i + 1 < argc)
+      checkcull = (unsigned)strtoul(argv[++i], nullptr, 10);
+
+    else if(!strcmp(argv[i], "-checkmesh"))
+      checkmesh = true;
+
+    else if(!strcmp(argv[i], "-checkkernels"))
+      checkkernels = true;
+
+    else if(!strcmp(argv[i], "-benchbroad"))
+      benchbroad = true;
+
+    else if(!strcmp(argv[i], "-benchkernels"))
+      benchkernels = true;
+
+    else if(!strcmp(argv[i], "-bench") && i + 1 < argc)
+      benchfile = argv[++i];
+
+    else if(!strcmp(argv[i], "-map") && i + 1 < argc)
+      mapfile = argv[++i];
+
+    else if(!strcmp(argv[i], "-generate") && i + 1 < argc)
+      generatefile = argv[++i];
+
+    else if(!strcmp(argv[i], "-width") && i + 1 < argc)
+      desc.m_nWidth = atoi(argv[++i]);
+
+    else if(!strcmp(argv[i], "-height") && i + 1 < argc)
+      desc.m_nHeight = atoi(argv[++i]);
+
+    else if(!strcmp(argv[i], "-density") && i + 1 < argc)
+      density = (float)atof(argv[++i]);
+
+    else if(!strcmp(argv[i], "-profile") && i + 1 < argc)
+      profilefile = argv[++i];
+
+    else{
+      fprintf(stderr, "Usage: %s [-level n | -map file] [-seed n] [-steps n] [-script] [-replay file]"
+        " [-check] [-hashes file] [-compare file] [-checkalloc] [-checkvis n] [-checkcull n] [-checkmesh] [-checkkernels] [-benchbroad] [-benchkernels] [-bench file]"
+        " [-generate file [-width n] [-height n] [-density x]] [-profile file]\n", argv[0]);
+      return 1;
+    } //else
+  } //for
+
+  if(generatefile){ //generate a level image instead
+    desc.m_nSeed = seed;
+    desc.scale(density);
+
+    CLevelGenerator generator;
+
+    if(!generator.Generate(desc)){
+      fprintf(stderr, "Cannot generate a %d by %d level.\n", desc.m_nWidth, desc.m_nHeight);
+      return 1;
+    } //if
+
+    if(!generator.SavePNG(generatefile)){
+      fprintf(stderr, "Cannot save level to %s.\n", generatefile);
+      return 1;
+    } //if
+
+    printf("Level %d by %d saved to %s\n", desc.m_nWidth, desc.m_nHeight, generatefile);
+    return 0;
+  } //if
+
+  if(checkmesh) //check the wall AABBs instead
+    return CheckMeshing(seed)? 0: 1;
+
+  if(checkkernels) //check the particle kernels instead
+    return CheckParticleKernels(seed)? 0: 1;
+
+  if(mapfile && !replayfiles.empty()){
+    fprintf(stderr, "Replays are of the game's levels, not of level images.\n");
+    return 1;
+  } //if
+
+  if(checkalloc && (check || hashfile || comparefile)){
+    fprintf(stderr, "Hashing allocates, so -checkalloc can't be combined with hash checks.\n");
+    return 1;
+  } //if
+
+  if(replayfiles.size() > 1 && !benchfile){
+    fprintf(stderr, "Only one replay at a time, except when benchmarking.\n");
+    return 1;
+  } //if
+
+  vector<CReplay> replays(replayfiles.size()); //replays to play, if any
+
+  for(size_t i=0; i<replays.size(); i++){
+    if(!replays[i].Load(replayfiles[i])){
+      fprintf(stderr, "Cannot load replay %s.\n", replayfiles[i]);
+      return 1;
+    } //if
+
+    level = replays[i].GetLevel();
+  } //for
+
+  if(benchfile){ //benchmark every level instead
+    g_cGame.Initialize(); //initialize the game
+
+    if(!bench(benchfile, replays, mapfile, seed, steps)){
+      fprintf(stderr, "Cannot write benchmark results to %s.\n", benchfile);
+      return 1;
+    } //if
+
+    if(profilefile && !SaveProfile(profilefile))
+      return 1;
+
+    return 0;
+  } //if
+
+  if(benchbroad){ //benchmark the broad phase instead
+    g_cGame.Initialize(); //initialize the game, for the sprite sizes
+    return BenchBroadPhase(seed)? 0: 1;
+  } //if
+
+  if(benchkernels){ //benchmark the particle kernels instead
+    g_cGame.Initialize(); //initialize the game, for the timer
+    BenchParticleKernels(seed);
+    return 0;
+  } //if
+
+  if(checkvis > 0){ //check visibility in every level instead
+    g_cGame.Initialize(); //initialize the game
+    return CheckVisibility(checkvis, seed, mapfile)? 0: 1;
+  } //if
+
+  if(checkcull > 0){ //check culling in every level instead
+    g_cGame.Initialize(); //initialize the game
+    return CheckCulling(checkcull, seed, mapfile)? 0: 1;
+  } //if
+
+  if(mapfile) //a level of our own
+    level = NUM_LEVELS;
+
+  else if(level < 0 || level >= NUM_LEVELS){
+    fprintf(stderr, "Level must be between 0 and %d.\n", NUM_LEVELS - 1);
+    return 1;
+  } //if
+
+  vector<unsigned> expected; //hashes to compare with, if any
+
+  if(comparefile && !LoadHashes(comparefile, expected)){
+    fprintf(stderr, "Cannot load hashes from %s.\n", comparefile);
+    return 1;
+  } //if
+
+  CReplay* pReplay = replays.empty()? nullptr: &replays[0];
+  vector<unsigned> hashes; //world hash after each step
+  vector<unsigned>* pHashes = (check || hashfile || comparefile)? &hashes: nullptr;
+  vector<unsigned> allocs; //heap allocations made by each step
+  allocs.reserve(pReplay? pReplay->GetNumFrames(): steps); //so that this doesn't allocate while counting
+
+  g_cGame.Initialize(); //initialize the game
+
+  const int64_t start = CProfileClock::now();
+  run(pReplay, level, mapfile, seed, steps, script, pHashes, checkalloc? &allocs: nullptr);
+  const double t = (CProfileClock::now() - start)/1000000000.0; //in seconds
+
+  const unsigned n = g_cGame.GetStepCount();
+
+  printf("Level %d: %u steps in %.3f s, %.0f steps/s, %.2f us/step%s\n",
+    level, n, t, n/t, 1000000.0*t/max(n, 1u),
+    g_cGame.IsPlaying()? "": " (level over)");
+
+  if(g_cGame.GetEvictionCount() > 0)
+    printf("%u bullets removed to make room in a full projectile pool\n", g_cGame.GetEvictionCount());
+
+  bool ok = true; //whether all checks passed
+
+  if(hashfile && !SaveHashes(hashfile, hashes)){
+    fprintf(stderr, "Cannot save hashes to %s.\n", hashfile);
+    ok = false;
+  } //if
+
+  if(check){ //play it again, restored from the snapshot, and compare
+    vector<unsigned> again;
+    run(pReplay, level, mapfile, seed, steps, script, &again);
+    ok = CompareHashes(again, hashes, "fresh load") && ok;
+  } //if
+
+  if(comparefile)
+    ok = CompareHashes(hashes, expected, comparefile) && ok;
+
+  if(checkalloc)
+    ok = CheckAllocations(allocs) && ok;
+
+  if(profilefile && !SaveProfile(profilefile))
+    ok = false;
+
+  return ok? 0: 1;
+} //main
@@ -0,0 +1,201 @@
+/// \file HeadlessGame.cpp
+/// \brief Code for the headless game class CHeadlessGame.
+
+#include "HeadlessGame.h"
+
+#include "GameDefines.h"
+#include "Renderer.h"
+#include "ComponentIncludes.h"
+#include "ParticleEngine.h"
+#include "Benchmark.h"
+#include "Profiler.h"
+
+/// Delete the renderer, the particle engine, and the object manager.
+
+CHeadlessGame::~CHeadlessGame(){
+  delete m_pParticleEngine;
+  delete m_pRenderer;
+  delete m_pObjectManager;
+} //destructor
+
+/// Load the settings, then initialize the renderer, the object manager,
+/// and the particle engine the same way that CGame does, since the
+/// sprite sizes are needed for the bounding boxes and the particle
+/// engine is needed for death effects. There is no window to do the
+/// settings for us, so we have to load them ourselves.
+
+void CHeadlessGame::Initialize(){
+  Load(); //load settings from gamesettings.xml
+
+  m_pRenderer = new CRenderer; 
+  m_pRenderer->Initialize(NUM_SPRITES); 
+  m_pRenderer->LoadImages(); //load sprite sizes from xml file list
+
+  m_pObjectManager = new CObjectManager; //set up the object manager 
+  m_pAudio->Load(); //does nothing, but keeps the random number stream the same
+
+  m_pParticleEngine = new CParticleEngine2D((CSpriteRenderer*)m_pRenderer,
+    DEFAULT_PARTICLE_CAPACITY, PARTICLE_BASIC); //sparks and smoke only move, scale, and fade
+} //Initialize
+
+/// Begin playing a level. Unlike CGame::BeginGame, the level always
+/// starts at time zero with the PRNG seeded with a given seed, so that
+/// it plays out the same way every time. It is restored from the
+/// object manager's snapshot if it was played last, which leaves it
+/// in the same state as loading it fresh, and loaded otherwise.
+/// \param level Level number, which must be less than NUM_LEVELS unless there is a file name.
+/// \param seed PRNG seed.
+/// \param filename Level image file name, or nullptr for the level's own.
+
+void CHeadlessGame::BeginLevel(int level, int seed, const char* filename){
+  m_pTimer->SetTime(0.0f);
+  m_pRandom->srand(seed);
+
+  m_nCurrentLevel = level;
+  m_pParticleEngine->clear(); //clear old particles
+  m_pObjectManager->StartLevel(m_nCurrentLevel, filename); //restore or load map
+
+  m_nStepCount = 0;
+  state = PLAY_STATE;
+} //BeginLevel
+
+/// Take a single physics step, doing everything that CGame::ProcessFrame
+/// does in the play state except for reading input devices and rendering.
+/// Each step is treated as a frame of its own, which is what CGame does when
+/// the frame rate is 60 fps. The time counts steps, not seconds of real time.
+/// \param input Mask of eInput flags for the player's input.
+/// \param hashes [OUT] If not nullptr, the world hash is appended to this.
+
+void CHeadlessGame::step(unsigned input, vector<unsigned>* hashes){
+  PROFILE_SCOPE("CHeadlessGame::step");
+
+  m_pObjectManager->ApplyInput(input); //act on input, at the last frame's time
+
+  m_pTimer->SetTime(m_nStepCount*PHYSICS_STEP); //set time by hand
+  m_pTimer->BeginFrame(); //notify timer that frame has begun
+
+  m_pObjectManager->ScheduleAI(); //once per frame, not once per step
+  m_pObjectManager->move(PHYSICS_STEP); //move all objects
+
+  if(hashes)
+    hashes->push_back(m_pObjectManager->GetWorldHash());
+
+  StepParticles(); //advance particle animation
+
+  m_pTimer->EndFrame(); //notify timer that frame has ended
+  m_nStepCount++;
+} //step
+
+/// Unload the level, so that the next one begun is loaded fresh
+/// rather than restored from the snapshot.
+
+void CHeadlessGame::UnloadLevel(){
+  m_pParticleEngine->clear(); //clear old particles
+  m_pObjectManager->clear(); //clear old objects, and the snapshot
+} //UnloadLevel
+
+/// Set things up the way that CGame::BeginRecording did: the timer at
+/// the time the level was started, the PRNG seeded with the same seed,
+/// the level restored or loaded, and the accumulator empty.
+/// \param replay A replay.
+
+void CHeadlessGame::BeginReplay(CReplay& replay){
+  m_pTimer->SetTime(replay.GetStartTime());
+  m_pRandom->srand(replay.GetSeed());
+
+  m_nCurrentLevel = replay.GetLevel();
+  m_pParticleEngine->clear(); //clear old particles
+  m_pObjectManager->StartLevel(m_nCurrentLevel); //restore or load map
+
+  m_fAccumulator = 0.0f;
+  m_nStepCount = 0;
+  state = PLAY_STATE;
+} //BeginReplay
+
+/// Play a frame of a replay, doing what CGame::ProcessFrame did in the
+/// play state, in the same order, with the recorded input and times.
+/// \param f A replay frame.
+/// \param hashes [OUT] If not nullptr, the world hash after each step is appended to this.
+
+void CHeadlessGame::PlayFrame(const CReplayFrame& f, vector<unsigned>* hashes){
+  PROFILE_SCOPE("CHeadlessGame::PlayFrame");
+
+  m_pObjectManager->ApplyInput(f.m_nInput); //act on input, at the last frame's time
+
+  m_pTimer->SetTime(f.m_fTime); //set time by hand
+  m_pTimer->SetFrameTime(f.m_fFrameTime);
+  m_pTimer->BeginFrame(); //notify timer that frame has begun
+
+  m_fAccumulator += max(0.0f, m_pTimer->frametime());
+  m_pObjectManager->ScheduleAI(); //once per frame, not once per step
+
+  while(m_fAccumulator >= PHYSICS_STEP){ //fixed time step
+    m_pObjectManager->move(PHYSICS_STEP); //move all objects
+    m_fAccumulator -= PHYSICS_STEP;
+    m_nStepCount++;
+
+    if(hashes)
+      hashes->push_back(m_pObjectManager->GetWorldHash());
+  } //while
+
+  StepParticles(); //advance particle animation
+  m_pTimer->EndFrame(); //notify timer that frame has ended
+} //PlayFrame
+
+/// Advance particle animation, timing it for the benchmark if there is one.
+
+void CHeadlessGame::StepParticles(){
+  CBenchmarkTimer timer(PARTICLE_TIMER);
+  m_pParticleEngine->step();
+} //StepParticles
+
+/// Reader function for whether the level is still being played,
+/// that is, the player has neither won nor lost.
+/// \return true if the game is in the play state.
+
+bool CHeadlessGame::IsPlaying(){
+  return state == PLAY_STATE;
+} //IsPlaying
+
+/// Reader function for the number of steps taken since the level began.
+/// \return Number of steps taken.
+
+unsigned CHeadlessGame::GetStepCount(){
+  return m_nStepCount;
+} //GetStepCount
+
+/// Reader function for the number of bullets removed from a full
+/// projectile pool since the level began.
+/// \return Number of bullets removed.
+
+unsigned CHeadlessGame::GetEvictionCount(){
+  return m_pObjectManager->GetEvictionCount();
+} //GetEvictionCount
+
+/// Compare the ways of checking visibility on random sight lines in
+/// the current level, see CTileManager::CheckVisibility.
+/// \param n Number of sight lines.
+/// \param seed Seed for the random sight lines.
+/// \param check [OUT] What the different ways made of the sight lines.
+
+void CHeadlessGame::CheckVisibility(unsigned n, int seed, VisibilityCheck& check){
+  m_pObjectManager->GetTileManager()->CheckVisibility(n, seed, check);
+} //CheckVisibility
+
+/// Kill many objects in a single step in the current level and check
+/// the lists afterwards, see CObjectManager::CheckCulling.
+/// \param n Number of objects to kill.
+/// \param seed Seed for the positions and the killing order.
+/// \param check [OUT] The number of objects killed and what was wrong with the lists.
+
+void CHeadlessGame::CheckCulling(unsigned n, int seed, CullCheck& check){
+  m_pObjectManager->CheckCulling(n, seed, check);
+} //CheckCulling
+
+/// Start timing the parts of each step for a benchmark, or stop if
+/// given nullptr. The same benchmark is used by the object manager.
+/// \param p Pointer to a benchmark, or nullptr.
+
+void CHeadlessGame::SetBenchmark(CBenchmark* p){
+  m_pBenchmark = p;
+} //SetBenchmark
@@ -0,0 +1,60 @@
+/// \file HeadlessGame.h
+/// \brief Interface for the headless game class CHeadlessGame.
+
+#pragma once
+
+#include "Component.h"
+#include "Common.h"
+#include "ObjectManager.h"
+#include "Settings.h"
+#include "Replay.h"
+
+#include <vector>
+
+using namespace std;
+
+/// \brief The headless game class.
+///
+/// CHeadlessGame plays a level the way that CGame does, minus the
+/// window, the rendering, the sound, and the input. There are no
+/// animation frames, just physics steps of PHYSICS_STEP seconds, and
+/// the timer is set by hand at the start of each one so that the
+/// simulation runs as fast as the CPU will let it and takes the same
+/// path no matter how long each step takes in real time. It can also
+/// play back a replay recorded by CGame, in which case the frames are
+/// fed through the accumulator loop exactly as they were recorded.
+/// Either way, a level always starts from the same state, and a hash
+/// of the world can be taken after every step so that two runs can be
+/// checked against each other. While a benchmark is set, the parts
+/// of each step that it times are timed.
+
+class CHeadlessGame: 
+  public CComponent, 
+  public CSettingsManager,
+  public CCommon{ 
+
+  private:
+    int m_nCurrentLevel = 0; ///< Current level.
+    unsigned m_nStepCount = 0; ///< Number of steps taken since the level began.
+    float m_fAccumulator = 0.0f; ///< Time not yet stepped, when playing a replay.
+
+    void StepParticles(); ///< Advance particle animation.
+
+  public:
+    ~CHeadlessGame(); ///< Destructor.
+
+    void Initialize(); ///< Initialize the game.
+    void BeginLevel(int level, int seed=0, const char* filename=nullptr); ///< Begin playing a level.
+    void UnloadLevel(); ///< Unload the level.
+    void step(unsigned input=0, vector<unsigned>* hashes=nullptr); ///< Take a physics step.
+
+    void BeginReplay(CReplay& replay); ///< Begin playing a replay.
+    void PlayFrame(const CReplayFrame& f, vector<unsigned>* hashes=nullptr); ///< Play a frame of a replay.
+
+    bool IsPlaying(); ///< Whether the level is still being played.
+    unsigned GetStepCount(); ///< Get the number of steps taken.
+    unsigned GetEvictionCount(); ///< Get the number of bullets removed from a full pool.
+    void CheckVisibility(unsigned n, int seed, VisibilityCheck& check); ///< Compare the ways of checking visibility.
+    void CheckCulling(unsigned n, int seed, CullCheck& check); ///< Kill many objects at once and check the lists.
+    void SetBenchmark(CBenchmark* p); ///< Start or stop timing for a benchmark.
+}; //CHeadlessGame
@@ -0,0 +1,78 @@
+/// \file HeapCheck.cpp
+/// \brief Code for counting heap allocations.
+///
+/// When COUNT_ALLOCATIONS is defined, which it is in the headless build
+/// and whenever CHECK_STEP_ALLOCATIONS is, the global operator new
+/// and operator delete are replaced by versions that count
+/// allocations, so that a piece of code can check that it didn't
+/// allocate anything by comparing the count before and after. The
+/// count is over all threads, so the audio engine allocating at
+/// the wrong moment can cause a false alarm.
+
+#include "HeapCheck.h"
+
+#ifdef COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+static atomic<size_t> g_nAllocations(0); ///< Number of heap allocations so far.
+
+/// Get the number of heap allocations made since the program started.
+/// \return Number of heap allocations.
+
+size_t GetAllocationCount(){
+  return g_nAllocations.load();
+} //GetAllocationCount
+
+/// Count an allocation and hand it on to malloc.
+/// \param n Number of bytes.
+/// \return Pointer to the memory allocated.
+
+void* operator new(size_t n){
+  g_nAllocations++;
+  void* p = malloc(n > 0? n: 1);
+  if(p == nullptr)throw bad_alloc();
+  return p;
+} //operator new
+
+/// Array version of operator new.
+/// \param n Number of bytes.
+/// \return Pointer to the memory allocated.
+
+void* operator new[](size_t n){
+  return operator new(n);
+} //operator new[]
+
+/// Free memory allocated by operator new.
+/// \param p Pointer to the memory.
+
+void operator delete(void* p) noexcept{
+  free(p);
+} //operator delete
+
+/// Free memory allocated by operator new[].
+/// \param p Pointer to the memory.
+
+void operator delete[](void* p) noexcept{
+  free(p);
+} //operator delete[]
+
+/// Sized version of operator delete.
+/// \param p Pointer to the memory.
+
+void operator delete(void* p, size_t) noexcept{
+  free(p);
+} //operator delete
+
+/// Sized version of operator delete[].
+/// \param p Pointer to the memory.
+
+void operator delete[](void* p, size_t) noexcept{
+  free(p);
+} //operator delete[]
+
+#endif //COUNT_ALLOCATIONS
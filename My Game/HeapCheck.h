@@ -0,0 +1,18 @@
+/// \file HeapCheck.h
+/// \brief Defines to support counting heap allocations.
+
+#pragma once
+
+#include <cstddef>
+
+//#define CHECK_STEP_ALLOCATIONS ///< Define this to report physics steps that allocate memory.
+
+#if defined(CHECK_STEP_ALLOCATIONS) || defined(HEADLESS)
+  #define COUNT_ALLOCATIONS ///< Count heap allocations, which the headless build always does for -checkalloc.
+#endif //defined(CHECK_STEP_ALLOCATIONS) || defined(HEADLESS)
+
+#ifdef COUNT_ALLOCATIONS
+  const unsigned STEP_ALLOCATION_WARMUP = 60; ///< Steps allowed to allocate while scratch space fills up.
+
+  size_t GetAllocationCount(); ///< Get the number of heap allocations so far.
+#endif //COUNT_ALLOCATIONS
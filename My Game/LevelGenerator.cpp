@@ -0,0 +1,429 @@
+/// \file LevelGenerator.cpp
+/// \brief Code for the level generator class CLevelGenerator.
+
+#include "LevelGenerator.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+const int MAX_LEVEL_TILES = 1 << 28; ///< Most tiles that a level can have.
+const int FIND_TRIES = 64; ///< Number of random tiles tried when looking for a free one.
+const int MAX_SHAFT_STOREYS = 3; ///< Most storeys that an elevator shaft rises through.
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+/// Scale all densities by the same amount, for example to make a
+/// level with more of everything.
+/// \param s Scale factor.
+
+void CLevelDesc::scale(float s){
+  m_fLadders *= s;
+  m_fElevators *= s;
+  m_fDoors *= s;
+  m_fTraps *= s;
+  m_fTurrets *= s;
+  m_fGuns *= s;
+} //scale
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+/// Set the color of a tile and mark it as used.
+/// \param x Column, from the left.
+/// \param y Row, from the top.
+/// \param r Red.
+/// \param g Green.
+/// \param b Blue.
+
+void CLevelGenerator::SetPixel(int x, int y, unsigned char r, unsigned char g, unsigned char b){
+  const size_t i = (size_t)y*m_nWidth + x;
+  m_vPixels[3*i] = r;
+  m_vPixels[3*i + 1] = g;
+  m_vPixels[3*i + 2] = b;
+  m_vUsed[i] = true;
+} //SetPixel
+
+/// Reader function for whether a tile has something in it already.
+/// The walls around the outside and the floors count as used.
+/// \param x Column, from the left.
+/// \param y Row, from the top.
+/// \return true if the tile is used.
+
+bool CLevelGenerator::IsUsed(int x, int y){
+  return m_vUsed[(size_t)y*m_nWidth + x];
+} //IsUsed
+
+/// Reader function for whether a tile is a wall, for example a
+/// floor that nothing has been cut through yet.
+/// \param x Column, from the left.
+/// \param y Row, from the top.
+/// \return true if the tile is a wall.
+
+bool CLevelGenerator::IsWall(int x, int y){
+  const size_t i = 3*((size_t)y*m_nWidth + x);
+  return m_vPixels[i] == 0 && m_vPixels[i + 1] == 0 && m_vPixels[i + 2] == 0;
+} //IsWall
+
+/// Reader function for whether a pair of tiles side by side can have
+/// a ladder or elevator shaft cut through them, which they can if they
+/// are free, or if they are in a floor that is still solid there.
+/// \param x Column of left tile.
+/// \param y Row, from the top.
+/// \return true if the tiles can be cut through.
+
+bool CLevelGenerator::CanCut(int x, int y){
+  if(find(m_vFloors.begin(), m_vFloors.end(), y) != m_vFloors.end())
+    return IsWall(x, y) && IsWall(x + 1, y);
+
+  return !IsUsed(x, y) && !IsUsed(x + 1, y);
+} //CanCut
+
+/// Find a free tile on top of a floor, trying tiles at random.
+/// \param x [OUT] Column, from the left.
+/// \param y [OUT] Row, from the top.
+/// \return true if one was found.
+
+bool CLevelGenerator::FindGround(int& x, int& y){
+  for(int i=0; i<FIND_TRIES; i++){
+    const int storey = (int)m_cRandom.randn(0, (unsigned)m_vFloors.size() - 1);
+    x = (int)m_cRandom.randn(1, m_nWidth - 2);
+    y = m_vFloors[storey] - 1;
+
+    if(!IsUsed(x, y))
+      return true;
+  } //for
+
+  return false;
+} //FindGround
+
+/// Place things of a single color on top of the floors.
+/// If the floors get crowded then fewer are placed.
+/// \param n Number of things.
+/// \param r Red.
+/// \param g Green.
+/// \param b Blue.
+
+void CLevelGenerator::PlaceOnGround(int n, unsigned char r, unsigned char g, unsigned char b){
+  int x, y;
+
+  for(int i=0; i<n; i++)
+    if(FindGround(x, y))
+      SetPixel(x, y, r, g, b);
+} //PlaceOnGround
+
+/// Place pairs of things on top of the floors, such as a door and
+/// its key, or electricity and its switch, with the red channel of
+/// both set to the same index. Indices are reused after 256 pairs.
+/// \param n Number of pairs.
+/// \param g0 Green of the first of each pair.
+/// \param b0 Blue of the first of each pair.
+/// \param g1 Green of the second of each pair.
+/// \param b1 Blue of the second of each pair.
+
+void CLevelGenerator::PlacePairs(int n, unsigned char g0, unsigned char b0,
+  unsigned char g1, unsigned char b1)
+{
+  int x0, y0, x1, y1;
+
+  for(int i=0; i<n; i++)
+    if(FindGround(x0, y0)){
+      SetPixel(x0, y0, (unsigned char)i, g0, b0);
+
+      if(FindGround(x1, y1))
+        SetPixel(x1, y1, (unsigned char)i, g1, b1);
+    } //if
+} //PlacePairs
+
+/// Make a ladder two tiles wide from the top of one floor, through
+/// the floor above it, to the tile above that. Nothing is made if
+/// any of those tiles can't be cut through.
+/// \param x Column of left half.
+/// \param storey Storey that the ladder starts in.
+
+void CLevelGenerator::MakeLadder(int x, int storey){
+  const int bottom = m_vFloors[storey] - 1;
+  const int top = m_vFloors[storey + 1] - 1;
+
+  for(int y=top; y<=bottom; y++)
+    if(!CanCut(x, y))
+      return;
+
+  for(int y=top; y<=bottom; y++){
+    SetPixel(x, y, 0, 0, 255); //ladder left
+    SetPixel(x + 1, y, 0, 0, 155); //ladder right
+  } //for
+} //MakeLadder
+
+/// Make an elevator shaft two tiles wide that rises through one or more
+/// floors. The elevator starts at the bottom, there is an end point at
+/// the bottom and the top, and a stop point at each floor in between.
+/// Nothing is made if any of the tiles in the shaft can't be cut through.
+/// \param x Column of left half.
+/// \param storey Storey that the shaft starts in.
+/// \param storeys Number of floors that it rises through.
+
+void CLevelGenerator::MakeElevator(int x, int storey, int storeys){
+  const int bottom = m_vFloors[storey] - 1;
+  const int top = m_vFloors[storey + storeys] - 2;
+
+  for(int y=top; y<=bottom; y++)
+    if(!CanCut(x, y))
+      return;
+
+  for(int y=top; y<=bottom; y++){ //clear the shaft
+    SetPixel(x, y, 255, 255, 255);
+    SetPixel(x + 1, y, 255, 255, 255);
+  } //for
+
+  SetPixel(x, bottom, 0, 0, 100); //elevator
+  SetPixel(x + 1, bottom, 0, 100, 100); //end point at the bottom
+  SetPixel(x + 1, top, 0, 100, 100); //end point at the top
+
+  for(int i=1; i<storeys; i++) //stop points at the floors in between
+    SetPixel(x + 1, m_vFloors[storey + i] - 1, 100, 0, 100);
+} //MakeElevator
+
+/// Generate a level. The walls around the outside and the floors
+/// go in first, then the characters and the exit, then the ladders
+/// and elevators, which must be able to get the characters from each
+/// floor to the next, and finally everything else.
+/// \param d Level descriptor.
+/// \return true if the level is big enough to be made.
+
+bool CLevelGenerator::Generate(const CLevelDesc& d){
+  if(d.m_nWidth < 16 || d.m_nStorey < 4 || d.m_nHeight < 2*d.m_nStorey + 1 ||
+    (float)d.m_nWidth*d.m_nHeight > (float)MAX_LEVEL_TILES)
+    return false;
+
+  m_nWidth = d.m_nWidth;
+  m_nHeight = d.m_nHeight;
+  m_cRandom.srand(d.m_nSeed);
+
+  const size_t n = (size_t)m_nWidth*m_nHeight; //number of tiles
+  m_vPixels.assign(3*n, 255); //white is empty
+  m_vUsed.assign(n, false);
+
+  m_vFloors.clear(); //the bottom wall is the first floor
+
+  for(int y=m_nHeight - 1; y>=3; y-=d.m_nStorey)
+    m_vFloors.push_back(y);
+
+  //walls and floors
+
+  for(int x=0; x<m_nWidth; x++){
+    SetPixel(x, 0, 0, 0, 0);
+
+    for(auto const& y: m_vFloors)
+      SetPixel(x, y, 0, 0, 0);
+  } //for
+
+  for(int y=0; y<m_nHeight; y++){
+    SetPixel(0, y, 0, 0, 0);
+    SetPixel(m_nWidth - 1, y, 0, 0, 0);
+  } //for
+
+  //characters at the bottom left, exit at the top right,
+  //with some room around them kept clear
+
+  const int start = m_nHeight - 2;
+  const int finish = m_vFloors.back() - 1;
+
+  for(int x=1; x<8; x++){
+    m_vUsed[(size_t)start*m_nWidth + x] = true;
+    m_vUsed[(size_t)finish*m_nWidth + m_nWidth - 1 - x] = true;
+  } //for
+
+  SetPixel(2, start, 1, 155, 255); //fighter
+  SetPixel(3, start, 2, 155, 255); //shield
+  SetPixel(4, start, 0, 155, 255); //fast
+  SetPixel(m_nWidth - 5, finish, 255, 0, 0); //exit
+
+  //ladders and elevators, at least one ladder between each pair of floors
+
+  const int storeys = (int)m_vFloors.size();
+  const int ladders = max(1, (int)(d.m_fLadders*m_nWidth + 0.5f));
+  const int elevators = (int)(d.m_fElevators*m_nWidth + 0.5f);
+
+  for(int s=0; s + 1<storeys; s++){
+    for(int i=0; i<ladders; i++)
+      MakeLadder((int)m_cRandom.randn(1, m_nWidth - 3), s);
+
+    for(int i=0; i<elevators; i++){
+      const int rise = (int)m_cRandom.randn(1, min(MAX_SHAFT_STOREYS, storeys - 1 - s));
+      MakeElevator((int)m_cRandom.randn(1, m_nWidth - 3), s, rise);
+    } //for
+  } //for
+
+  //everything else on top of the floors
+
+  const float ground = (float)(m_nWidth - 2)*storeys; //tiles on top of floors
+
+  PlacePairs((int)(d.m_fDoors*ground + 0.5f), 255, 0, 250, 250); //doors and keys
+  PlacePairs((int)(d.m_fTraps*ground + 0.5f), 200, 200, 200, 0); //electricity and switches
+  PlaceOnGround((int)(d.m_fTurrets*ground + 0.5f), 75, 75, 75); //turrets
+  PlaceOnGround((int)(d.m_fGuns*ground + 0.5f), 42, 42, 42); //guns
+
+  return true;
+} //Generate
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+/// Compute the CRC-32 that PNG uses, one piece at a time.
+/// \param crc CRC of the data so far, 0 to start.
+/// \param p Pointer to data.
+/// \param n Number of bytes.
+/// \return CRC of the data so far including this piece.
+
+static unsigned Crc32(unsigned crc, const unsigned char* p, size_t n){
+  static unsigned table[256];
+  static bool bInitialized = false;
+
+  if(!bInitialized){
+    for(unsigned i=0; i<256; i++){
+      unsigned c = i;
+
+      for(int k=0; k<8; k++)
+        c = (c & 1)? 0xEDB88320 ^ (c >> 1): c >> 1;
+
+      table[i] = c;
+    } //for
+
+    bInitialized = true;
+  } //if
+
+  crc = ~crc;
+
+  for(size_t i=0; i<n; i++)
+    crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+
+  return ~crc;
+} //Crc32
+
+/// Append a 32-bit value to a byte buffer, most significant byte first.
+/// \param v [OUT] Byte buffer.
+/// \param x Value.
+
+static void PutBigEndian(vector<unsigned char>& v, unsigned x){
+  v.push_back((unsigned char)(x >> 24));
+  v.push_back((unsigned char)(x >> 16));
+  v.push_back((unsigned char)(x >> 8));
+  v.push_back((unsigned char)x);
+} //PutBigEndian
+
+/// Write a PNG chunk.
+/// \param fp File pointer.
+/// \param type Chunk type, four characters.
+/// \param data Chunk data.
+/// \return true if it was written.
+
+static bool WriteChunk(FILE* fp, const char* type, const vector<unsigned char>& data){
+  vector<unsigned char> header;
+  PutBigEndian(header, (unsigned)data.size());
+  header.insert(header.end(), type, type + 4);
+
+  vector<unsigned char> trailer;
+  const unsigned crc = Crc32(Crc32(0, &header[4], 4), data.data(), data.size());
+  PutBigEndian(trailer, crc);
+
+  return fwrite(header.data(), 1, header.size(), fp) == header.size() &&
+    fwrite(data.data(), 1, data.size(), fp) == data.size() &&
+    fwrite(trailer.data(), 1, trailer.size(), fp) == trailer.size();
+} //WriteChunk
+
+/// Save the level as an 8-bit RGB PNG file. There's no image writer
+/// in the Engine and the stb_image.h we use only reads, so the pixels
+/// are stored in a zlib stream without compression, which stb_image
+/// reads just as well. The files are 3 bytes a tile, but levels
+/// rarely need to be kept.
+/// \param filename File name.
+/// \return true if the file was written.
+
+bool CLevelGenerator::SavePNG(const char* filename){
+  if(m_vPixels.empty())return false;
+
+  FILE* fp = nullptr;
+  fopen_s(&fp, filename, "wb");
+  if(fp == nullptr)return false;
+
+  const unsigned char signature[8] = {137, 'P', 'N', 'G', '\r', '\n', 26, '\n'};
+  bool ok = fwrite(signature, 1, 8, fp) == 8;
+
+  //header
+
+  vector<unsigned char> ihdr;
+  PutBigEndian(ihdr, (unsigned)m_nWidth);
+  PutBigEndian(ihdr, (unsigned)m_nHeight);
+  ihdr.push_back(8); //bit depth
+  ihdr.push_back(2); //RGB
+  ihdr.push_back(0); //deflate
+  ihdr.push_back(0); //standard filters
+  ihdr.push_back(0); //not interlaced
+  ok = ok && WriteChunk(fp, "IHDR", ihdr);
+
+  //raw image data, each row preceded by filter type 0, none
+
+  const size_t rowsize = 3*(size_t)m_nWidth;
+  vector<unsigned char> raw;
+  raw.reserve((rowsize + 1)*m_nHeight);
+
+  for(int y=0; y<m_nHeight; y++){
+    raw.push_back(0);
+    raw.insert(raw.end(), m_vPixels.begin() + y*rowsize, m_vPixels.begin() + (y + 1)*rowsize);
+  } //for
+
+  //zlib stream made of stored deflate blocks of at most 65535 bytes
+
+  vector<unsigned char> idat;
+  idat.reserve(raw.size() + 5*(raw.size()/65535 + 1) + 6);
+  idat.push_back(0x78); //deflate, 32K window
+  idat.push_back(0x01); //no dictionary, fastest
+
+  unsigned a = 1, b = 0; //Adler-32
+
+  for(size_t i=0; i<raw.size(); i+=65535){
+    const size_t len = min((size_t)65535, raw.size() - i);
+
+    idat.push_back(i + len == raw.size()? 1: 0); //final block flag, stored
+    idat.push_back((unsigned char)len);
+    idat.push_back((unsigned char)(len >> 8));
+    idat.push_back((unsigned char)~len);
+    idat.push_back((unsigned char)(~len >> 8));
+    idat.insert(idat.end(), raw.begin() + i, raw.begin() + i + len);
+
+    for(size_t j=i; j<i + len; j++){
+      a = (a + raw[j])%65521;
+      b = (b + a)%65521;
+    } //for
+  } //for
+
+  PutBigEndian(idat, (b << 16) | a);
+  ok = ok && WriteChunk(fp, "IDAT", idat);
+
+  ok = ok && WriteChunk(fp, "IEND", vector<unsigned char>());
+
+  fclose(fp);
+  return ok;
+} //SavePNG
+
+/// Reader function for the width.
+/// \return Width in tiles.
+
+int CLevelGenerator::GetWidth(){
+  return m_nWidth;
+} //GetWidth
+
+/// Reader function for the height.
+/// \return Height in tiles.
+
+int CLevelGenerator::GetHeight(){
+  return m_nHeight;
+} //GetHeight
+
+/// Reader function for the pixels, which are RGB, one per tile, top row
+/// first, as they would be if the level were saved and loaded again.
+/// \return Pointer to the pixels, or nullptr if no level has been made.
+
+const unsigned char* CLevelGenerator::GetPixels(){
+  return m_vPixels.empty()? nullptr: m_vPixels.data();
+} //GetPixels
@@ -0,0 +1,79 @@
+/// \file LevelGenerator.h
+/// \brief Interface for the level generator class CLevelGenerator.
+
+#pragma once
+
+#include <vector>
+
+#include "Random.h"
+
+using namespace std;
+
+/// \brief A level descriptor.
+///
+/// Everything that the level generator needs to know to make a level.
+/// The densities are numbers of things per tile of floor that can be
+/// stood on, except for ladders and elevators, which are per tile of
+/// width for each floor that they pass through.
+
+class CLevelDesc{
+  public:
+    int m_nWidth = 256; ///< Width in tiles.
+    int m_nHeight = 128; ///< Height in tiles.
+    int m_nSeed = 0; ///< PRNG seed.
+    int m_nStorey = 8; ///< Distance in tiles from one floor to the next.
+
+    float m_fLadders = 0.02f; ///< Ladders per tile of width.
+    float m_fElevators = 0.01f; ///< Elevators per tile of width.
+    float m_fDoors = 0.005f; ///< Doors, each with a key, per tile of floor.
+    float m_fTraps = 0.005f; ///< Electricity, each with a switch, per tile of floor.
+    float m_fTurrets = 0.01f; ///< Turrets per tile of floor.
+    float m_fGuns = 0.005f; ///< Guns per tile of floor.
+
+    void scale(float s); ///< Scale all densities.
+}; //CLevelDesc
+
+/// \brief The level generator.
+///
+/// The level generator makes levels in the same PNG format as the
+/// ones in Media/Maps, using the color scheme in TileManager.h, so
+/// that CTileManager::LoadLevel can load them like any other. A level
+/// is a walled box divided into storeys by floors. Ladders and
+/// elevator shafts, some of which rise through several storeys with
+/// stop points at each floor in between, are cut through the floors.
+/// Doors, keys, electricity, switches, turrets, and guns are scattered
+/// along the tops of the floors. The characters start at the bottom
+/// left and the exit is at the top right. The same descriptor always
+/// makes the same level, and it can be as big as memory allows, for
+/// example to stress test the engine with maps of millions of tiles
+/// and thousands of turrets.
+
+class CLevelGenerator{
+  private:
+    int m_nWidth = 0; ///< Width in tiles.
+    int m_nHeight = 0; ///< Height in tiles.
+    vector<unsigned char> m_vPixels; ///< RGB pixels, one per tile, top row first.
+    vector<bool> m_vUsed; ///< Whether each tile has something in it already.
+    vector<int> m_vFloors; ///< Rows that floors are in, from the bottom up.
+    CRandom m_cRandom; ///< PRNG, separate from the game's.
+
+    void SetPixel(int x, int y, unsigned char r, unsigned char g, unsigned char b); ///< Set a tile.
+    bool IsUsed(int x, int y); ///< Whether a tile has something in it.
+    bool IsWall(int x, int y); ///< Whether a tile is a wall.
+    bool CanCut(int x, int y); ///< Whether a ladder or shaft can go through two tiles.
+
+    bool FindGround(int& x, int& y); ///< Find a free tile on top of a floor.
+    void PlaceOnGround(int n, unsigned char r, unsigned char g, unsigned char b); ///< Place things on floors.
+    void PlacePairs(int n, unsigned char g0, unsigned char b0, unsigned char g1, unsigned char b1); ///< Place pairs of things.
+
+    void MakeLadder(int x, int storey); ///< Make a ladder.
+    void MakeElevator(int x, int storey, int storeys); ///< Make an elevator shaft.
+
+  public:
+    bool Generate(const CLevelDesc& d); ///< Generate a level.
+    bool SavePNG(const char* filename); ///< Save as PNG.
+
+    int GetWidth(); ///< Get width in tiles.
+    int GetHeight(); ///< Get height in tiles.
+    const unsigned char* GetPixels(); ///< Get the RGB pixels.
+}; //CLevelGenerator
@@ -0,0 +1,110 @@
+/// \file MappedFile.cpp
+/// \brief Code for the read-only memory mapped file CMappedFile.
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+  #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+  #endif
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+CMappedFile::CMappedFile(){
+} //constructor
+
+CMappedFile::~CMappedFile(){
+  close();
+} //destructor
+
+/// Map a file into memory, closing any file that was already open.
+/// \param filename Name of the file.
+/// \return true if the file was opened and mapped.
+
+bool CMappedFile::open(const char* filename){
+  close();
+
+#ifdef _WIN32
+  HANDLE hFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if(hFile == INVALID_HANDLE_VALUE)return false;
+  m_hFile = hFile;
+
+  LARGE_INTEGER size;
+
+  if(!GetFileSizeEx(hFile, &size) || size.QuadPart == 0){
+    close();
+    return false;
+  } //if
+
+  m_nSize = (size_t)size.QuadPart;
+  m_hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+  if(m_hMapping == nullptr){
+    close();
+    return false;
+  } //if
+
+  m_pData = (const unsigned char*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+#else
+  m_nFile = ::open(filename, O_RDONLY);
+  if(m_nFile < 0)return false;
+
+  struct stat st;
+
+  if(fstat(m_nFile, &st) != 0 || st.st_size == 0){
+    close();
+    return false;
+  } //if
+
+  m_nSize = (size_t)st.st_size;
+  void* p = mmap(nullptr, m_nSize, PROT_READ, MAP_PRIVATE, m_nFile, 0);
+  m_pData = p == MAP_FAILED? nullptr: (const unsigned char*)p;
+#endif
+
+  if(m_pData == nullptr){
+    close();
+    return false;
+  } //if
+
+  return true;
+} //open
+
+/// Unmap the file and release the handles, if any.
+
+void CMappedFile::close(){
+#ifdef _WIN32
+  if(m_pData)UnmapViewOfFile(m_pData);
+  if(m_hMapping)CloseHandle(m_hMapping);
+  if(m_hFile)CloseHandle(m_hFile);
+
+  m_hMapping = m_hFile = nullptr;
+#else
+  if(m_pData)munmap((void*)m_pData, m_nSize);
+  if(m_nFile >= 0)::close(m_nFile);
+
+  m_nFile = -1;
+#endif
+
+  m_pData = nullptr;
+  m_nSize = 0;
+} //close
+
+/// Reader function for the start of the mapped view.
+/// \return Pointer to the first byte of the file, or nullptr if not open.
+
+const unsigned char* CMappedFile::GetData() const{
+  return m_pData;
+} //GetData
+
+/// Reader function for the size of the file.
+/// \return Size of the file in bytes, or zero if not open.
+
+size_t CMappedFile::GetSize() const{
+  return m_nSize;
+} //GetSize
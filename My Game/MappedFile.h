@@ -0,0 +1,36 @@
+/// \file MappedFile.h
+/// \brief Interface for the read-only memory mapped file CMappedFile.
+
+#pragma once
+
+#include <stddef.h>
+
+/// \brief A read-only memory mapped file.
+///
+/// The file's contents are mapped into the address space when it is
+/// opened and unmapped when it is closed or the CMappedFile goes out of
+/// scope. Pages are read from disk only when they are touched, so opening
+/// even a large file costs next to nothing.
+
+class CMappedFile{
+  private:
+    const unsigned char* m_pData = nullptr; ///< Start of the mapped view.
+    size_t m_nSize = 0; ///< Size of the file in bytes.
+
+#ifdef _WIN32
+    void* m_hFile = nullptr; ///< File handle.
+    void* m_hMapping = nullptr; ///< File mapping handle.
+#else
+    int m_nFile = -1; ///< File descriptor.
+#endif
+
+  public:
+    CMappedFile(); ///< Constructor.
+    ~CMappedFile(); ///< Destructor.
+
+    bool open(const char* filename); ///< Map a file.
+    void close(); ///< Unmap the file.
+
+    const unsigned char* GetData() const; ///< Get start of mapped view.
+    size_t GetSize() const; ///< Get size in bytes.
+}; //CMappedFile
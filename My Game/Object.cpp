@@ -6,6 +6,7 @@
 #include "GameDefines.h"
 #include "Particle.h"
 #include "ParticleEngine.h"
+#include "ObjectManager.h"
 
 #include "DebugPrintf.h"
 
@@ -358,10 +359,19 @@ void CObject::DeathFX(){
 /// will get deleted later at the appropriate time.
 
 void CObject::kill(){
-  m_bDead = true;
+  MarkDead();
   DeathFX();
 } //kill
 
+/// Mark the "is dead" flag and tell the object manager, which queues
+/// the object for removal at the end of the step. Every way of dying
+/// must come through here.
+
+void CObject::MarkDead(){
+  m_bDead = true;
+  m_pObjectManager->QueueDeath(this);
+} //MarkDead
+
 bool CObject::tooOld()
 {
   return (m_pTimer->time() - m_fBirthTime) > m_fLifeTime;
@@ -12,6 +12,14 @@
 enum State { PATROL, ATTACK };
 enum JumpState {GROUND, SINGLEJUMP, DOUBLEJUMP};
 
+/// \brief How much work an object needs each physics step.
+
+enum eActivity{
+  ACTIVE_OBJECT, ///< Moved and collided every step.
+  SLEEPING_OBJECT, ///< At rest until something touches it.
+  STATIC_OBJECT ///< Never moves, only ever asked about.
+}; //eActivity
+
 /// \brief The game object. 
 ///
 /// CObject is the abstract representation of an object.
@@ -22,10 +30,32 @@ class CObject:
   public CSpriteDesc2D
 {
   friend class CObjectManager;
+  friend class CSpatialGrid;
+  friend class CAIScheduler;
+  friend class CProjectilePool;
   protected:
     BoundingSphere m_Sphere; ///< Bounding sphere.
     BoundingBox m_Aabb; ///< Axially aligned bounding box.
 
+    bool m_bInGrid = false; ///< Whether filed in the spatial grid.
+    unsigned m_nGridID = 0; ///< Order of insertion into the spatial grid.
+    unsigned m_nGridStamp = 0; ///< Last spatial grid query that saw this object.
+    int m_nCellX0 = 0; ///< Leftmost spatial grid cell covered.
+    int m_nCellY0 = 0; ///< Bottom spatial grid cell covered.
+    int m_nCellX1 = 0; ///< Rightmost spatial grid cell covered.
+    int m_nCellY1 = 0; ///< Top spatial grid cell covered.
+    bool m_bLevelObject = false; ///< Created by the level, so kept for restarts.
+
+    bool m_bListed = false; ///< Whether on the object manager's object list.
+    bool m_bDeathQueued = false; ///< Whether on the object manager's death queue.
+    size_t m_nListSlot = 0; ///< Index in the object manager's object list.
+    size_t m_nTypedSlot = 0; ///< Index in the object manager's list for its sprite type.
+    size_t m_nAISlot = 0; ///< Index in the AI scheduler, for turrets and guns.
+    eActivity m_nActivity = ACTIVE_OBJECT; ///< Whether active, sleeping, or static.
+    size_t m_nActiveSlot = 0; ///< Index in the object manager's active list.
+    float m_fOwedTime = 0.0f; ///< Time not yet stepped while far from the characters.
+    unsigned m_nStagger = 0; ///< Offset of its coarse moves, fixed when it is put on the object list.
+
 		//ripped from neds turkey farms
 		float m_fFrameTimer = 0.0f; ///< Last time the frame was changed.
 		float m_fFrameInterval = 0.1f; ///< Interval between frames.
@@ -59,6 +89,8 @@ class CObject:
     //float m_fGunTimer = 0.0f; ///< Gun fire timer.
 
 		bool m_bShieldUp = false; ///< state of the shield
+
+    void MarkDead(); ///< Set the "is dead" flag and queue for removal.
   public:
 
 		float m_fGunTimer = 0.0f; ///< Gun fire timer.
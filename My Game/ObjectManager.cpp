@@ -6,42 +6,219 @@
 #include "ParticleEngine.h"
 #include "Common.h"
 #include "DebugPrintf.h"
+#include "HeapCheck.h"
+#include "WorldHash.h"
+#include "Benchmark.h"
+#include "Profiler.h"
+
+#include <algorithm>
 
 #define TILESIZE 32
-/// Create the tile manager;
+
+#define LAYER(n) (1U << (n)) ///< Bit for a collision layer in a mask.
+
+/// \brief Collision filter for a sprite type.
+
+struct CollisionFilter{
+  eSpriteType m_nType; ///< Sprite type.
+  int m_nLayer; ///< Collision layer it is on, -1 for none.
+  unsigned m_nMask; ///< Collision layers that it looks for contacts in.
+}; //CollisionFilter
+
+/// Who looks for contacts with whom. Sprite types that aren't listed
+/// are on no layer and look for no contacts. This must agree with the
+/// contact lists that move() and MoveProjectiles() use.
+
+static const CollisionFilter COLLISION_FILTERS[] = {
+  {FIGHTER_SPRITE, -1, LAYER(PLATFORM_LAYER) | LAYER(DOOR_LAYER) | LAYER(BREAKABLE_LAYER) | LAYER(TELEPORTER_LAYER) | LAYER(KEY_LAYER)},
+  {FAST_SPRITE,    -1, LAYER(PLATFORM_LAYER) | LAYER(DOOR_LAYER) | LAYER(BREAKABLE_LAYER) | LAYER(TELEPORTER_LAYER) | LAYER(KEY_LAYER)},
+  {SHIELD_SPRITE,  -1, LAYER(PLATFORM_LAYER) | LAYER(DOOR_LAYER) | LAYER(BREAKABLE_LAYER) | LAYER(TELEPORTER_LAYER) | LAYER(KEY_LAYER)},
+  {TURRET_SPRITE, ENEMY_LAYER, LAYER(ENDPOINT_LAYER) | LAYER(DOOR_LAYER) | LAYER(BREAKABLE_LAYER)},
+  {ELEVATOR_SPRITE, PLATFORM_LAYER, LAYER(ENDPOINT_LAYER) | LAYER(STOP_LAYER)},
+  {KEY_SPRITE, KEY_LAYER, LAYER(BREAKABLE_LAYER)},
+  {SWORD_SPRITE, -1, LAYER(BREAKABLE_LAYER) | LAYER(SWITCH_LAYER) | LAYER(ENEMY_LAYER)},
+  {BULLET_SPRITE,  -1, LAYER(DOOR_LAYER) | LAYER(BREAKABLE_LAYER) | LAYER(SWITCH_LAYER) | LAYER(ENEMY_LAYER)},
+  {BULLET2_SPRITE, -1, LAYER(DOOR_LAYER) | LAYER(BREAKABLE_LAYER)},
+  {DOOR_SPRITE, DOOR_LAYER, 0},
+  {BREAKABLE_SPRITE, BREAKABLE_LAYER, 0},
+  {TELEPORTER_SPRITE, TELEPORTER_LAYER, 0},
+  {SWITCH_SPRITE, SWITCH_LAYER, 0},
+  {ENDPOINT_SPRITE, ENDPOINT_LAYER, 0},
+  {STOP_SPRITE, STOP_LAYER, 0},
+}; //COLLISION_FILTERS
+
+/// Layers whose objects are static, and so are in the static grid.
+
+static const unsigned STATIC_LAYERS =
+  LAYER(ENDPOINT_LAYER) | LAYER(STOP_LAYER) | LAYER(TELEPORTER_LAYER);
+
+/// Narrow phase handler for a turret running into a character,
+/// who takes damage unless the turret is already dead.
+/// \param turret Pointer to the turret.
+/// \param c Pointer to the character.
+
+static void TurretHitsCharacter(CObject* turret, CObject* c){
+  if(!turret->IsDead())
+    c->damage(1);
+} //TurretHitsCharacter
+
+/// \brief Narrow phase handler for a pair of objects.
+
+typedef void (*PairHandler)(CObject*, CObject*);
+
+/// \brief A narrow phase handler and the sprite types it is for.
+
+struct PairRule{
+  eSpriteType m_nType0; ///< Sprite type of the handler's first parameter.
+  eSpriteType m_nType1; ///< Sprite type of the handler's second parameter.
+  PairHandler m_pHandler; ///< The handler.
+}; //PairRule
+
+/// What happens when objects of two sprite types run into each other.
+/// Each pair is listed once, in either order.
+
+static constexpr PairRule PAIR_RULES[] = {
+  {TURRET_SPRITE, FAST_SPRITE, TurretHitsCharacter},
+  {TURRET_SPRITE, FIGHTER_SPRITE, TurretHitsCharacter},
+  {TURRET_SPRITE, SHIELD_SPRITE, TurretHitsCharacter},
+}; //PAIR_RULES
+
+/// \brief An entry in the narrow phase dispatch table.
+
+struct PairEntry{
+  PairHandler m_pHandler; ///< Handler, nullptr if nothing happens.
+  bool m_bSwap; ///< Whether the handler wants the objects the other way round.
+}; //PairEntry
+
+/// \brief The narrow phase dispatch table.
+
+struct PairTable{
+  PairEntry m_Entry[NUM_SPRITES][NUM_SPRITES]; ///< Entry for each pair of sprite types.
+  bool m_bAny[NUM_SPRITES]; ///< Whether each sprite type has any handlers at all.
+}; //PairTable
+
+/// Build the narrow phase dispatch table from PAIR_RULES at compile
+/// time. Each rule fills in both orders of its pair of sprite types,
+/// so the table is symmetric by construction.
+/// \return The narrow phase dispatch table.
+
+static constexpr PairTable MakePairTable(){
+  PairTable t = {};
+
+  for(auto const& r: PAIR_RULES){
+    t.m_Entry[r.m_nType0][r.m_nType1] = PairEntry{r.m_pHandler, false};
+
+    if(r.m_nType1 != r.m_nType0)
+      t.m_Entry[r.m_nType1][r.m_nType0] = PairEntry{r.m_pHandler, true};
+
+    t.m_bAny[r.m_nType0] = t.m_bAny[r.m_nType1] = true;
+  } //for
+
+  return t;
+} //MakePairTable
+
+static constexpr PairTable PAIR_TABLE = MakePairTable(); ///< Narrow phase dispatch table.
+
+/// Check that the narrow phase dispatch table is symmetric.
+/// \return true if it is.
+
+static constexpr bool IsSymmetric(){
+  for(int i=0; i<NUM_SPRITES; i++)
+    for(int j=0; j<NUM_SPRITES; j++)
+      if(PAIR_TABLE.m_Entry[i][j].m_pHandler != PAIR_TABLE.m_Entry[j][i].m_pHandler)
+        return false;
+
+  return true;
+} //IsSymmetric
+
+static_assert(IsSymmetric(), "The narrow phase dispatch table must be symmetric");
+
+static const float TURRET_AI_INTERVAL = 0.1f; ///< Time between turret perception updates.
+static const float GUN_AI_INTERVAL = 0.2f; ///< Time between gun perception updates.
+
+/// Create the tile manager and reserve the scratch space used by
+/// move(), so that once a level is under way a step never has to go
+/// to the heap.
 
 CObjectManager::CObjectManager(){
   m_pTileManager = new CTileManager(TILESIZE);
+  m_pSpatialGrid = new CSpatialGrid((float)TILESIZE, 4096);
+  m_pStaticGrid = new CSpatialGrid((float)TILESIZE, 1024);
+  m_pProjectiles = new CProjectilePool;
+  m_pAIScheduler = new CAIScheduler;
+
+  for(int i=0; i<NUM_SPRITES; i++){ //unlisted sprite types
+    m_nSpriteLayer[i] = -1;
+    m_nSpriteMask[i] = 0;
+  } //for
+
+  for(auto const& f: COLLISION_FILTERS){
+    m_nSpriteLayer[f.m_nType] = f.m_nLayer;
+    m_nSpriteMask[f.m_nType] = f.m_nMask;
+  } //for
+
+  m_vActiveList.reserve(DEFAULT_SCRATCH_SIZE);
+  m_vNeighbors.reserve(DEFAULT_SCRATCH_SIZE);
+  m_vWalls.reserve(DEFAULT_SCRATCH_SIZE);
+  m_vDeathQueue.reserve(DEFAULT_SCRATCH_SIZE);
+  m_vSightLines.reserve(DEFAULT_SCRATCH_SIZE);
+  m_vSightTargets.reserve(DEFAULT_SCRATCH_SIZE);
+
+  for(auto& contacts: m_vContacts)
+    contacts.reserve(DEFAULT_SCRATCH_SIZE);
 } //constructor
 
 /// Destruct all of the objects in the object list.
 
 CObjectManager::~CObjectManager(){
   delete m_pTileManager;
+  delete m_pSpatialGrid;
+  delete m_pStaticGrid;
+  delete m_pProjectiles;
+  delete m_pAIScheduler;
 
   for(auto const& p: m_stdObjectList) //for each object
-    delete p; //delete object
+    if(!p->m_bLevelObject) //level objects are deleted with the snapshot
+      delete p; //delete object
 
-	delete m_pSwordPointer;
-	delete m_pShieldPointer;
+  DeleteSnapshot();
+	delete m_pSwordObject;
 } //destructor
 
-/// Load a map from a text file into the tile manager.
+/// Get the file name of the level image for a level. The paths use
+/// forward slashes, which Windows is happy with, so that headless
+/// builds can load levels anywhere.
+/// \param level Level number.
+/// \return File name, or nullptr if there is no such level.
 
-void CObjectManager::LoadMap(int level){
+const char* CObjectManager::GetMapFileName(int level){
 	switch (level)
 	{
-	case 0: m_pTileManager->LoadMapFromImageFile("Media\\Maps\\level1Pixels.png"); break;
-	case 1: m_pTileManager->LoadMapFromImageFile("Media\\Maps\\Level2Pixels.png"); break;
-	case 2: m_pTileManager->LoadMapFromImageFile("Media\\Maps\\Level3Pixels.png"); break;
-	case 3: m_pTileManager->LoadMapFromImageFile("Media\\Maps\\Level4Pixels.png"); break;
-  case 4: m_pTileManager->LoadMapFromImageFile("Media\\Maps\\Level5Pixels.png"); break;
-	default: break; //leave the game
+	case 0: return "Media/Maps/level1Pixels.png";
+	case 1: return "Media/Maps/Level2Pixels.png";
+	case 2: return "Media/Maps/Level3Pixels.png";
+	case 3: return "Media/Maps/Level4Pixels.png";
+	case 4: return "Media/Maps/Level5Pixels.png";
+	default: return nullptr;
 	}
+} //GetMapFileName
+
+/// Load a map from a level image into the tile manager.
+/// \param level Level number.
+/// \param filename Level image file name, or nullptr for the level's own.
+
+void CObjectManager::LoadMap(int level, const char* filename){
+  PROFILE_SCOPE("CObjectManager::LoadMap");
+  CBenchmarkTimer timer(LOAD_TIMER);
+
+  if(filename == nullptr)
+    filename = GetMapFileName(level);
+
+  if(filename) //leave the game otherwise
+    m_pTileManager->LoadLevel(filename);
 
   m_pTileManager->setLevel(level);
-	m_pTileManager->MakeBoundingBoxes();
-  vector<Vector3> ladders = m_pTileManager->GetLadders();
+  const vector<Vector3>& ladders = m_pTileManager->GetLadders();
 
   for (auto l : ladders) {
     if (l.z == (float)LADDERL_SPRITE)
@@ -97,9 +274,181 @@ void CObjectManager::LoadMap(int level){
 	whichPlayer = 2;
 	m_pPlayer = characters.at(2);//set our player to that one
 	m_pShieldPlayer = characters.at(1);//set the pointer to the shield player
-	m_pShieldPointer = new CObject(SHIELDUP_SPRITE, m_pShieldPlayer->GetPos());
+	m_pShieldObject = new CObject(SHIELDUP_SPRITE, m_pShieldPlayer->GetPos());
+	m_pShieldPointer = m_pShieldObject;
+
+  TakeSnapshot(level, filename);
 } //LoadMap
 
+/// Start a level by restoring it from the snapshot if the snapshot is
+/// of that level, and by loading it fresh otherwise. Either way the
+/// level starts in the same state, so replays and headless runs can
+/// use this as well as the game. Once the level is under way, stepping
+/// it shouldn't allocate anything, which the headless -checkalloc run
+/// checks.
+/// \param level Level number.
+/// \param filename Level image file name, or nullptr for the level's own.
+
+void CObjectManager::StartLevel(int level, const char* filename){
+  if(!RestoreLevel(level, filename)){ //not loaded yet
+    clear(); //clear old objects
+    LoadMap(level, filename); //load map
+  } //if
+
+  m_pSpatialGrid->reserve(); //so that objects moving around don't make it allocate
+
+  if(m_pSwordObject == nullptr) //made once, and reused for every swing
+    m_pSwordObject = new CObject(SWORD_SPRITE, Vector2::Zero);
+} //StartLevel
+
+/// Remember the level as it is just after loading so that it can
+/// be restarted without going back to the disk. Every object on the
+/// object list is marked as a level object, which means that it will
+/// not be deleted when it dies, and a copy of it is made. The old
+/// snapshot must already have been deleted by clear().
+/// \param level The level that was just loaded.
+/// \param filename The level image file name, or nullptr if there is none.
+
+void CObjectManager::TakeSnapshot(int level, const char* filename){
+  for(auto const& p: m_stdObjectList){
+    p->m_bLevelObject = true;
+    m_vLevelObjects.push_back(p);
+    m_vPristine.push_back(clone(p));
+  } //for
+
+  m_vLevelCharacters = characters;
+  m_pPristineShield = clone(m_pShieldObject);
+  m_nSnapshotLevel = level;
+  m_strSnapshotFile = filename? filename: "";
+} //TakeSnapshot
+
+/// Delete the level objects, alive or dead, the shield, and the
+/// copies of them in the snapshot.
+
+void CObjectManager::DeleteSnapshot(){
+  for(auto const& p: m_vLevelObjects)
+    delete p;
+
+  for(auto const& p: m_vPristine)
+    delete p;
+
+  m_vLevelObjects.clear();
+  m_vPristine.clear();
+  m_vLevelCharacters.clear();
+
+  delete m_pShieldObject;
+  delete m_pPristineShield;
+
+  m_pShieldObject = m_pPristineShield = m_pShieldPointer = nullptr;
+  m_nSnapshotLevel = -1;
+  m_strSnapshotFile.clear();
+} //DeleteSnapshot
+
+/// Restart a level by copying the snapshot taken when it was loaded
+/// back over the level objects. Nothing is read from disk and no level
+/// objects are allocated. Objects created since, such as bullets and
+/// the sword, are removed, and everything else that clear() resets is
+/// reset too, so that the level plays out just as it would if it were
+/// loaded fresh.
+/// \param level The level to restart.
+/// \param filename Level image file name, or nullptr for the level's own.
+/// \return true if the snapshot is of that level and it was restored.
+
+bool CObjectManager::RestoreLevel(int level, const char* filename){
+  if(filename == nullptr)
+    filename = GetMapFileName(level);
+
+  if(level != m_nSnapshotLevel || m_strSnapshotFile != (filename? filename: ""))
+    return false;
+
+  for(auto const& p: m_stdObjectList)
+    if(!p->m_bLevelObject)
+      delete p;
+
+  m_pSwordPointer = nullptr; //the sword object itself is kept for the next swing
+  elevatorVel = 0.0f; //as clear() does
+  m_nStepCount = 0;
+
+  m_stdObjectList.clear(); //vectors keep their capacity
+  m_vActiveList.clear();
+	m_stdEndPointList.clear();
+  m_stdStopPointList.clear();
+	m_stdPlatformList.clear();
+	m_vSwitchList.clear();
+	m_vTrapList.clear();
+	m_stdDoorList.clear();
+	m_vTeleporterList.clear();
+	m_vTeleportSpawns.clear();
+	m_vBreakableWallList.clear();
+	m_vKeys.clear();
+	m_vEnemies.clear();
+  m_vGuns.clear();
+  m_pSpatialGrid->clear();
+  m_pStaticGrid->clear();
+  m_pProjectiles->clear();
+  m_nEvictions = 0;
+  m_pAIScheduler->clear();
+  m_vDeathQueue.clear();
+
+  //timers that the constructor started from the current time
+  const float now = m_pTimer->time();
+
+  for(size_t i=0; i<m_vLevelObjects.size(); i++){
+    CObject* p = m_vLevelObjects[i];
+    copy(p, m_vPristine[i]);
+    p->m_fGunTimer = p->m_fBirthTime = now;
+    insert(p);
+  } //for
+
+  copy(m_pShieldObject, m_pPristineShield);
+  m_pShieldObject->m_fGunTimer = m_pShieldObject->m_fBirthTime = now;
+  m_pShieldPointer = m_pShieldObject;
+
+  characters = m_vLevelCharacters;
+	whichPlayer = 2;
+	m_pPlayer = characters.at(2);
+	m_pShieldPlayer = characters.at(1);
+
+  return true;
+} //RestoreLevel
+
+/// Make a copy of an object, of the right class for its sprite type.
+/// This must agree with create().
+/// \param p Pointer to an object.
+/// \return Pointer to a new copy of the object.
+
+CObject* CObjectManager::clone(CObject* p){
+  switch(p->m_nSpriteIndex){
+    case ELEVATOR_SPRITE: return new Elevator(*(Elevator*)p);
+    case TURRET_SPRITE:   return new EvilNPC(*(EvilNPC*)p);
+    case GUN_SPRITE:      return new GunTurret(*(GunTurret*)p);
+    case ELECTRIC_SPRITE: return new Trap(*(Trap*)p);
+    case SWITCH_SPRITE:   return new Switch(*(Switch*)p);
+    case DOOR_SPRITE:     return new Door(*(Door*)p);
+    case KEY_SPRITE:      return new Key(*(Key*)p);
+    default:              return new CObject(*p);
+  } //switch
+} //clone
+
+/// Copy the state of one object into another of the same class,
+/// which is determined by the sprite type of the source.
+/// This must agree with create().
+/// \param dest Pointer to the object to copy into.
+/// \param src Pointer to the object to copy from.
+
+void CObjectManager::copy(CObject* dest, CObject* src){
+  switch(src->m_nSpriteIndex){
+    case ELEVATOR_SPRITE: *(Elevator*)dest = *(Elevator*)src; break;
+    case TURRET_SPRITE:   *(EvilNPC*)dest = *(EvilNPC*)src; break;
+    case GUN_SPRITE:      *(GunTurret*)dest = *(GunTurret*)src; break;
+    case ELECTRIC_SPRITE: *(Trap*)dest = *(Trap*)src; break;
+    case SWITCH_SPRITE:   *(Switch*)dest = *(Switch*)src; break;
+    case DOOR_SPRITE:     *(Door*)dest = *(Door*)src; break;
+    case KEY_SPRITE:      *(Key*)dest = *(Key*)src; break;
+    default:              *dest = *src; break;
+  } //switch
+} //copy
+
 /// Create an object and put a pointer to it on the object list.
 /// \param t Sprite type.
 /// \param v Initial position..
@@ -110,56 +459,14 @@ CObject* CObjectManager::create(eSpriteType t, const Vector2& v) {
   CObject* p = nullptr;
 
   // create the appropriate object based on sprite type
-  // push onto the corresponding list
   switch (t){
-
-    case ELEVATOR_SPRITE: {
-      p = new Elevator(DOWN, true, t, v);
-      m_stdPlatformList.push_back(p);
-    } break;
-
-    case ENDPOINT_SPRITE: {
-      p = new CObject(t, v);
-      m_stdEndPointList.push_back(p);
-    } break;
-
-		case STOP_SPRITE: {
-			p = new CObject(t, v);
-			m_stdStopPointList.push_back(p);
-		}break;
-
-    case TURRET_SPRITE: {
-      p = new EvilNPC(ATTACK, Vector2(1.0f, 1.0f), 1.0f, t, v);
-			m_vEnemies.push_back(p);
-    } break;
-
-		case TELEPORTER_SPRITE: {
-			p = new CObject(t, v);
-			m_vTeleporterList.push_back(p);
-		}break;
-
-		case BREAKABLE_SPRITE: {
-			p = new CObject(t, v);
-			m_vBreakableWallList.push_back(p);
-		}break;
-
-		case TELEPORTSPAWN_SPRITE: {
-			p = new CObject(t, v);
-			m_vTeleportSpawns.push_back(p);
-		}break;
-
-    case GUN_SPRITE: {
-      p = new GunTurret(RIGHT,t, v);
-      m_vGuns.push_back(p);
-    }break;
-
-    default: {
-      p = new CObject(t, v);
-    } break;
-
+    case ELEVATOR_SPRITE: p = new Elevator(DOWN, true, t, v); break;
+    case TURRET_SPRITE: p = new EvilNPC(ATTACK, Vector2(1.0f, 1.0f), 1.0f, t, v); break;
+    case GUN_SPRITE: p = new GunTurret(RIGHT,t, v); break;
+    default: p = new CObject(t, v); break;
   }//switch
 
-  m_stdObjectList.push_back(p);
+  insert(p);
 
   return p;
 } //create
@@ -169,36 +476,236 @@ CObject* CObjectManager::create(eSpriteType t, const Vector2& v, int i)
 	CObject* p = nullptr;
 
 	switch (t) {
-		case ELECTRIC_SPRITE: {
-			p = new Trap(true, i, t, v);
-			m_vTrapList.push_back(p);
-		}break;
-
-		case SWITCH_SPRITE: {
-			p = new Switch(false, i, t, v);
-			m_vSwitchList.push_back(p);
-		}break;
-
-		case DOOR_SPRITE: {
-			
-				p = new Door(t, v, i); //door with a lock
-				m_stdDoorList.push_back(p);
-			
-		}break;
-
-		case KEY_SPRITE: {
-			p = new Key(t, v, i); //door with a lock
-			m_vKeys.push_back(p);
-		}
-
+		case ELECTRIC_SPRITE: p = new Trap(true, i, t, v); break;
+		case SWITCH_SPRITE: p = new Switch(false, i, t, v); break;
+		case DOOR_SPRITE: p = new Door(t, v, i); break; //door with a lock
+		case KEY_SPRITE: p = new Key(t, v, i); break;
 		default: break;
 	}//switch
 
-	m_stdObjectList.push_back(p);
+	insert(p);
 
 	return p;
 }
 
+/// Get the list that objects of a given sprite type are kept on
+/// in addition to the object list.
+/// \param t Sprite type.
+/// \return Pointer to the list, nullptr if there isn't one.
+
+vector<CObject*>* CObjectManager::GetTypedList(unsigned t){
+  switch (t){
+    case ELEVATOR_SPRITE: return &m_stdPlatformList;
+    case ENDPOINT_SPRITE: return &m_stdEndPointList;
+		case STOP_SPRITE: return &m_stdStopPointList;
+    case TURRET_SPRITE: return &m_vEnemies;
+		case TELEPORTER_SPRITE: return &m_vTeleporterList;
+		case BREAKABLE_SPRITE: return &m_vBreakableWallList;
+		case TELEPORTSPAWN_SPRITE: return &m_vTeleportSpawns;
+    case GUN_SPRITE: return &m_vGuns;
+		case ELECTRIC_SPRITE: return &m_vTrapList;
+		case SWITCH_SPRITE: return &m_vSwitchList;
+		case DOOR_SPRITE: return &m_stdDoorList;
+		case KEY_SPRITE: return &m_vKeys;
+    default: return nullptr;
+  }//switch
+} //GetTypedList
+
+/// Get the activity that objects of a given sprite type start out
+/// with. Static objects never move or die, so they are kept out of
+/// the physics step altogether and only ever asked about. Sleeping
+/// objects are skipped by the physics step until something touches
+/// them. Everything else is active.
+/// \param t Sprite type.
+/// \return Activity for a new object of that type.
+
+eActivity CObjectManager::GetActivity(unsigned t){
+  switch (t){
+    case LADDERL_SPRITE:
+    case LADDERR_SPRITE:
+    case ENDPOINT_SPRITE:
+    case STOP_SPRITE:
+    case TELEPORTER_SPRITE:
+    case TELEPORTSPAWN_SPRITE:
+    case EXIT_SPRITE:
+      return STATIC_OBJECT;
+
+    case BREAKABLE_SPRITE:
+      return SLEEPING_OBJECT;
+
+    default: return ACTIVE_OBJECT;
+  }//switch
+} //GetActivity
+
+/// Find out whether objects of a given sprite type go to sleep when
+/// they come to rest. Keys start out awake so that they can fall.
+/// \param t Sprite type.
+/// \return true if they can sleep.
+
+bool CObjectManager::CanSleep(unsigned t){
+  return t == KEY_SPRITE || t == BREAKABLE_SPRITE;
+} //CanSleep
+
+/// Wake a sleeping object by putting it at the end of the active list.
+/// \param p Pointer to an object.
+
+void CObjectManager::wake(CObject* p){
+  if(p->m_nActivity != SLEEPING_OBJECT)return;
+
+  p->m_nActivity = ACTIVE_OBJECT;
+  p->m_nActiveSlot = m_vActiveList.size();
+  m_vActiveList.push_back(p);
+} //wake
+
+/// Put an active object to sleep. It stays in the broad phase grid so
+/// that it can be woken, and leaves a hole in the active list that is
+/// closed up at the end of the step.
+/// \param p Pointer to an object.
+
+void CObjectManager::sleep(CObject* p){
+  if(p->m_nActivity != ACTIVE_OBJECT)return;
+
+  p->m_nActivity = SLEEPING_OBJECT;
+  m_vActiveList[p->m_nActiveSlot] = nullptr;
+} //sleep
+
+/// Wake any sleeping objects that are touching an object, for example
+/// a key resting on a wall that has just been broken.
+/// \param p Pointer to an object.
+
+void CObjectManager::WakeNeighbors(CObject* p){
+  m_pSpatialGrid->GetNeighbors(p, m_vNeighbors);
+
+  for(auto const& q: m_vNeighbors)
+    if(q->m_nActivity == SLEEPING_OBJECT && p->m_Aabb.Intersects(q->m_Aabb))
+      wake(q);
+} //WakeNeighbors
+
+/// Close up the holes left in the active list by objects that went
+/// to sleep or died, keeping the rest in the same order.
+
+void CObjectManager::CompactActiveList(){
+  size_t j = 0;
+
+  for(size_t i=0; i<m_vActiveList.size(); i++)
+    if(m_vActiveList[i]){
+      m_vActiveList[j] = m_vActiveList[i];
+      m_vActiveList[j]->m_nActiveSlot = j;
+      j++;
+    } //if
+
+  m_vActiveList.resize(j);
+} //CompactActiveList
+
+/// Find out whether an object is in the activity region, which is a
+/// square reaching m_nActivityRadius tiles out from each character.
+/// Anything in it is simulated every step, anything outside it only
+/// every m_nCoarseSteps steps.
+/// \param p Pointer to an object.
+/// \return true if the object is near a character.
+
+bool CObjectManager::InActivityRegion(CObject* p){
+  if(m_nActivityRadius <= 0 || characters.empty())
+    return true; //simulate everything
+
+  const float r = m_nActivityRadius*(float)TILESIZE;
+
+  for(auto const& c: characters)
+    if(fabsf(p->m_vPos.x - c->m_vPos.x) <= r && fabsf(p->m_vPos.y - c->m_vPos.y) <= r)
+      return true;
+
+  return false;
+} //InActivityRegion
+
+/// Find out whether an object must be moved every step wherever it
+/// is. The characters carry the activity region around with them,
+/// keys fall too fast to be moved in big steps, and an elevator that
+/// someone is riding has to keep in step with its rider.
+/// \param p Pointer to an object.
+/// \return true if the object is exempt from coarse moves.
+
+bool CObjectManager::IsExempt(CObject* p){
+  switch (p->m_nSpriteIndex){
+    case FIGHTER_SPRITE:
+    case FAST_SPRITE:
+    case SHIELD_SPRITE:
+    case KEY_SPRITE:
+      return true;
+
+    case ELEVATOR_SPRITE:
+      for(auto const& c: characters)
+        if(c->m_bOnElevator && c->GetBoundingBox().Intersects(p->GetBoundingBox()))
+          return true;
+      return false;
+
+    default: return false;
+  }//switch
+} //IsExempt
+
+/// Set the size of the activity region and how often objects outside
+/// it are moved. However big steps is, the time owed is paid back in
+/// moves of at most MAX_COARSE_STEPS steps, so that a turret standing
+/// on the floor doesn't fall through it in a single move.
+/// \param radius Reach of the activity region in tiles, 0 for everywhere.
+/// \param steps Number of steps per move outside the activity region.
+
+void CObjectManager::SetActivityRegion(int radius, unsigned steps){
+  m_nActivityRadius = radius;
+  m_nCoarseSteps = max(steps, 1U);
+} //SetActivityRegion
+
+/// Put an object on the object list and on the list for its
+/// sprite type, if any, recording where it went in each so that
+/// it can be taken off again without searching.
+/// \param p Pointer to an object.
+
+void CObjectManager::insert(CObject* p){
+  vector<CObject*>* pList = GetTypedList(p->m_nSpriteIndex);
+
+  if(pList){
+    p->m_nTypedSlot = pList->size();
+    pList->push_back(p);
+  } //if
+
+  if(p->m_nSpriteIndex == TURRET_SPRITE) //enemies that look around
+    m_pAIScheduler->insert(p, TURRET_AI_INTERVAL);
+  else if(p->m_nSpriteIndex == GUN_SPRITE)
+    m_pAIScheduler->insert(p, GUN_AI_INTERVAL);
+
+  p->m_nActivity = GetActivity(p->m_nSpriteIndex);
+  p->m_bInGrid = false; //filed afresh, even if copied from the snapshot
+
+  if(p->m_nActivity == STATIC_OBJECT)
+    m_pStaticGrid->update(p); //filed once and for all
+  else{
+    m_pSpatialGrid->update(p); //so that it can be found by FindContacts()
+
+    if(p->m_nActivity == ACTIVE_OBJECT){
+      p->m_nActiveSlot = m_vActiveList.size();
+      m_vActiveList.push_back(p);
+    } //if
+  } //else
+
+  p->m_nListSlot = m_stdObjectList.size();
+  p->m_nStagger = (unsigned)p->m_nListSlot; //unlike the slots, this never changes
+  p->m_bListed = true;
+  p->m_bDeathQueued = false;
+  m_stdObjectList.push_back(p);
+} //insert
+
+/// Queue an object that has just died for removal at the end of the
+/// step. Each object is queued at most once however many times it is
+/// killed, and objects that aren't on the object list, such as bullets
+/// and the sword, are ignored.
+/// \param p Pointer to an object.
+
+void CObjectManager::QueueDeath(CObject* p){
+  if(p->m_bListed && !p->m_bDeathQueued){
+    p->m_bDeathQueued = true;
+    m_vDeathQueue.push_back(p);
+  } //if
+} //QueueDeath
+
 
 /// Delete all of the objects managed by the object manager. 
 /// This involves deleting all of the CObject instances pointed
@@ -206,10 +713,19 @@ CObject* CObjectManager::create(eSpriteType t, const Vector2& v, int i)
 
 void CObjectManager::clear(){
   for(auto const& p: m_stdObjectList) //for each object
-    delete p; //delete object
+    if(!p->m_bLevelObject) //level objects are deleted with the snapshot
+      delete p; //delete object
+
+  DeleteSnapshot();
+
+  m_pSwordPointer = nullptr; //the sword object itself is kept for the next swing
+  elevatorVel = 0.0f; //so that a fresh level always starts the same way
+  m_nStepCount = 0; //and so do the coarse moves
 
   m_stdObjectList.clear(); //clear the object list
+  m_vActiveList.clear();
 	m_stdEndPointList.clear();
+  m_stdStopPointList.clear();
 	m_stdPlatformList.clear();
 	m_vSwitchList.clear();
 	m_vTrapList.clear();
@@ -222,7 +738,12 @@ void CObjectManager::clear(){
   m_vGuns.clear();
 
 	m_pTileManager->clear();
-
+  m_pSpatialGrid->clear();
+  m_pStaticGrid->clear();
+  m_pProjectiles->clear();
+  m_nEvictions = 0;
+  m_pAIScheduler->clear();
+  m_vDeathQueue.clear();
 } //clear
 
 /// Draw the tiled background and all of the objects.
@@ -242,6 +763,14 @@ void CObjectManager::draw(){
       m_pRenderer->DrawBoundingBox(p->GetBoundingBox());
   } //for
 
+  for(size_t i=0; i<m_pProjectiles->size(); i++){ //for each bullet
+    CObject* const p = m_pProjectiles->GetProjectile(i);
+    m_pRenderer->Draw(*(CSpriteDesc2D*)p);
+
+    if(m_bDrawAABBs)
+      m_pRenderer->DrawBoundingBox(p->GetBoundingBox());
+  } //for
+
   if (m_pSwordPointer) 
   {
     m_pRenderer->Draw(*(CSpriteDesc2D*)m_pSwordPointer);
@@ -259,311 +788,287 @@ void CObjectManager::draw(){
 	}
 } //draw
 
-/// Move all of the objects and perform 
-/// broad phase collision detection and response.
-
-void CObjectManager::move(const float & t) {
-	if (state == TITLE_STATE) // if we are in the title state we just want to bail
-		return;
-
-	bool ladderFlag = false;//say we arent on a ladder
-
-	for (auto const & p : m_stdObjectList) { //for each object
-		const Vector2 oldpos = p->m_vPos; //its old position
-
-		p->move(t); //move it
-
-		//object to wall collision detection and response using
-		//bounding spheres for the objects and AABBs for the walls.
-
-		vector <BoundingBox> walls; //bounding boxes for wall collision
-
-		// wall collision
-		if (m_pTileManager->CollideWithWall(p->GetBoundingBox(), walls))
-		{
-			switch (p->m_nSpriteIndex) {
-			case KEY_SPRITE:
-			case FIGHTER_SPRITE:
-			case FAST_SPRITE:
-			case SHIELD_SPRITE:
-				for (auto const& b : walls)
-					p->CollisionResponse(b);
-				break;
-			case TURRET_SPRITE:
-				for (auto const& b : walls)
-					((EvilNPC*)p)->CollisionResponse(b);
-				break;
-			case BULLET2_SPRITE:
-			case BULLET_SPRITE:
-				p->kill();
-				m_pAudio->play(RICOCHET_SOUND);
-				break;
-			default: break;
-      } //switch
-    }//if collide with wall
-
-    // object specific collision
-    switch (p->m_nSpriteIndex) {
-		case KEY_SPRITE:
-			for (auto const& w : m_vBreakableWallList) {
-				if (p->GetBoundingBox().Intersects(w->GetBoundingBox())) {
-					p->CollisionResponse(w->GetBoundingBox()); 
-				}
+/// Move an active object once, then do its collision detection and
+/// response with the walls and with the objects that it might be
+/// touching, and put it to sleep if it has come to rest.
+/// \param p Pointer to an object.
+/// \param dt Time to move it by.
+
+void CObjectManager::MoveObject(CObject* p, float dt){
+	const Vector2 oldpos = p->m_vPos; //its old position
+
+	p->move(dt); //move it
+	m_pSpatialGrid->update(p); //refile if it changed cells
+
+	//object to wall collision detection and response using
+	//bounding spheres for the objects and AABBs for the walls.
+
+	// wall collision, only for the objects that respond to it
+	switch (p->m_nSpriteIndex) {
+	case KEY_SPRITE:
+	case FIGHTER_SPRITE:
+	case FAST_SPRITE:
+	case SHIELD_SPRITE:
+		if (m_pTileManager->CollideWithWall(p->GetBoundingBox(), m_vWalls))
+			for (auto const& b : m_vWalls)
+				p->CollisionResponse(b);
+		break;
+	case TURRET_SPRITE:
+		if (m_pTileManager->CollideWithWall(p->GetBoundingBox(), m_vWalls))
+			for (auto const& b : m_vWalls)
+				((EvilNPC*)p)->CollisionResponse(b);
+		break;
+	default: break;
+	} //switch
+
+  FindContacts(p); //what it might be touching, by layer
+
+  // object specific collision
+  switch (p->m_nSpriteIndex) {
+	case KEY_SPRITE:
+		for (auto const& w : m_vContacts[BREAKABLE_LAYER]) {
+			if (p->GetBoundingBox().Intersects(w->GetBoundingBox())) {
+				p->CollisionResponse(w->GetBoundingBox()); 
 			}
-			break;
-    case BULLET_SPRITE: // player projecties
-      // collide with regular doors
-      for (auto const& d : m_stdDoorList) {
-        if (!((Door*)d)->getIsOpen() && p->GetBoundingBox().Intersects(d->GetBoundingBox())) {
-          p->kill();
-          m_pAudio->play(RICOCHET_SOUND);
-        }
-      }
-      // breakable walls
-      for (auto const& w : m_vBreakableWallList) {
-        if (p->GetBoundingBox().Intersects(w->GetBoundingBox())) {
-          p->kill();
-          m_pAudio->play(RICOCHET_SOUND);
-          w->kill();
-        }
+		}
+		break;
+  case FIGHTER_SPRITE:
+  case FAST_SPRITE:
+  case SHIELD_SPRITE:
+    p->m_bOnElevator = false;
+
+    //platforms
+    for (auto const& e : m_vContacts[PLATFORM_LAYER]) {
+      if (p->GetBoundingBox().Intersects(e->GetBoundingBox())) {
+        p->elevatorResponse(e->GetBoundingBox());
+        p->m_bOnElevator = true;
       }
-      // switches
-      for (auto const & s : m_vSwitchList) {
-        if (p->GetBoundingBox().Intersects(s->GetBoundingBox())) {
-          ((Switch*)s)->flipTrapSwitch();
-          p->kill();
+    }
+    //doors
+    for (auto const& d : m_vContacts[DOOR_LAYER]) {
+      if (!((Door*)d)->getIsOpen() && p->GetBoundingBox().Intersects(d->GetBoundingBox()))
+        p->CollisionResponse(d->GetBoundingBox());
+    }
+    // breakable walls
+    for (auto const& w : m_vContacts[BREAKABLE_LAYER]) {
+      if (p->GetBoundingBox().Intersects(w->GetBoundingBox()))
+        p->CollisionResponse(w->GetBoundingBox());
+    }
+    // teleporters
+    for (auto & t : m_vContacts[TELEPORTER_LAYER]) {
+      if (m_pPlayer->m_bInteract && p->GetBoundingBox().Intersects(t->GetBoundingBox())) {
+        for (auto & ts : m_vTeleportSpawns) {
+          p->m_vPos = ts->GetPos();
         }
       }
-      // enemies
-      //for (auto const& w : m_vEnemies) {
-      //  if (p->GetBoundingBox().Intersects(w->GetBoundingBox())) {
-      //    p->kill();
-      //    m_pAudio->play(RICOCHET_SOUND);
-      //    w->kill();
-      //  }
-      //}
-      break;
-    case BULLET2_SPRITE: // enemy projectiles
-      // doors
-      for (auto const& d : m_stdDoorList) {
-        if (!((Door*)d)->getIsOpen() && p->GetBoundingBox().Intersects(d->GetBoundingBox())) {
-          p->kill();
-          m_pAudio->vary(RICOCHET_SOUND,0.2f);
-        }
+    }
+    // keys
+    for (auto & k : m_vContacts[KEY_LAYER]) {
+      if (p->GetBoundingBox().Intersects(k->GetBoundingBox())) {
+        ((Key*)k)->unlockDoors();
       }
-      // shields
-      if (m_pShieldPointer && p->GetBoundingBox().Intersects(m_pShieldPointer->GetBoundingBox())) {
-        p->kill();
-        m_pAudio->vary(RICOCHET_SOUND, 0.1f);
+    }
+    break;
+  case ELEVATOR_SPRITE:
+    // endpoints
+    for (auto const& ep : m_vContacts[ENDPOINT_LAYER]) {
+      if (p->GetBoundingBox().Intersects(ep->GetBoundingBox())) {
+        if (p->GetVelocity().y < 0.0f && p->GetBoundingBox().Center.y >= ep->GetBoundingBox().Center.y)
+          ((Elevator*)p)->turnAround();
+        else if (p->GetVelocity().y > 0.0f && p->GetBoundingBox().Center.y <= ep->GetBoundingBox().Center.y)
+          ((Elevator*)p)->turnAround();
       }
-      for (auto const& w : m_vBreakableWallList) {
-        if (p->GetBoundingBox().Intersects(w->GetBoundingBox())) {
-          p->kill();
-          m_pAudio->play(RICOCHET_SOUND);
-        }
+    }
+    // stops 
+    for (auto const& ep : m_vContacts[STOP_LAYER]) {
+      if (p->GetBoundingBox().Intersects(ep->GetBoundingBox())) {
+        if (p->GetVelocity().y < 0.0f && p->GetBoundingBox().Center.y <= ep->GetBoundingBox().Center.y && !((Elevator*)p)->justGotOffStop) 
+          ((Elevator*)p)->stop(ep->m_vPos);
           
+        else if (p->GetVelocity().y > 0.0f && p->GetBoundingBox().Center.y >= ep->GetBoundingBox().Center.y && !((Elevator*)p)->justGotOffStop)
+          ((Elevator*)p)->stop(ep->m_vPos);
       }
-      break;
-    case FIGHTER_SPRITE:
-    case FAST_SPRITE:
-    case SHIELD_SPRITE:
-      p->m_bOnElevator = false;
+        
+		}
+		break;
+	case TURRET_SPRITE: {
 
-      //platforms
-      for (auto const& e : m_stdPlatformList) {
-        if (p->GetBoundingBox().Intersects(e->GetBoundingBox())) {
-          p->elevatorResponse(e->GetBoundingBox());
-          p->m_bOnElevator = true;
-        }
-      }
-      //doors
-      for (auto const& d : m_stdDoorList) {
-        if (!((Door*)d)->getIsOpen() && p->GetBoundingBox().Intersects(d->GetBoundingBox()))
-          p->CollisionResponse(d->GetBoundingBox());
-      }
-      // breakable walls
-      for (auto const& w : m_vBreakableWallList) {
-        if (p->GetBoundingBox().Intersects(w->GetBoundingBox()))
-          p->CollisionResponse(w->GetBoundingBox());
-      }
-      // teleporters
-      for (auto & t : m_vTeleporterList) {
-        if (m_pPlayer->m_bInteract && p->GetBoundingBox().Intersects(t->GetBoundingBox())) {
-          for (auto & ts : m_vTeleportSpawns) {
-            p->m_vPos = ts->GetPos();
-          }
-        }
-      }
-      // keys
-      for (auto & k : m_vKeys) {
-        if (p->GetBoundingBox().Intersects(k->GetBoundingBox())) {
-          ((Key*)k)->unlockDoors();
-        }
+    // look around only when the scheduler says so
+    if (m_pAIScheduler->IsDue(p))
+      m_pAIScheduler->SetPerception(p, PerceiveTurret(p));
+
+    CObject* target = m_pAIScheduler->GetPerception(p).m_pTarget;
+
+    if (target && find(characters.begin(), characters.end(), target) == characters.end())
+      target = nullptr; // died since we saw them
+
+    if (target) {
+      // attack
+      p->setState(ATTACK);
+
+      const float closest = target->m_vPos.x - p->m_vPos.x;
+
+      // player to the right
+      if (closest > 0.0f) {
+        p->turn(RIGHT);
       }
-      break;
-    case ELEVATOR_SPRITE:
-      // endpoints
-      for (auto const& ep : m_stdEndPointList) {
-        if (p->GetBoundingBox().Intersects(ep->GetBoundingBox())) {
-          if (p->GetVelocity().y < 0.0f && p->GetBoundingBox().Center.y >= ep->GetBoundingBox().Center.y)
-            ((Elevator*)p)->turnAround();
-          else if (p->GetVelocity().y > 0.0f && p->GetBoundingBox().Center.y <= ep->GetBoundingBox().Center.y)
-            ((Elevator*)p)->turnAround();
-        }
+      else if (closest < 0.0f) {
+        p->turn(LEFT);
       }
-      // stops 
-      for (auto const& ep : m_stdStopPointList) {
-        if (p->GetBoundingBox().Intersects(ep->GetBoundingBox())) {
-          if (p->GetVelocity().y < 0.0f && p->GetBoundingBox().Center.y <= ep->GetBoundingBox().Center.y && !((Elevator*)p)->justGotOffStop) 
-            ((Elevator*)p)->stop(ep->m_vPos);
-            
-          else if (p->GetVelocity().y > 0.0f && p->GetBoundingBox().Center.y >= ep->GetBoundingBox().Center.y && !((Elevator*)p)->justGotOffStop)
-            ((Elevator*)p)->stop(ep->m_vPos);
-        }
-          
-			}
-			break;
-		case LADDERL_SPRITE:
-		case LADDERR_SPRITE: {
-			if (p->GetBoundingBox().Intersects(m_pPlayer->GetBoundingBox()))
-				ladderFlag = true;//say we are on a ladder
-		}break;
 
-    case EXIT_SPRITE: {
+      // fire gun if its been long enough
+      if (m_pTimer->elapsed(p->m_fGunTimer, 1.5f))
+        if (p->GetVelocity().x != 0.0f)
+          FireGun(p, BULLET2_SPRITE, target);
+    }
+    else {
+      // its not mad, just walk around
+      p->setState(PATROL);
+    }
+		
+
+		// check for patrol point collision
+		for (auto const& ep : m_vContacts[ENDPOINT_LAYER])
+			if (p->GetBoundingBox().Intersects(ep->GetBoundingBox()))
+				((EvilNPC*)p)->CollisionResponse(ep->GetBoundingBox());
 
-      bool allOnExit = true;
+		//doors collision
+		for (auto const& d : m_vContacts[DOOR_LAYER]) {
+			if (!((Door*)d)->getIsOpen() && p->GetBoundingBox().Intersects(d->GetBoundingBox()))
+				((EvilNPC*)p)->CollisionResponse(d->GetBoundingBox());
+		}
 
-      // check if all characters left in the vector are on the point
-      for (const auto &c : characters) {
-        allOnExit = allOnExit && p->GetBoundingBox().Intersects(c->GetBoundingBox());
+    // breakable walls
+    for (auto const& w : m_vContacts[BREAKABLE_LAYER]) {
+      if (((EvilNPC*)p)->GetBoundingBox().Intersects(w->GetBoundingBox()))
+      ((EvilNPC*)p)->CollisionResponse(w->GetBoundingBox());
+    }
+
+    // collide with player sheild
+    if (m_pShieldPointer) 
+      if(p->GetBoundingBox().Intersects(m_pShieldPointer->GetBoundingBox()))
+        ((EvilNPC*)p)->CollisionResponse(m_pShieldPointer->GetBoundingBox());
+
+	} break;
+  
+  case GUN_SPRITE: {
+    
+    // look around only when the scheduler says so
+    if (m_pAIScheduler->IsDue(p))
+      m_pAIScheduler->SetPerception(p, PerceiveGun(p));
+
+    // aggro if anyone was visible
+    if (m_pAIScheduler->GetPerception(p).m_bSeen)
+      if (m_pTimer->elapsed(p->m_fGunTimer, 1.5f))
+        FireGun(p, BULLET2_SPRITE);
+  } break;
+
+	case ELECTRIC_SPRITE: {
+    for (auto &c : characters) {
+      if (p->GetBoundingBox().Intersects(c->GetBoundingBox())) {
+        //m_pAudio->vary(OW_SOUND);
+        c->TrapReaction();//react to getting shocked
+        c->damage(1);//damage player for 1
       }
+    }
+	}break;
 
-      if (allOnExit)
-        state = WIN_STATE;
+	case SWITCH_SPRITE: {
+		if (p->GetBoundingBox().Intersects(m_pPlayer->GetBoundingBox()) && m_pPlayer->m_bInteract)
+		{
+			((Switch*)p)->flipTrapSwitch();
+		}
+	}break;
 
-    }break;
+	default: break;
+	}//switch
 
-		case TURRET_SPRITE: {
+	// objects that have come to rest go to sleep
+	if (CanSleep(p->m_nSpriteIndex) && p->m_vPos == oldpos)
+		sleep(p);
+} //MoveObject
 
+/// Move all of the objects and perform 
+/// broad phase collision detection and response.
+/// Only the active objects are moved. Sleeping objects
+/// wait to be touched and static objects are only queried.
+/// Once the game is under way this shouldn't allocate any memory,
+/// which can be checked by defining CHECK_STEP_ALLOCATIONS in HeapCheck.h,
+/// or by running the headless build with -checkalloc.
 
-      float range = 256.0f;
-      bool inRange = false;
-      float closest = range + 1; // closest character x distance
-      CObject* target = nullptr;
+void CObjectManager::move(const float & t) {
+	if (state == TITLE_STATE) // if we are in the title state we just want to bail
+		return;
 
-      // find closest player in range
-      for (auto &c : characters) {
-        Vector2 v = c->m_vPos - p->m_vPos;
+  PROFILE_SCOPE("CObjectManager::move");
+  CBenchmarkTimer timer(MOVE_TIMER);
 
-        // if in range and closest player, update closest player var
-        if (fabsf(v.x) <= range && fabsf(v.x) < closest) {
-          // if visible
-          if (m_pTileManager->Visible(p->m_vPos, c->m_vPos, c->m_Sphere.Radius)) {
-            if (fabsf(v.y) <= 20.0f) { // dont worry about people above
-              closest = v.x;
-              inRange = true;
-              target = c;
-            }
-          }
-        }
-      }
+#ifdef CHECK_STEP_ALLOCATIONS
+  const size_t allocations = GetAllocationCount();
+#endif //CHECK_STEP_ALLOCATIONS
 
-      if (inRange) {
-        // attack
-        p->setState(ATTACK);
+	bool ladderFlag = false;//say we arent on a ladder
 
-        // player to the right
-        if (closest > 0.0f) {
-          p->turn(RIGHT);
-        }
-        else if (closest < 0.0f) {
-          p->turn(LEFT);
-        }
+	// static objects never move, so rather than stepping them we ask
+	// them about the characters, who haven't moved yet this step
+	m_pStaticGrid->GetNeighbors(m_pPlayer, m_vNeighbors);
 
-        // fire gun if its been long enough
-        if (m_pTimer->elapsed(p->m_fGunTimer, 1.5f))
-          if (p->GetVelocity().x != 0.0f)
-            FireGun(p, BULLET2_SPRITE, target);
-      }
-      else {
-        // its not mad, just walk around
-        p->setState(PATROL);
-      }
-			
+	for (auto const& q : m_vNeighbors)
+		if (q->m_nSpriteIndex == LADDERL_SPRITE || q->m_nSpriteIndex == LADDERR_SPRITE)
+			if (q->GetBoundingBox().Intersects(m_pPlayer->GetBoundingBox()))
+				ladderFlag = true;//say we are on a ladder
 
-			// check for patrol point collision
-			for (auto const& ep : m_stdEndPointList)
-				if (p->GetBoundingBox().Intersects(ep->GetBoundingBox()))
-					((EvilNPC*)p)->CollisionResponse(ep->GetBoundingBox());
+	if (!characters.empty()) {
+		m_pStaticGrid->GetNeighbors(characters[0], m_vNeighbors);
 
-			//doors collision
-			for (auto const& d : m_stdDoorList) {
-				if (!((Door*)d)->getIsOpen() && p->GetBoundingBox().Intersects(d->GetBoundingBox()))
-					((EvilNPC*)p)->CollisionResponse(d->GetBoundingBox());
-			}
+		for (auto const& q : m_vNeighbors)
+			if (q->m_nSpriteIndex == EXIT_SPRITE) {
+				bool allOnExit = true;
 
-      // breakable walls
-      for (auto const& w : m_vBreakableWallList) {
-        if (((EvilNPC*)p)->GetBoundingBox().Intersects(w->GetBoundingBox()))
-        ((EvilNPC*)p)->CollisionResponse(w->GetBoundingBox());
-      }
+				// check if all characters left in the vector are on the point
+				for (const auto &c : characters) {
+					allOnExit = allOnExit && q->GetBoundingBox().Intersects(c->GetBoundingBox());
+				}
 
-      // collide with player sheild
-      if (m_pShieldPointer) 
-        if(p->GetBoundingBox().Intersects(m_pShieldPointer->GetBoundingBox()))
-          ((EvilNPC*)p)->CollisionResponse(m_pShieldPointer->GetBoundingBox());
+				if (allOnExit)
+					state = WIN_STATE;
+			} //if
+	} //if
 
-		} break;
-    
-    case GUN_SPRITE: {
-      
-      bool isAggro = false;
+	m_nStepCount++;
 
-      // aggro if any characters are in range
-      for (auto &c : characters) {
+	for (size_t i = 0; i < m_vActiveList.size(); i++) { //for each active object
+		CObject* const p = m_vActiveList[i];
+		if (p == nullptr) continue; //went to sleep
 
-        if (isAggro) {
-          break; // already mad
-        }
-        else { // try and get mad
-
-          GunTurret* gun = (GunTurret*)p;
-          const float r = c->m_Sphere.Radius;
-          bool bVisible = m_pTileManager->Visible(p->m_vPos, c->m_vPos, r);
-          // vector between player and enemy
-          Vector2 direction = c->GetPos() - gun->m_vPos;
-
-          if (bVisible) {
-            if (direction.x > 0.0f && direction.x < gun->getRange() || direction.x < 0.0f && direction.x > gun->getRange()) {
-              isAggro = true;
-
-              if (m_pTimer->elapsed(p->m_fGunTimer, 1.5f))
-                FireGun(p, BULLET2_SPRITE);
-            }
-          }
-        }
-      }
-    } break;
-
-		case ELECTRIC_SPRITE: {
-      for (auto &c : characters) {
-        if (p->GetBoundingBox().Intersects(c->GetBoundingBox())) {
-          //m_pAudio->vary(OW_SOUND);
-          c->TrapReaction();//react to getting shocked
-          c->damage(1);//damage player for 1
-        }
-      }
-		}break;
+		float dt = t; //time to move it by
 
-		case SWITCH_SPRITE: {
-			if (p->GetBoundingBox().Intersects(m_pPlayer->GetBoundingBox()) && m_pPlayer->m_bInteract)
-			{
-				((Switch*)p)->flipTrapSwitch();
-			}
-		}break;
+		// far from the characters, so only move it every few steps,
+		// staggered by a key that stays put while the active list is
+		// compacted so that they don't all move on the same step
+		if (!IsExempt(p) && !InActivityRegion(p)) {
+			p->m_fOwedTime += t;
 
-		default: break;
-		}//switch
+			if ((m_nStepCount + p->m_nStagger) % m_nCoarseSteps != 0)
+				continue; // not its turn
+
+			dt = p->m_fOwedTime;
+			p->m_fOwedTime = 0.0f;
+		}
+
+		// just came back, so catch up with everything else
+		else if (p->m_fOwedTime > 0.0f) {
+			dt = t + p->m_fOwedTime;
+			p->m_fOwedTime = 0.0f;
+		}
+
+		// pay the time back in equal moves of at most MAX_COARSE_STEPS
+		// steps, so that nothing goes far enough in one move to pass
+		// through a floor, stopping if it dies or goes to sleep
+		const unsigned n = max(1U, (unsigned)ceilf(dt/(MAX_COARSE_STEPS*t) - 0.001f));
+
+		for (unsigned j = 0; j < n && p->m_nActivity == ACTIVE_OBJECT && !p->m_bDead; j++)
+			MoveObject(p, dt/n);
 	} //for every object
 
 	m_pPlayer->m_bOnLadder = ladderFlag;
@@ -573,19 +1078,20 @@ void CObjectManager::move(const float & t) {
 
     // update position to match player
     m_pSwordPointer->move(t);
+    FindContacts(m_pSwordPointer);
 
     // collide with enemies/switches/walls
-    for (auto const& w : m_vBreakableWallList) {
+    for (auto const& w : m_vContacts[BREAKABLE_LAYER]) {
       if (m_pSwordPointer->GetBoundingBox().Intersects(w->GetBoundingBox())) {
         w->kill();
       }
     }
-    for (auto const & s : m_vSwitchList) {
+    for (auto const & s : m_vContacts[SWITCH_LAYER]) {
       if (m_pSwordPointer->GetBoundingBox().Intersects(s->GetBoundingBox())) {
         ((Switch*)s)->flipTrapSwitch();
       }
     }
-    for (auto const& w : m_vEnemies) {
+    for (auto const& w : m_vContacts[ENEMY_LAYER]) {
       if (m_pSwordPointer->GetBoundingBox().Intersects(w->GetBoundingBox())) {
         w->kill();
         m_pAudio->play(ENEMY_OW);
@@ -596,11 +1102,21 @@ void CObjectManager::move(const float & t) {
 
 	if (m_pShieldPointer)
 		m_pShieldPointer->move(t);
+
+  MoveProjectiles(t); //bullets, including any fired this frame
+
 	//now do object-object collision detection and response and
 	//remove any dead objects from the object list.
 
 	BroadPhase(); //broad phase collision detection and response
 	CullDeadObjects(); //remove dead objects from object list
+
+#ifdef CHECK_STEP_ALLOCATIONS
+  const size_t n = GetAllocationCount() - allocations;
+
+  if(n > 0 && m_nStepCount > STEP_ALLOCATION_WARMUP)
+    DEBUGPRINTF("Step %u made %u heap allocations\n", m_nStepCount, (unsigned)n);
+#endif //CHECK_STEP_ALLOCATIONS
 } //move
 
 CObject* CObjectManager::isTouchingElevator()
@@ -641,13 +1157,13 @@ void CObjectManager::FireGun(CObject* pObj, eSpriteType bullet){
 
     if (pObj->GetPos().x > m_pPlayer->GetPos().x) {
 
-      pBullet = m_pObjectManager->create(bullet, pObj->GetPos() + -0.5f*m_pRenderer->GetWidth(pObj->m_nSpriteIndex)*Vector2::UnitX); //create bullet
+      pBullet = CreateProjectile(bullet, pObj->GetPos() + -0.5f*m_pRenderer->GetWidth(pObj->m_nSpriteIndex)*Vector2::UnitX); //create bullet
       pBullet->SetVelocity(Vector2::UnitX * -400.0f);
       // face the player
       pObj->turn(LEFT);
     }
     else if (pObj->GetPos().x < m_pPlayer->GetPos().x) {
-      pBullet = m_pObjectManager->create(bullet, pObj->GetPos() + 0.5f*m_pRenderer->GetWidth(pObj->m_nSpriteIndex)*Vector2::UnitX); //create bullet
+      pBullet = CreateProjectile(bullet, pObj->GetPos() + 0.5f*m_pRenderer->GetWidth(pObj->m_nSpriteIndex)*Vector2::UnitX); //create bullet
 
       pBullet->SetVelocity(Vector2::UnitX * 400.0f);
       // face the player
@@ -676,13 +1192,13 @@ void CObjectManager::FireGun(CObject* pObj, eSpriteType bullet){
 
     if (pObj->GetPos().x > m_pPlayer->GetPos().x && pObj->m_nFacing == LEFT) {
 
-      pBullet = m_pObjectManager->create(bullet, pObj->GetPos() + -0.5f*m_pRenderer->GetWidth(pObj->m_nSpriteIndex)*Vector2::UnitX); //create bullet
+      pBullet = CreateProjectile(bullet, pObj->GetPos() + -0.5f*m_pRenderer->GetWidth(pObj->m_nSpriteIndex)*Vector2::UnitX); //create bullet
       pBullet->m_f4Tint = XMFLOAT4(Colors::Red); // gun turret has red lasers
       pBullet->SetVelocity(Vector2::UnitX * -500.0f);
 
     }
     else if (pObj->GetPos().x < m_pPlayer->GetPos().x  && pObj->m_nFacing == RIGHT) {
-      pBullet = m_pObjectManager->create(bullet, pObj->GetPos() + 0.5f*m_pRenderer->GetWidth(pObj->m_nSpriteIndex)*Vector2::UnitX); //create bullet
+      pBullet = CreateProjectile(bullet, pObj->GetPos() + 0.5f*m_pRenderer->GetWidth(pObj->m_nSpriteIndex)*Vector2::UnitX); //create bullet
       pBullet->m_f4Tint = XMFLOAT4(Colors::Red); // gun turret has red lasers
       pBullet->SetVelocity(Vector2::UnitX * 500.0f);
     }
@@ -705,7 +1221,7 @@ void CObjectManager::FireGun(CObject* pObj, eSpriteType bullet){
 
   }
 	else {
-    pBullet = m_pObjectManager->create(bullet, pos);
+    pBullet = CreateProjectile(bullet, pos);
     if (m_pPlayer->isFacing(RIGHT)) {//if we are facing to the right we ought to shoot the the right
       pBullet->SetVelocity(m_pPlayer->GetVelocity() + 500.0f*(norm + deflection));
       pBullet->m_nCurrentFrame = 1;
@@ -745,13 +1261,13 @@ void CObjectManager::FireGun(CObject* pObj, eSpriteType bullet, CObject* c) {
 
     if (pObj->GetPos().x > c->GetPos().x) {
 
-      pBullet = m_pObjectManager->create(bullet, pObj->GetPos() + -0.5f*m_pRenderer->GetWidth(pObj->m_nSpriteIndex)*Vector2::UnitX); //create bullet
+      pBullet = CreateProjectile(bullet, pObj->GetPos() + -0.5f*m_pRenderer->GetWidth(pObj->m_nSpriteIndex)*Vector2::UnitX); //create bullet
       pBullet->SetVelocity(Vector2::UnitX * -400.0f);
       // face the player
       pObj->turn(LEFT);
     }
     else if (pObj->GetPos().x < c->GetPos().x) {
-      pBullet = m_pObjectManager->create(bullet, pObj->GetPos() + 0.5f*m_pRenderer->GetWidth(pObj->m_nSpriteIndex)*Vector2::UnitX); //create bullet
+      pBullet = CreateProjectile(bullet, pObj->GetPos() + 0.5f*m_pRenderer->GetWidth(pObj->m_nSpriteIndex)*Vector2::UnitX); //create bullet
 
       pBullet->SetVelocity(Vector2::UnitX * 400.0f);
       // face the player
@@ -779,13 +1295,13 @@ void CObjectManager::FireGun(CObject* pObj, eSpriteType bullet, CObject* c) {
 
     if (pObj->GetPos().x > c->GetPos().x && pObj->m_nFacing == LEFT) {
 
-      pBullet = m_pObjectManager->create(bullet, pObj->GetPos() + -0.5f*m_pRenderer->GetWidth(pObj->m_nSpriteIndex)*Vector2::UnitX); //create bullet
+      pBullet = CreateProjectile(bullet, pObj->GetPos() + -0.5f*m_pRenderer->GetWidth(pObj->m_nSpriteIndex)*Vector2::UnitX); //create bullet
       pBullet->m_f4Tint = XMFLOAT4(Colors::Red); // gun turret has red lasers
       pBullet->SetVelocity(Vector2::UnitX * -500.0f);
 
     }
     else if (pObj->GetPos().x < c->GetPos().x  && pObj->m_nFacing == RIGHT) {
-      pBullet = m_pObjectManager->create(bullet, pObj->GetPos() + 0.5f*m_pRenderer->GetWidth(pObj->m_nSpriteIndex)*Vector2::UnitX); //create bullet
+      pBullet = CreateProjectile(bullet, pObj->GetPos() + 0.5f*m_pRenderer->GetWidth(pObj->m_nSpriteIndex)*Vector2::UnitX); //create bullet
       pBullet->m_f4Tint = XMFLOAT4(Colors::Red); // gun turret has red lasers
       pBullet->SetVelocity(Vector2::UnitX * 500.0f);
     }
@@ -817,8 +1333,9 @@ void CObjectManager::swingSword()
   //make a sword
   //store the pointer
   //put on list
-  if (!m_pSwordPointer) {
-    m_pSwordPointer = new CObject(SWORD_SPRITE, m_pPlayer->GetPos());
+  if (!m_pSwordPointer) { //reuse the sword object made by StartLevel(), so that swinging doesn't allocate
+    *m_pSwordObject = CObject(SWORD_SPRITE, m_pPlayer->GetPos());
+    m_pSwordPointer = m_pSwordObject;
   }
 }
 
@@ -837,187 +1354,632 @@ void CObjectManager::flipShield()
 	}
 }
 
-vector<CObject*> CObjectManager::getVecTraps()
+/// Act on the player's input for a frame, which is all that the player
+/// can do to the world. This is called once per frame before the timer
+/// is told that the frame has begun, so the time is still the start of
+/// the last frame. What each input does can depend on which character
+/// is the player and on whether it is touching an elevator.
+/// \param input Mask of eInput flags.
+
+void CObjectManager::ApplyInput(unsigned input){
+  CObject* elev = isTouchingElevator();
+
+  //side to side movement
+
+  if(input & INPUT_RIGHT){
+    m_pPlayer->StrafeRight();
+    m_pPlayer->turn(RIGHT);
+  } //if
+
+  if(input & INPUT_LEFT){
+    m_pPlayer->StrafeLeft();
+    m_pPlayer->turn(LEFT);
+  } //if
+
+  //reset back to stationary
+
+  if(input & INPUT_STOP_RIGHT)
+    m_pPlayer->m_nCurrentFrame = 0;
+
+  if(input & INPUT_STOP_LEFT)
+    m_pPlayer->m_nCurrentFrame = 4;
+
+  //jump, climb up and down
+
+  if(input & INPUT_JUMP){
+    if(m_pPlayer->m_nSpriteIndex == FAST_SPRITE && elev == nullptr)
+      m_pPlayer->Jump();
+    else if(elev != nullptr)
+      ((Elevator*)elev)->goUp();
+  } //if
+
+  if(input & INPUT_UP){
+    if(m_pPlayer->isOnLadder())
+      m_pPlayer->climbUp();
+    else if(elev != nullptr)
+      ((Elevator*)elev)->goUp();
+  } //if
+
+  if(input & INPUT_DOWN){
+    if(m_pPlayer->isOnLadder())
+      m_pPlayer->climbDown();
+    else if(elev != nullptr)
+      ((Elevator*)elev)->goDown();
+  } //if
+
+  //abilities
+
+  if(m_pPlayer->m_nSpriteIndex == FIGHTER_SPRITE){
+    if(input & INPUT_ATTACK)
+      swingSword();
+
+    if(input & INPUT_FIRE)
+      if(m_pTimer->elapsed(m_pPlayer->m_fGunTimer, 1.5f))
+        FireGun(m_pPlayer, BULLET_SPRITE);
+  } //if
+
+  if(m_pPlayer->m_nSpriteIndex == SHIELD_SPRITE && (input & INPUT_ATTACK))
+    flipShield();
+
+  //switch active player
+
+  if(input & INPUT_NEXT_PLAYER){
+    whichPlayer = (whichPlayer + 1) % characters.size();
+    m_pPlayer = characters.at(whichPlayer);
+  } //if
+
+  if(input & INPUT_PREV_PLAYER){
+    whichPlayer = (whichPlayer - 1) < 0? int(characters.size() - 1): whichPlayer - 1;
+    m_pPlayer = characters.at(whichPlayer);
+  } //if
+
+  m_pPlayer->m_bInteract = (input & INPUT_INTERACT) != 0;
+} //ApplyInput
+
+/// Get the traps without copying them.
+/// \return Reference to the trap list.
+
+const vector<CObject*>& CObjectManager::getVecTraps()
 {
 	return m_vTrapList;
 }
 
-vector<CObject*> CObjectManager::getVecSwitches()
+/// Get the switches without copying them.
+/// \return Reference to the switch list.
+
+const vector<CObject*>& CObjectManager::getVecSwitches()
 {
 	return m_vSwitchList;
 }
 
-/// This is a "bring out yer dead" Monty Python type of thing.
-/// Iterate through the objects and check whether their "is dead"
-/// flag has been set. If so, then delete its pointer from
-/// the object list and destruct the object.
+/// Hash the state of the world, that is, everything that a change to
+/// the code might change by mistake: the position, velocity, and hit
+/// points of every object and projectile, whether it is dead, the
+/// state of every door, trap, and switch, which character is the
+/// player, and the state of the PRNG. The objects are hashed in the
+/// order that they are in the object list, so a change in the order
+/// shows up too. Particles are left out, since they are just for show.
+/// \return The hash.
 
-void CObjectManager::CullDeadObjects(){
-  for(auto i=m_stdObjectList.begin(); i!=m_stdObjectList.end();){
-    if((*i)->IsDead())
-		{ //"He's dead, Dave." --- Holly, Red Dwarf
-			for (auto p = characters.begin(); p!=characters.end();) 
-			{
-				if (*p == *i)
-				{
-					//erase it
-					if ((*p)->m_nSpriteIndex == SHIELD_SPRITE) {//if it is the shield man we need to also kill his shield!
-						delete m_pShieldPointer;
-						m_pShieldPointer = nullptr;
-					}	
-					p = characters.erase(p);
-				}
-				else ++p;
-			}//for
-
-			for (auto p = m_vEnemies.begin(); p != m_vEnemies.end();)
-			{
-				if (*p == *i)
-				{
-					//erase it
-					p = m_vEnemies.erase(p);
-				}
-				else ++p;
-			}//for
-
-			for (auto w = m_vBreakableWallList.begin(); w != m_vBreakableWallList.end();)
-			{
-				if (*w == *i)
-				{
-					//delete it
-					w = m_vBreakableWallList.erase(w);
-				}
-				else ++w;
-			}
+unsigned CObjectManager::GetWorldHash(){
+  CWorldHash h;
 
-      delete *i; //delete object
-      i = m_stdObjectList.erase(i); //remove from object list and advance to next object
-    } //if
+  unsigned rng[4];
+  m_pRandom->GetState(rng);
+
+  for(int i=0; i<4; i++)
+    h.add(rng[i]);
 
-    else ++i; //advance to next object
+  h.add(whichPlayer);
+  h.add((unsigned)m_stdObjectList.size());
+
+  for(auto const& p: m_stdObjectList){ //for each object
+    h.add(p->m_nSpriteIndex);
+    h.add(p->m_vPos);
+    h.add(p->m_vVelocity);
+    h.add(p->m_hp);
+    h.add(p->m_bDead);
+
+    switch(p->m_nSpriteIndex){
+      case DOOR_SPRITE:
+        h.add(((Door*)p)->m_bIsOpen);
+        h.add(((Door*)p)->m_bIsLocked);
+      break;
+
+      case ELECTRIC_SPRITE: h.add(((Trap*)p)->state); break;
+      case SWITCH_SPRITE: h.add(((Switch*)p)->state); break;
+    } //switch
   } //for
 
-  if (m_pSwordPointer && m_pSwordPointer->tooOld()) {
-    delete m_pSwordPointer;
-    m_pSwordPointer = nullptr;
-  }
-} //CullDeadObjects
+  if(m_pSwordPointer)
+    h.add(m_pSwordPointer->m_vPos);
 
-/// Perform collision detection and response for all pairs
-/// of objects in the object list, making sure that each
-/// pair is processed only once.
+  h.add((unsigned)m_pProjectiles->size());
 
-void CObjectManager::BroadPhase(){
-  for(auto i=m_stdObjectList.begin(); i!=m_stdObjectList.end(); i++){
-    for(auto j=next(i); j!=m_stdObjectList.end(); j++)
-      NarrowPhase(*i, *j);
+  for(size_t i=0; i<m_pProjectiles->size(); i++){ //for each projectile
+    CObject* p = m_pProjectiles->GetProjectile(i);
+    h.add(p->m_nSpriteIndex);
+    h.add(p->m_vPos);
+    h.add(p->m_vVelocity);
   } //for
-} //BroadPhase
 
-/// Perform collision detection and response for a pair of objects.
-/// We are talking about bullets hitting the player and the
-/// turrets here. When a collision is detected the response
-/// is to delete the bullet (i.e. mark its "is dead" flag)
-/// play a particle effect at the point of contact, and play one 
-/// sound for the player and another for the turrets.
-/// \param p0 Pointer to the first object.
-/// \param p1 Pointer to the second object.
+  return h.digest();
+} //GetWorldHash
 
-void CObjectManager::NarrowPhase(CObject* p0, CObject* p1){
-  eSpriteType t0 = (eSpriteType)p0->m_nSpriteIndex;
-  eSpriteType t1 = (eSpriteType)p1->m_nSpriteIndex;
-
-	if (p0->m_Sphere.Intersects(p1->m_Sphere)) { //bounding spheres intersect
-		if (t0 == BULLET_SPRITE && t1 == TURRET_SPRITE) { //bullet hits turret
-			p0->kill();
-			m_pAudio->play(ENEMY_OW);
-      p1->kill();
-		} //if
-
-		else if (t1 == BULLET_SPRITE && t0 == TURRET_SPRITE) { //turret hit by bullet
-			p1->kill();
-			m_pAudio->play(ENEMY_OW);
-      p0->kill();
-		} //else if
-
-		else if (t1 == BULLET2_SPRITE && t0 == FAST_SPRITE) { //bullet hits player
-      if (!p1->IsDead()) {
-        p1->kill();
-        p0->damage(1);
-      }
-		} //else if
+/// Reader function for the number of bullets that have been removed
+/// to make room for new ones since the level began.
+/// \return Number of bullets removed from a full projectile pool.
 
-    else if (t0 == BULLET2_SPRITE && t1 == FAST_SPRITE) { //bullet hits player
-      if (!p0->IsDead()) {
-        p0->kill();
-        p1->damage(1);
-      }
-    } //else if
+unsigned CObjectManager::GetEvictionCount(){
+  return m_nEvictions;
+} //GetEvictionCount
 
-    else if (t1 == BULLET2_SPRITE && t0 == FIGHTER_SPRITE) { //bullet hits player
-      if (!p1->IsDead()) {
-        p1->kill();
-        p0->damage(1);
-      }
-    } //else if
+/// Reader function for the tile manager, for the headless checks.
+/// \return Pointer to the tile manager.
 
-    else if (t0 == BULLET2_SPRITE && t1 == FIGHTER_SPRITE) { //bullet hits player
-      if (!p0->IsDead()) {
-        p0->kill();
-        p1->damage(1);
-      }
-    } //else if
+CTileManager* CObjectManager::GetTileManager(){
+  return m_pTileManager;
+} //GetTileManager
 
-    else if (t1 == BULLET2_SPRITE && t0 == SHIELD_SPRITE) { //bullet hits player
-      if (!p1->IsDead()) {
-        p1->kill();
-        p0->damage(1);
-      }
-    } //else if
+/// Add a line of sight query from one object to another to the batch
+/// in m_vSightLines, and remember the target in m_vSightTargets.
+/// \param p Pointer to the object doing the looking.
+/// \param c Pointer to the object being looked at.
 
-    else if (t0 == BULLET2_SPRITE && t1 == SHIELD_SPRITE) { //bullet hits player
-      if (!p0->IsDead()) {
-        p0->kill();
-        p1->damage(1);
-      }
-    } //else if
+void CObjectManager::AddSightLine(CObject* p, CObject* c){
+  SightLine l;
+  l.m_vEye = p->m_vPos;
+  l.m_vTarget = c->m_vPos;
+  l.m_fRadius = c->m_Sphere.Radius;
 
+  m_vSightLines.push_back(l);
+  m_vSightTargets.push_back(c);
+} //AddSightLine
 
-    else if (t1 == TURRET_SPRITE && t0 == FAST_SPRITE) { //bullet hits player
-      if (!p1->IsDead()) {
-        p0->damage(1);
-      }
-    }
+/// Pick the turrets and guns that get to look around in this frame.
+/// This is called once per frame rather than once per physics step,
+/// so that catching up after a slow frame doesn't mean more sight lines.
 
-    else if (t0 == TURRET_SPRITE && t1 == FAST_SPRITE) { //bullet hits player
-      if (!p0->IsDead()) {
-        p1->damage(1);
-      }
-    }
+void CObjectManager::ScheduleAI(){
+  m_pAIScheduler->schedule(m_pTimer->time(), characters);
+} //ScheduleAI
 
-    else if (t1 == TURRET_SPRITE && t0 == FIGHTER_SPRITE) { //bullet hits player
-      if (!p1->IsDead()) {
-        p0->damage(1);
-      }
-    }
+/// Find the closest visible character that is roughly level with a
+/// turret and within range.
+/// \param p Pointer to a turret.
+/// \return What the turret perceived.
 
-    else if (t0 == TURRET_SPRITE && t1 == FIGHTER_SPRITE) { //bullet hits player
-      if (!p0->IsDead()) {
-        p1->damage(1);
-      }
+AIPerception CObjectManager::PerceiveTurret(CObject* p){
+  AIPerception r;
+  r.m_fTime = m_pTimer->time();
+
+  const float range = 256.0f;
+  float closest = range + 1; // closest character x distance
+
+  // cast sight lines to the players in range in one batch
+  m_vSightLines.clear();
+  m_vSightTargets.clear();
+
+  for (auto &c : characters) {
+    Vector2 v = c->m_vPos - p->m_vPos;
+
+    if (fabsf(v.x) <= range && fabsf(v.y) <= 20.0f) // dont worry about people above
+      AddSightLine(p, c);
+  }
+
+  m_pTileManager->Visible(m_vSightLines);
+
+  // find closest visible player
+  for (size_t i = 0; i < m_vSightLines.size(); i++) {
+    CObject* c = m_vSightTargets[i];
+    Vector2 v = c->m_vPos - p->m_vPos;
+
+    // if closest player and visible, update closest player var
+    if (fabsf(v.x) < closest && m_vSightLines[i].m_bVisible) {
+      closest = v.x;
+      r.m_bSeen = true;
+      r.m_pTarget = c;
     }
+  }
 
-    else if (t1 == TURRET_SPRITE && t0 == SHIELD_SPRITE) { //bullet hits player
-      if (!p1->IsDead()) {
-        p0->damage(1);
-      }
+  return r;
+} //PerceiveTurret
+
+/// Find out whether any character in front of a gun and within
+/// range is visible.
+/// \param p Pointer to a gun.
+/// \return What the gun perceived.
+
+AIPerception CObjectManager::PerceiveGun(CObject* p){
+  AIPerception r;
+  r.m_fTime = m_pTimer->time();
+
+  GunTurret* gun = (GunTurret*)p;
+
+  // cast sight lines to the characters in range in one batch
+  m_vSightLines.clear();
+  m_vSightTargets.clear();
+
+  for (auto &c : characters) {
+    // vector between player and enemy
+    Vector2 direction = c->GetPos() - gun->m_vPos;
+
+    if (direction.x > 0.0f && direction.x < gun->getRange() || direction.x < 0.0f && direction.x > gun->getRange())
+      AddSightLine(p, c);
+  }
+
+  m_pTileManager->Visible(m_vSightLines);
+
+  // aggro if any of them are visible
+  for (size_t i = 0; i < m_vSightLines.size(); i++)
+    if (m_vSightLines[i].m_bVisible) {
+      r.m_bSeen = true;
+      r.m_pTarget = m_vSightTargets[i];
+      break; // already mad
     }
 
-    else if (t0 == TURRET_SPRITE && t1 == SHIELD_SPRITE) { //bullet hits player
-      if (!p0->IsDead()) {
-        p1->damage(1);
+  return r;
+} //PerceiveGun
+
+/// Create a bullet in the projectile pool. If the pool is full then
+/// the oldest bullet is sacrificed to make room, so this never fails.
+/// It has been flying longest, so it is the one least likely to still
+/// be going to hit anything, but every sacrifice is counted all the same.
+/// \param t Sprite type of bullet.
+/// \param v Initial position.
+/// \return Pointer to the bullet.
+
+CObject* CObjectManager::CreateProjectile(eSpriteType t, const Vector2& v){
+  ProjectileHandle h = m_pProjectiles->create(t, v);
+
+  if(!m_pProjectiles->IsValid(h)){ //full up
+    m_pProjectiles->remove(m_pProjectiles->GetOldest());
+    m_nEvictions++;
+    h = m_pProjectiles->create(t, v);
+  } //if
+
+  return m_pProjectiles->get(h);
+} //CreateProjectile
+
+/// Move the bullets and do their collision detection and response.
+/// Bullets live in the projectile pool rather than on the object list,
+/// so this is a straight pass over a dense array. Player bullets break
+/// walls, flip switches, and kill turrets. Enemy bullets are stopped
+/// by the shield and hurt the characters. Either kind dies when it hits
+/// a wall, a closed door, or a breakable wall. Dead bullets are then
+/// swap-removed from the pool.
+/// \param t Frame time.
+
+void CObjectManager::MoveProjectiles(const float& t){
+  for(size_t i=0; i<m_pProjectiles->size(); i++){ //for each bullet
+    CObject* const p = m_pProjectiles->GetProjectile(i);
+    p->move(t); //every step, wherever it is, so that it can't tunnel through walls
+
+    if(m_pTileManager->CollideWithWall(p->GetBoundingBox(), m_vWalls)){
+      p->kill();
+      m_pAudio->play(RICOCHET_SOUND);
+    } //if
+
+    FindContacts(p); //what it might be hitting, by layer
+
+    switch (p->m_nSpriteIndex) {
+    case BULLET_SPRITE: // player projecties
+      // collide with regular doors
+      for (auto const& d : m_vContacts[DOOR_LAYER]) {
+        if (!((Door*)d)->getIsOpen() && p->GetBoundingBox().Intersects(d->GetBoundingBox())) {
+          p->kill();
+          m_pAudio->play(RICOCHET_SOUND);
+        }
       }
-    }
+      // breakable walls
+      for (auto const& w : m_vContacts[BREAKABLE_LAYER]) {
+        if (p->GetBoundingBox().Intersects(w->GetBoundingBox())) {
+          p->kill();
+          m_pAudio->play(RICOCHET_SOUND);
+          w->kill();
+        }
+      }
+      // switches
+      for (auto const & s : m_vContacts[SWITCH_LAYER]) {
+        if (p->GetBoundingBox().Intersects(s->GetBoundingBox())) {
+          ((Switch*)s)->flipTrapSwitch();
+          p->kill();
+        }
+      }
+      // turrets
+      for (auto const& e : m_vContacts[ENEMY_LAYER]) {
+        if (p->m_Sphere.Intersects(e->m_Sphere)) {
+          p->kill();
+          m_pAudio->play(ENEMY_OW);
+          e->kill();
+        }
+      }
+      break;
+    case BULLET2_SPRITE: // enemy projectiles
+      // doors
+      for (auto const& d : m_vContacts[DOOR_LAYER]) {
+        if (!((Door*)d)->getIsOpen() && p->GetBoundingBox().Intersects(d->GetBoundingBox())) {
+          p->kill();
+          m_pAudio->vary(RICOCHET_SOUND,0.2f);
+        }
+      }
+      // shields
+      if (m_pShieldPointer && p->GetBoundingBox().Intersects(m_pShieldPointer->GetBoundingBox())) {
+        p->kill();
+        m_pAudio->vary(RICOCHET_SOUND, 0.1f);
+      }
+      for (auto const& w : m_vContacts[BREAKABLE_LAYER]) {
+        if (p->GetBoundingBox().Intersects(w->GetBoundingBox())) {
+          p->kill();
+          m_pAudio->play(RICOCHET_SOUND);
+        }
+          
+      }
+      // characters
+      for (auto const& c : characters) {
+        if (!p->IsDead() && p->m_Sphere.Intersects(c->m_Sphere)) {
+          p->kill();
+          c->damage(1);
+        }
+      }
+      break;
+    default: break;
+    } //switch
+  } //for
+
+  for(size_t i=0; i<m_pProjectiles->size();) //cull dead bullets
+    if(m_pProjectiles->GetProjectile(i)->IsDead())
+      m_pProjectiles->remove(i); //last one is now at i
+    else ++i;
+} //MoveProjectiles
+
+/// This is a "bring out yer dead" Monty Python type of thing.
+/// Objects that died this step are already on the death queue,
+/// and each one knows where it is on the lists, so it can be taken
+/// off its typed list by moving the last object into its place.
+/// The characters are kept in order and there are at most three
+/// of them. The object list is kept in order too since it is the
+/// drawing order, so holes are left in it and closed up in a single
+/// pass at the end. Dead objects are destructed unless they are
+/// level objects, which are kept so that the level can be restarted.
+
+void CObjectManager::CullDeadObjects(){
+  CBenchmarkTimer timer(CULL_TIMER);
+
+  if(!m_vDeathQueue.empty()){
+    for(auto const& p: m_vDeathQueue){ //"He's dead, Dave." --- Holly, Red Dwarf
+      vector<CObject*>* pList = GetTypedList(p->m_nSpriteIndex);
+
+      if(pList){ //swap with last and pop
+        CObject* pLast = pList->back();
+        (*pList)[p->m_nTypedSlot] = pLast;
+        pLast->m_nTypedSlot = p->m_nTypedSlot;
+        pList->pop_back();
+      } //if
+
+      for(size_t i=0; i<characters.size(); i++)
+        if(characters[i] == p){
+          if(p->m_nSpriteIndex == SHIELD_SPRITE) //if it is the shield man we need to also kill his shield!
+            m_pShieldPointer = nullptr; //the shield object itself is kept for restarts
+
+          characters.erase(characters.begin() + i);
+          break;
+        } //if
+
+      if(p->m_nActivity == ACTIVE_OBJECT)
+        m_vActiveList[p->m_nActiveSlot] = nullptr; //leave a hole
+
+      if(p->m_nActivity == STATIC_OBJECT)
+        m_pStaticGrid->remove(p);
+
+      else{
+        WakeNeighbors(p); //anything resting on it can fall now
+        m_pSpatialGrid->remove(p); //take it out of the broad phase
+      } //else
+
+      m_pAIScheduler->remove(p); //stop it looking around
+      m_stdObjectList[p->m_nListSlot] = nullptr; //leave a hole
+      p->m_bListed = p->m_bDeathQueued = false;
+
+      if(!p->m_bLevelObject) //level objects are kept for restarts
+        delete p; //delete object
+    } //for
+
+    m_vDeathQueue.clear();
+
+    size_t j = 0; //close up the holes
 
-	}//if
+    for(size_t i=0; i<m_stdObjectList.size(); i++)
+      if(m_stdObjectList[i]){
+        m_stdObjectList[j] = m_stdObjectList[i];
+        m_stdObjectList[j]->m_nListSlot = j;
+        j++;
+      } //if
+
+    m_stdObjectList.resize(j);
+  } //if
+
+  CompactActiveList(); //holes from deaths and from objects falling asleep
+
+  if (m_pSwordPointer && m_pSwordPointer->tooOld())
+    m_pSwordPointer = nullptr; //the sword object itself is kept for the next swing
+} //CullDeadObjects
+
+#ifdef HEADLESS //only the headless harness checks culling
+
+/// Kill many objects in a single step and check that culling them
+/// leaves the lists the way they should be. Objects of every sprite type
+/// that has a typed list and can die, and of one that doesn't, are
+/// created at random across the level, alternately to be killed and to
+/// survive, so that survivors get moved into dead objects' slots. Then
+/// those to be killed are killed in random order and culled at once.
+/// After that, no list should hold a killed or dead object, every object
+/// should be on the object list, and every recorded index should be right.
+/// This leaves the level with the survivors in it, so begin it again to play.
+/// \param n Number of objects to kill, and to leave alive.
+/// \param seed Seed for the positions and the killing order, which doesn't disturb the game's.
+/// \param check [OUT] The number of objects killed and what was wrong with the lists.
+
+void CObjectManager::CheckCulling(unsigned n, int seed, CullCheck& check){
+  check = CullCheck();
+
+  const eSpriteType types[] = { //killable sprite types, all but the last with typed lists
+    TURRET_SPRITE, GUN_SPRITE, BREAKABLE_SPRITE, KEY_SPRITE, FIGHTER_SPRITE
+  }; //types
+
+  CRandom random;
+  random.srand(seed);
+
+  vector<CObject*> doomed; //objects to be killed
+
+  for(unsigned i=0; i<2*n; i++){
+    const eSpriteType t = types[(i/2)%(sizeof(types)/sizeof(types[0]))];
+    const Vector2 v(m_vWorldSize.x*random.randf(), m_vWorldSize.y*random.randf());
+    CObject* p = t == KEY_SPRITE? create(t, v, 0): create(t, v);
+
+    if(i%2 == 0)
+      doomed.push_back(p);
+  } //for
+
+  for(size_t i=doomed.size() - 1; i>0; i--) //shuffle
+    swap(doomed[i], doomed[random.randn(0, (unsigned)i)]);
+
+  for(auto const& p: doomed)
+    p->kill();
+
+  check.m_nKilled = (unsigned)doomed.size();
+  sort(doomed.begin(), doomed.end()); //for looking up, they are only pointers now
+
+  CullDeadObjects();
+
+  auto dead = [&](CObject* p){ //whether an object should have been culled
+    return binary_search(doomed.begin(), doomed.end(), p) || p->m_bDead;
+  }; //dead
+
+  auto listed = [&](CObject* p){ //whether an object is where it should be on the object list
+    return p->m_nListSlot < m_stdObjectList.size() && m_stdObjectList[p->m_nListSlot] == p;
+  }; //listed
+
+  for(size_t i=0; i<m_stdObjectList.size(); i++){
+    CObject* const p = m_stdObjectList[i];
+
+    if(p == nullptr || dead(p))check.m_nLeftBehind++;
+    else if(p->m_nListSlot != i || !p->m_bListed)check.m_nBadSlots++;
+  } //for
+
+  for(unsigned t=0; t<NUM_SPRITES; t++){ //for each sprite type
+    vector<CObject*>* pList = GetTypedList(t);
+    if(pList == nullptr)continue; //no typed list
+
+    for(size_t i=0; i<pList->size(); i++){
+      CObject* const p = (*pList)[i];
+
+      if(dead(p))check.m_nLeftBehind++;
+      else if(p->m_nTypedSlot != i)check.m_nBadSlots++;
+      else if(p->m_nSpriteIndex != t || !listed(p))check.m_nMissing++;
+    } //for
+  } //for
+
+  for(size_t i=0; i<m_vActiveList.size(); i++){
+    CObject* const p = m_vActiveList[i];
+
+    if(p == nullptr || dead(p))check.m_nLeftBehind++;
+    else if(p->m_nActiveSlot != i)check.m_nBadSlots++;
+    else if(p->m_nActivity != ACTIVE_OBJECT || !listed(p))check.m_nMissing++;
+  } //for
+
+  check.m_nSurvivors = (unsigned)m_stdObjectList.size();
+} //CheckCulling
+
+#endif //HEADLESS
+
+/// Find the objects that an object might be touching, on the layers
+/// that its sprite type looks for contacts in, and put them in
+/// m_vContacts by layer. Objects are refiled in the spatial grids as
+/// soon as they move, and an object's AABB and bounding sphere both
+/// fit inside the cells it is filed in, so every object whose AABB or
+/// bounding sphere meets this object's is found. Each layer is sorted
+/// into the order of the list for its sprite type, so contacts are
+/// handled in the same order as they would be by going down that list.
+/// \param p Pointer to an object, which need not be in a grid.
+
+void CObjectManager::FindContacts(CObject* p){
+  for(auto& v: m_vContacts)
+    v.clear();
+
+  const unsigned mask = m_nSpriteMask[p->m_nSpriteIndex];
+  if(mask == 0)return; //not interested
+
+  auto sift = [&](){ //put the neighbors on the layers we want
+    for(auto const& q: m_vNeighbors){
+      const int layer = m_nSpriteLayer[q->m_nSpriteIndex];
+
+      if(layer >= 0 && (mask & LAYER(layer)))
+        m_vContacts[layer].push_back(q);
+    } //for
+  }; //sift
+
+  m_pSpatialGrid->GetNeighbors(p, m_vNeighbors);
+  sift();
+
+  if(mask & STATIC_LAYERS){
+    m_pStaticGrid->GetNeighbors(p, m_vNeighbors);
+    sift();
+  } //if
+
+  for(auto& v: m_vContacts)
+    if(v.size() > 1)
+      sort(v.begin(), v.end(), [](CObject* a, CObject* b){
+        return a->m_nTypedSlot < b->m_nTypedSlot;
+      });
+} //FindContacts
+
+/// Perform collision detection and response for all pairs
+/// of active objects that share a cell in the spatial grid,
+/// making sure that each pair is processed only once, and wake
+/// any sleeping objects that an active object is touching.
+/// Objects are refiled in the grid as they move, so the grid
+/// is already up to date.
+
+void CObjectManager::BroadPhase(){
+  PROFILE_SCOPE("CObjectManager::BroadPhase");
+  CBenchmarkTimer timer(BROADPHASE_TIMER);
+
+  const size_t n = m_vActiveList.size(); //anything woken here waits for the next step
+
+  for(size_t i=0; i<n; i++){ //for each active object
+    CObject* const p = m_vActiveList[i];
+    if(p == nullptr)continue; //went to sleep
+
+    m_pSpatialGrid->GetNeighbors(p, m_vNeighbors); //objects nearby
+    const bool bPairs = PAIR_TABLE.m_bAny[p->m_nSpriteIndex]; //whether it can run into anything
+
+    for(auto const& q: m_vNeighbors)
+      if(q->m_nActivity == SLEEPING_OBJECT){ //bumped into something at rest
+        if(p->m_Aabb.Intersects(q->m_Aabb))
+          wake(q);
+      } //if
+
+      else if(bPairs && q->m_nGridID > p->m_nGridID) //so that each pair is done once
+        NarrowPhase(p, q);
+  } //for
+} //BroadPhase
+
+/// Perform collision detection and response for a pair of objects.
+/// The handler for the pair of sprite types is looked up in PAIR_TABLE
+/// first, and pairs that have no handler are rejected before the
+/// bounding spheres are tested. Bullets are not on the object list, so
+/// they are handled separately in MoveProjectiles().
+/// \param p0 Pointer to the first object.
+/// \param p1 Pointer to the second object.
+
+void CObjectManager::NarrowPhase(CObject* p0, CObject* p1){
+  const PairEntry& e = PAIR_TABLE.m_Entry[p0->m_nSpriteIndex][p1->m_nSpriteIndex];
+  if(e.m_pHandler == nullptr)return; //nothing ever happens between these
+
+  if(p0->m_Sphere.Intersects(p1->m_Sphere)){ //bounding spheres intersect
+    if(e.m_bSwap)
+      e.m_pHandler(p1, p0);
+    else e.m_pHandler(p0, p1);
+  } //if
 } //NarrowPhase
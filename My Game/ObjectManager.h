@@ -3,7 +3,8 @@
 
 #pragma once
 
-#include <list>
+#include <vector>
+#include <string>
 
 #include "Object.h"
 
@@ -16,9 +17,46 @@
 #include "Elevator.h"
 #include "Traps.h"
 #include "GunTurret.h"
+#include "SpatialGrid.h"
+#include "ProjectilePool.h"
+#include "AIScheduler.h"
 
 using namespace std;
 
+/// \brief Collision layers.
+///
+/// Each sprite type that other objects look for contacts with is on one
+/// of these layers. They are listed in the order that the move code
+/// deals with them, which is the order that contacts are handed out in.
+
+enum eCollisionLayer{
+  ENDPOINT_LAYER, STOP_LAYER, PLATFORM_LAYER, DOOR_LAYER, BREAKABLE_LAYER,
+  TELEPORTER_LAYER, KEY_LAYER, SWITCH_LAYER, ENEMY_LAYER,
+  NUM_LAYERS //MUST BE LAST
+}; //eCollisionLayer
+
+const int DEFAULT_ACTIVITY_RADIUS = 24; ///< Default reach of the activity region in tiles.
+const unsigned DEFAULT_COARSE_STEPS = 4; ///< Default steps per move outside the activity region.
+const unsigned MAX_COARSE_STEPS = 4; ///< Most steps that an object is moved by in one go.
+const size_t DEFAULT_SCRATCH_SIZE = 1024; ///< Objects reserved for in each scratch list.
+
+#ifdef HEADLESS //only the headless harness checks culling
+
+/// \brief Results of CObjectManager::CheckCulling.
+///
+/// The number of objects killed and left alive, and counts of the ways
+/// in which the lists were wrong after the dead ones were culled.
+
+struct CullCheck{
+  unsigned m_nKilled = 0; ///< Objects created and killed in a single step.
+  unsigned m_nSurvivors = 0; ///< Objects on the object list after culling.
+  unsigned m_nLeftBehind = 0; ///< Killed objects still on a list, or dead objects on one.
+  unsigned m_nBadSlots = 0; ///< Objects whose recorded index on a list is wrong.
+  unsigned m_nMissing = 0; ///< Objects on a typed or active list but not on the object list, or the wrong list.
+}; //CullCheck
+
+#endif //HEADLESS
+
 /// \brief The object manager.
 ///
 /// A collection of all of the game objects.
@@ -30,13 +68,14 @@ class CObjectManager:
 	friend class Key;
 
   private:
-    list<CObject*> m_stdObjectList; ///< Object list.
-		list<CObject*> m_stdDoorList; ///< list of all the doors
+    vector<CObject*> m_stdObjectList; ///< Object list.
+    vector<CObject*> m_vActiveList; ///< Objects that are moved every step, with holes for ones that stopped.
+		vector<CObject*> m_stdDoorList; ///< list of all the doors
 		vector<CObject*> m_vTrapList; ///< vector l the traps
 		vector<CObject*> m_vSwitchList; ///< list of all the switches
 		vector<CObject*> m_stdPlatformList; ///< vector of all the platforms 
-		list<CObject*> m_stdEndPointList; ///< list of all the endpoints
-    list<CObject*> m_stdStopPointList; ///< list of all the endpoints
+		vector<CObject*> m_stdEndPointList; ///< list of all the endpoints
+    vector<CObject*> m_stdStopPointList; ///< list of all the endpoints
 		vector<CObject*> m_vTeleporterList; ///< vector of all the teleporters 
 		vector<CObject*> m_vBreakableWallList; ///< vector of all the destructable walls
 		vector<CObject*> m_vTeleportSpawns; ///< vector of all the spawns for teleporters
@@ -44,13 +83,61 @@ class CObjectManager:
 		vector<CObject*> m_vEnemies; ///< a vector of all the enemies
     vector<CObject*> m_vGuns; ///< a vector of all the enemies
     CTileManager* m_pTileManager = nullptr; ///< Pointer to tile manager.
+    CSpatialGrid* m_pSpatialGrid = nullptr; ///< Pointer to broad phase grid.
+    CSpatialGrid* m_pStaticGrid = nullptr; ///< Pointer to grid of static objects.
+    CProjectilePool* m_pProjectiles = nullptr; ///< Pointer to the bullets.
+    unsigned m_nEvictions = 0; ///< Bullets removed to make room for new ones since the level began.
+    CAIScheduler* m_pAIScheduler = nullptr; ///< Pointer to the AI scheduler.
+    vector<CObject*> m_vNeighbors; ///< Broad phase scratch space.
+    vector<BoundingBox> m_vWalls; ///< Wall collision scratch space.
+    vector<CObject*> m_vDeathQueue; ///< Objects that died this step.
+    vector<SightLine> m_vSightLines; ///< Line of sight scratch space.
+    int m_nSpriteLayer[NUM_SPRITES]; ///< Collision layer of each sprite type, -1 for none.
+    unsigned m_nSpriteMask[NUM_SPRITES]; ///< Collision layers that each sprite type looks for contacts in.
+    vector<CObject*> m_vContacts[NUM_LAYERS]; ///< Contacts found by FindContacts(), by layer.
+    vector<CObject*> m_vSightTargets; ///< Objects being looked at by m_vSightLines.
+    int m_nActivityRadius = DEFAULT_ACTIVITY_RADIUS; ///< Reach of the activity region in tiles, 0 for everywhere.
+    unsigned m_nCoarseSteps = DEFAULT_COARSE_STEPS; ///< Steps per move outside the activity region.
+    unsigned m_nStepCount = 0; ///< Number of steps taken, for spreading out coarse moves.
     CObject* m_pSwordPointer = nullptr; ///< a pointer to the sword that our attack character holds
+    CObject* m_pSwordObject = nullptr; ///< The sword, made once and kept between swings so that swinging doesn't allocate.
 		CObject* m_pShieldPointer = nullptr; ///< a pointer to the shield that our defense character holds
+    CObject* m_pShieldObject = nullptr; ///< The shield, which outlives shield man so that it can be restored.
+
+    int m_nSnapshotLevel = -1; ///< Level that the snapshot was taken of, -1 if none.
+    string m_strSnapshotFile; ///< Level image file that the snapshot was taken of.
+    vector<CObject*> m_vLevelObjects; ///< Objects created by LoadMap, alive or dead.
+    vector<CObject*> m_vPristine; ///< Copies of the level objects taken just after loading.
+    vector<CObject*> m_vLevelCharacters; ///< The characters just after loading.
+    CObject* m_pPristineShield = nullptr; ///< Copy of the shield taken just after loading.
 
     void BroadPhase(); ///< Broad phase collision detection and response.
     void NarrowPhase(CObject* p0, CObject* p1); ///< Narrow phase collision detection and response.
 
+    void MoveObject(CObject* p, float dt); ///< Move an active object and do its collisions.
     void CullDeadObjects(); ///< Cull dead objects.
+    void FindContacts(CObject* p); ///< Find the objects an object might be touching.
+
+    void AddSightLine(CObject* p, CObject* c); ///< Queue a line of sight query.
+    AIPerception PerceiveTurret(CObject* p); ///< Look for a target for a turret.
+    AIPerception PerceiveGun(CObject* p); ///< Look for a target for a gun.
+    CObject* CreateProjectile(eSpriteType t, const Vector2& v); ///< Create a bullet.
+    void MoveProjectiles(const float& t); ///< Move bullets and do their collisions.
+
+    vector<CObject*>* GetTypedList(unsigned t); ///< Get the list for a sprite type.
+    eActivity GetActivity(unsigned t); ///< Get the activity a sprite type starts with.
+    bool CanSleep(unsigned t); ///< Whether a sprite type can go to sleep.
+    void wake(CObject* p); ///< Wake a sleeping object.
+    void sleep(CObject* p); ///< Put an active object to sleep.
+    void WakeNeighbors(CObject* p); ///< Wake sleeping objects touching an object.
+    void CompactActiveList(); ///< Close up the holes in the active list.
+    bool InActivityRegion(CObject* p); ///< Whether an object is near a character.
+    bool IsExempt(CObject* p); ///< Whether an object is always moved every step.
+    void insert(CObject* p); ///< Put an object on the lists.
+    CObject* clone(CObject* p); ///< Make a copy of an object.
+    void copy(CObject* dest, CObject* src); ///< Copy one object's state into another.
+    void TakeSnapshot(int level, const char* filename); ///< Remember the freshly loaded level.
+    void DeleteSnapshot(); ///< Delete the level objects and their copies.
 
   public:
     CObjectManager(); ///< Constructor.
@@ -62,6 +149,9 @@ class CObjectManager:
 		CObject* isTouchingElevator(); ///< check if our player is currently colliding with an elevator
 
     void clear(); ///< Reset to initial conditions.
+    void QueueDeath(CObject* p); ///< Queue a dead object for removal.
+    void ScheduleAI(); ///< Pick the enemies that look around this frame.
+    void SetActivityRegion(int radius, unsigned steps); ///< Set the activity region.
     void move(const float &); ///< Move all objects.
     void draw(); ///< Draw all objects.
 
@@ -69,9 +159,21 @@ class CObjectManager:
     void FireGun(CObject* p, eSpriteType bullet, CObject* c); ///< Fire object's gun.
     void swingSword(); ///< have the attack player swing his sword
 		void flipShield(); ///< toggle between shield man having the shield up or in front
+    void ApplyInput(unsigned input); ///< Act on the player's input.
+
+    void LoadMap(int level, const char* filename=nullptr); ///< Load a level.
+    static const char* GetMapFileName(int level); ///< Get a level's image file name.
+    bool RestoreLevel(int level, const char* filename=nullptr); ///< Put a level back the way it was loaded.
+    void StartLevel(int level, const char* filename=nullptr); ///< Restore a level, or load it if it isn't loaded.
+
+		const vector<CObject*>& getVecTraps(); ///< Get the traps.
+		const vector<CObject*>& getVecSwitches(); ///< Get the switches.
 
-    void LoadMap(int level); ///< Load a level.
+    unsigned GetWorldHash(); ///< Hash the state of the world.
+    unsigned GetEvictionCount(); ///< Get the number of bullets removed from a full pool.
+    CTileManager* GetTileManager(); ///< Get the tile manager.
 
-		vector<CObject*> getVecTraps();
-		vector<CObject*> getVecSwitches();
+  #ifdef HEADLESS
+    void CheckCulling(unsigned n, int seed, CullCheck& check); ///< Kill many objects at once and check the lists.
+  #endif //HEADLESS
 }; //CObjectManager
\ No newline at end of file
@@ -0,0 +1,138 @@
+/// \file ProjectilePool.cpp
+/// \brief Code for the projectile pool CProjectilePool.
+
+#include "ProjectilePool.h"
+
+/// Allocate all of the memory that the pool will ever need.
+/// \param capacity Maximum number of projectiles.
+
+CProjectilePool::CProjectilePool(size_t capacity):
+  m_nCapacity(capacity)
+{
+  m_vDense.reserve(capacity);
+  m_vDenseToSlot.reserve(capacity);
+  m_vSlotToDense.resize(capacity);
+  m_vGeneration.resize(capacity);
+  m_vFreeSlots.reserve(capacity);
+
+  clear();
+} //constructor
+
+/// Return a slot to the free list and bump its generation so that
+/// any handles to it go stale.
+/// \param slot Slot index.
+
+void CProjectilePool::free(unsigned slot){
+  m_vGeneration[slot]++;
+  m_vFreeSlots.push_back(slot);
+} //free
+
+/// Create a projectile at the end of the dense array. If the pool is
+/// full then nothing is created and the handle returned is invalid.
+/// \param t Sprite type.
+/// \param v Initial position.
+/// \return Handle to the projectile.
+
+ProjectileHandle CProjectilePool::create(eSpriteType t, const Vector2& v){
+  ProjectileHandle h;
+  if(m_vFreeSlots.empty())return h; //full up
+
+  h.m_nSlot = m_vFreeSlots.back();
+  h.m_nGeneration = m_vGeneration[h.m_nSlot];
+  m_vFreeSlots.pop_back();
+
+  m_vSlotToDense[h.m_nSlot] = (unsigned)m_vDense.size();
+  m_vDenseToSlot.push_back(h.m_nSlot);
+  m_vDense.emplace_back(t, v);
+
+  return h;
+} //create
+
+/// Remove a projectile by moving the last one into its place.
+/// The projectile that was last is now at index i, so a loop
+/// that removes as it goes should not advance after removing.
+/// \param i Index into the dense array.
+
+void CProjectilePool::remove(size_t i){
+  free(m_vDenseToSlot[i]);
+
+  const size_t last = m_vDense.size() - 1;
+
+  if(i != last){
+    m_vDense[i] = m_vDense[last];
+    m_vDenseToSlot[i] = m_vDenseToSlot[last];
+    m_vSlotToDense[m_vDenseToSlot[i]] = (unsigned)i;
+  } //if
+
+  m_vDense.pop_back();
+  m_vDenseToSlot.pop_back();
+} //remove
+
+/// Remove a projectile given a handle to it. Stale handles are ignored.
+/// \param h Handle to a projectile.
+
+void CProjectilePool::remove(const ProjectileHandle& h){
+  if(IsValid(h))
+    remove(m_vSlotToDense[h.m_nSlot]);
+} //remove
+
+/// Remove all projectiles. Every handle given out so far goes stale.
+
+void CProjectilePool::clear(){
+  for(auto const& slot: m_vDenseToSlot)
+    m_vGeneration[slot]++;
+
+  m_vDense.clear();
+  m_vDenseToSlot.clear();
+  m_vFreeSlots.clear();
+
+  for(size_t i=m_nCapacity; i>0; i--) //so that slot 0 is used first
+    m_vFreeSlots.push_back((unsigned)(i - 1));
+} //clear
+
+/// Check a handle against the current generation of its slot.
+/// \param h Handle to a projectile.
+/// \return true if the projectile it refers to is still alive.
+
+bool CProjectilePool::IsValid(const ProjectileHandle& h){
+  return h.m_nSlot < m_nCapacity && h.m_nGeneration == m_vGeneration[h.m_nSlot];
+} //IsValid
+
+/// Get a pointer to a projectile given a handle to it. The pointer
+/// is only good until the next projectile is removed.
+/// \param h Handle to a projectile.
+/// \return Pointer to the projectile, nullptr if the handle is stale.
+
+CObject* CProjectilePool::get(const ProjectileHandle& h){
+  return IsValid(h)? &m_vDense[m_vSlotToDense[h.m_nSlot]]: nullptr;
+} //get
+
+/// Get a pointer to a projectile given its index in the dense array.
+/// \param i Index, which must be less than size().
+/// \return Pointer to the projectile.
+
+CObject* CProjectilePool::GetProjectile(size_t i){
+  return &m_vDense[i];
+} //GetProjectile
+
+/// Find the projectile that was created first, going by birth time,
+/// and taking the one nearest the front of the array if there is a tie.
+/// This is a linear search, so save it for when the pool is full.
+/// \return Index of the oldest projectile, which is 0 if there are none.
+
+size_t CProjectilePool::GetOldest(){
+  size_t oldest = 0;
+
+  for(size_t i=1; i<m_vDense.size(); i++)
+    if(m_vDense[i].m_fBirthTime < m_vDense[oldest].m_fBirthTime)
+      oldest = i;
+
+  return oldest;
+} //GetOldest
+
+/// Get the number of live projectiles.
+/// \return Number of live projectiles.
+
+size_t CProjectilePool::size(){
+  return m_vDense.size();
+} //size
@@ -0,0 +1,63 @@
+/// \file ProjectilePool.h
+/// \brief Interface for the projectile pool CProjectilePool.
+
+#pragma once
+
+#include <vector>
+
+#include "Object.h"
+
+using namespace std;
+
+const size_t DEFAULT_PROJECTILE_CAPACITY = 512; ///< Default maximum number of projectiles.
+
+/// \brief A handle to a projectile.
+///
+/// A handle names a slot in the projectile pool together with the
+/// generation of that slot when the projectile was created. The
+/// generation goes up every time the slot is freed, so a handle to a
+/// projectile that has since been removed is recognized as stale
+/// instead of quietly referring to whatever projectile took its place.
+
+struct ProjectileHandle{
+  unsigned m_nSlot = 0xFFFFFFFF; ///< Slot index, the default is never valid.
+  unsigned m_nGeneration = 0; ///< Generation of the slot.
+}; //ProjectileHandle
+
+/// \brief The projectile pool.
+///
+/// Bullets are created and destroyed far more often than anything
+/// else in the game, so rather than allocating each one on the heap
+/// they are kept by value in a dense array that is allocated once.
+/// Removal swaps the last projectile into the hole, so the live
+/// projectiles are always packed at the front and can be moved with a
+/// straight loop over the array. Since projectiles move around in the
+/// array, anything that needs to refer to one for longer than a frame
+/// should hold a ProjectileHandle rather than a pointer.
+
+class CProjectilePool{
+  private:
+    size_t m_nCapacity = 0; ///< Maximum number of projectiles.
+
+    vector<CObject> m_vDense; ///< Live projectiles, packed.
+    vector<unsigned> m_vDenseToSlot; ///< Slot of each live projectile.
+    vector<unsigned> m_vSlotToDense; ///< Index into the dense array of each slot in use.
+    vector<unsigned> m_vGeneration; ///< Current generation of each slot.
+    vector<unsigned> m_vFreeSlots; ///< Slots not in use.
+
+    void free(unsigned slot); ///< Return a slot to the free list.
+
+  public:
+    CProjectilePool(size_t capacity=DEFAULT_PROJECTILE_CAPACITY); ///< Constructor.
+
+    ProjectileHandle create(eSpriteType t, const Vector2& v); ///< Create a projectile.
+    void remove(size_t i); ///< Remove the projectile at an index.
+    void remove(const ProjectileHandle& h); ///< Remove the projectile with a handle.
+    void clear(); ///< Remove all projectiles.
+
+    bool IsValid(const ProjectileHandle& h); ///< Whether a handle refers to a live projectile.
+    CObject* get(const ProjectileHandle& h); ///< Get the projectile with a handle.
+    CObject* GetProjectile(size_t i); ///< Get the projectile at an index.
+    size_t GetOldest(); ///< Get the index of the oldest projectile.
+    size_t size(); ///< Number of live projectiles.
+}; //CProjectilePool
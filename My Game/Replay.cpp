@@ -0,0 +1,186 @@
+/// \file Replay.cpp
+/// \brief Code for the replay class CReplay.
+
+#include "Replay.h"
+
+#include <stdio.h>
+#include <string.h>
+
+const size_t REPLAY_RESERVE = 60*60*10; ///< Frames reserved for when recording, ten minutes at 60 fps.
+const long REPLAY_FRAME_SIZE = 10; ///< Bytes per frame in a replay file, two 32-bit times and the input mask.
+
+/// Write a 32-bit value to a file.
+/// \param fp File pointer.
+/// \param p Pointer to the value.
+/// \return true if it was written.
+
+static bool Write32(FILE* fp, const void* p){
+  return fwrite(p, 4, 1, fp) == 1;
+} //Write32
+
+/// Read a 32-bit value from a file.
+/// \param fp File pointer.
+/// \param p [OUT] Pointer to the value.
+/// \return true if it was read.
+
+static bool Read32(FILE* fp, void* p){
+  return fread(p, 4, 1, fp) == 1;
+} //Read32
+
+/// Forget any previous recording and begin a new one. The level
+/// must be loaded fresh straight after this, with the PRNG seeded
+/// and the timer at the time given.
+/// \param level Level being played.
+/// \param seed PRNG seed.
+/// \param t Time that the level is loaded at.
+
+void CReplay::BeginRecording(int level, int seed, float t){
+  m_nLevel = level;
+  m_nSeed = seed;
+  m_fStartTime = t;
+
+  m_vFrames.clear();
+  m_vFrames.reserve(REPLAY_RESERVE);
+  m_bRecording = true;
+} //BeginRecording
+
+/// Record a frame, if recording.
+/// \param t Time that the frame started.
+/// \param dt Frame time.
+/// \param input Mask of eInput flags.
+
+void CReplay::RecordFrame(float t, float dt, unsigned input){
+  if(!m_bRecording)return;
+
+  CReplayFrame f;
+  f.m_fTime = t;
+  f.m_fFrameTime = dt;
+  f.m_nInput = (unsigned short)input;
+
+  m_vFrames.push_back(f);
+} //RecordFrame
+
+/// Stop recording and save the recording to a file.
+/// \param filename File name.
+/// \return true if the file was written.
+
+bool CReplay::EndRecording(const char* filename){
+  if(!m_bRecording)return false;
+  m_bRecording = false;
+
+  FILE* fp = nullptr;
+  fopen_s(&fp, filename, "wb");
+  if(fp == nullptr)return false;
+
+  const unsigned n = (unsigned)m_vFrames.size();
+  bool ok = fwrite("DWRP", 4, 1, fp) == 1 && Write32(fp, &REPLAY_VERSION) &&
+    Write32(fp, &m_nLevel) && Write32(fp, &m_nSeed) && Write32(fp, &m_fStartTime) &&
+    Write32(fp, &n);
+
+  for(size_t i=0; i<m_vFrames.size() && ok; i++){
+    const CReplayFrame& f = m_vFrames[i];
+    ok = Write32(fp, &f.m_fTime) && Write32(fp, &f.m_fFrameTime) &&
+      fwrite(&f.m_nInput, 2, 1, fp) == 1;
+  } //for
+
+  fclose(fp);
+  return ok;
+} //EndRecording
+
+/// Reader function for whether recording.
+/// \return true if recording.
+
+bool CReplay::IsRecording(){
+  return m_bRecording;
+} //IsRecording
+
+/// Bytes left to read in a file.
+/// \param fp File pointer.
+/// \return Number of bytes between the current position and the end, or -1 on error.
+
+static long Remaining(FILE* fp){
+  const long pos = ftell(fp);
+  if(pos < 0 || fseek(fp, 0, SEEK_END) != 0)return -1;
+
+  const long end = ftell(fp);
+  if(fseek(fp, pos, SEEK_SET) != 0)return -1;
+
+  return end - pos;
+} //Remaining
+
+/// Load a replay file. The frame count is checked against the size of
+/// the file before any room is made for the frames, so that a truncated
+/// or corrupt file is rejected instead of asking for gigabytes.
+/// \param filename File name.
+/// \return true if the file was read and is a replay of the right version.
+
+bool CReplay::Load(const char* filename){
+  m_bRecording = false;
+  m_vFrames.clear();
+
+  FILE* fp = nullptr;
+  fopen_s(&fp, filename, "rb");
+  if(fp == nullptr)return false;
+
+  char magic[4];
+  unsigned version = 0, n = 0;
+
+  bool ok = fread(magic, 4, 1, fp) == 1 && !memcmp(magic, "DWRP", 4) &&
+    Read32(fp, &version) && version == REPLAY_VERSION &&
+    Read32(fp, &m_nLevel) && Read32(fp, &m_nSeed) && Read32(fp, &m_fStartTime) &&
+    Read32(fp, &n);
+
+  if(ok)
+    ok = Remaining(fp) >= (long long)n*REPLAY_FRAME_SIZE; //don't trust the count
+
+  if(ok){
+    m_vFrames.resize(n);
+
+    for(size_t i=0; i<n && ok; i++){
+      CReplayFrame& f = m_vFrames[i];
+      ok = Read32(fp, &f.m_fTime) && Read32(fp, &f.m_fFrameTime) &&
+        fread(&f.m_nInput, 2, 1, fp) == 1;
+    } //for
+  } //if
+
+  fclose(fp);
+
+  if(!ok)m_vFrames.clear();
+  return ok;
+} //Load
+
+/// Reader function for the level.
+/// \return Level number.
+
+int CReplay::GetLevel(){
+  return m_nLevel;
+} //GetLevel
+
+/// Reader function for the PRNG seed.
+/// \return Seed.
+
+int CReplay::GetSeed(){
+  return m_nSeed;
+} //GetSeed
+
+/// Reader function for the time that the level was loaded.
+/// \return Time in seconds.
+
+float CReplay::GetStartTime(){
+  return m_fStartTime;
+} //GetStartTime
+
+/// Reader function for the number of frames.
+/// \return Number of frames.
+
+size_t CReplay::GetNumFrames(){
+  return m_vFrames.size();
+} //GetNumFrames
+
+/// Reader function for a frame.
+/// \param i Frame index, which must be less than the number of frames.
+/// \return Reference to the frame.
+
+const CReplayFrame& CReplay::GetFrame(size_t i){
+  return m_vFrames[i];
+} //GetFrame
@@ -0,0 +1,65 @@
+/// \file Replay.h
+/// \brief Interface for the replay class CReplay.
+
+#pragma once
+
+#include <vector>
+
+#include "Defines.h"
+
+using namespace std;
+
+const char DEFAULT_REPLAY_FILE[] = "replay.dwr"; ///< Default replay file name.
+const unsigned REPLAY_VERSION = 1; ///< Replay file format version.
+
+/// \brief A frame of a replay.
+///
+/// Everything that came from outside the simulation during a frame,
+/// that is, the time that the frame started, the frame time that went
+/// into the accumulator, and the player's input.
+
+struct CReplayFrame{
+  float m_fTime = 0.0f; ///< Time that the frame started, in seconds.
+  float m_fFrameTime = 0.0f; ///< Frame time, in seconds.
+  unsigned short m_nInput = 0; ///< Mask of eInput flags.
+}; //CReplayFrame
+
+/// \brief A replay.
+///
+/// A replay is a recording of a level being played, made by CGame and
+/// played back by CHeadlessGame. It holds the level, the seed for the
+/// PRNG, the time that the level was loaded, and a CReplayFrame for
+/// each frame. The simulation depends on nothing else, so playing the
+/// frames back through the same fixed time step accumulator loop takes
+/// it through exactly the same states, provided that the level is
+/// loaded fresh at the same time with the same seed. This holds for a
+/// given build. Different compilers may round differently.
+///
+/// A replay file has a header of 6 little-endian 32-bit fields: the
+/// characters "DWRP", the version, the level, the seed, the time the
+/// level was loaded, and the number of frames. There follows 10 bytes
+/// per frame: the time, the frame time, and a 16-bit input mask.
+/// Frames are kept in memory while recording and written out at the end.
+
+class CReplay{
+  private:
+    int m_nLevel = 0; ///< Level played.
+    int m_nSeed = 0; ///< PRNG seed.
+    float m_fStartTime = 0.0f; ///< Time the level was loaded, in seconds.
+    vector<CReplayFrame> m_vFrames; ///< The frames.
+    bool m_bRecording = false; ///< Whether recording.
+
+  public:
+    void BeginRecording(int level, int seed, float t); ///< Begin recording.
+    void RecordFrame(float t, float dt, unsigned input); ///< Record a frame.
+    bool EndRecording(const char* filename=DEFAULT_REPLAY_FILE); ///< Save the recording.
+    bool IsRecording(); ///< Whether recording.
+
+    bool Load(const char* filename); ///< Load a replay file.
+
+    int GetLevel(); ///< Get the level.
+    int GetSeed(); ///< Get the PRNG seed.
+    float GetStartTime(); ///< Get the time the level was loaded.
+    size_t GetNumFrames(); ///< Get the number of frames.
+    const CReplayFrame& GetFrame(size_t i); ///< Get a frame.
+}; //CReplay
@@ -0,0 +1,163 @@
+/// \file SpatialGrid.cpp
+/// \brief Code for the spatial hash grid CSpatialGrid.
+
+#include "SpatialGrid.h"
+
+/// Create an empty grid. The number of buckets is rounded up
+/// to a power of two so that hashing can use a mask.
+/// \param cellsize Width and height of a cell in pixels.
+/// \param buckets Minimum number of buckets.
+/// \param bucketsize Number of objects to reserve space for in each bucket.
+
+CSpatialGrid::CSpatialGrid(float cellsize, unsigned buckets, size_t bucketsize):
+  m_fCellSize(cellsize){
+  unsigned n = 1;
+
+  while(n < buckets)
+    n <<= 1;
+
+  m_nMask = n - 1;
+  m_vBuckets.resize(n);
+
+  for(auto& bucket: m_vBuckets)
+    bucket.reserve(bucketsize);
+} //constructor
+
+/// Hash a cell to a bucket. Different cells can share a bucket,
+/// which costs a few extra candidates but is otherwise harmless.
+/// \param x Cell column.
+/// \param y Cell row.
+/// \return Bucket index.
+
+unsigned CSpatialGrid::GetBucket(int x, int y){
+  return ((unsigned)x*73856093U ^ (unsigned)y*19349663U) & m_nMask;
+} //GetBucket
+
+/// Get the range of cells covered by an object's bounding sphere.
+/// \param p Pointer to an object.
+/// \param x0 [OUT] Leftmost cell column.
+/// \param y0 [OUT] Bottom cell row.
+/// \param x1 [OUT] Rightmost cell column.
+/// \param y1 [OUT] Top cell row.
+
+void CSpatialGrid::GetCells(CObject* p, int& x0, int& y0, int& x1, int& y1){
+  const BoundingSphere& s = p->GetBoundingSphere();
+
+  x0 = (int)floorf((s.Center.x - s.Radius)/m_fCellSize);
+  y0 = (int)floorf((s.Center.y - s.Radius)/m_fCellSize);
+  x1 = (int)floorf((s.Center.x + s.Radius)/m_fCellSize);
+  y1 = (int)floorf((s.Center.y + s.Radius)/m_fCellSize);
+} //GetCells
+
+/// Put an object into the buckets for the cells recorded in it.
+/// \param p Pointer to an object.
+
+void CSpatialGrid::file(CObject* p){
+  for(int y=p->m_nCellY0; y<=p->m_nCellY1; y++)
+    for(int x=p->m_nCellX0; x<=p->m_nCellX1; x++)
+      m_vBuckets[GetBucket(x, y)].push_back(p);
+} //file
+
+/// Take an object out of the buckets for the cells recorded in it.
+/// Order within a bucket doesn't matter, so swap and pop.
+/// \param p Pointer to an object.
+
+void CSpatialGrid::unfile(CObject* p){
+  for(int y=p->m_nCellY0; y<=p->m_nCellY1; y++)
+    for(int x=p->m_nCellX0; x<=p->m_nCellX1; x++){
+      vector<CObject*>& bucket = m_vBuckets[GetBucket(x, y)];
+
+      for(size_t i=0; i<bucket.size(); i++)
+        if(bucket[i] == p){
+          bucket[i] = bucket.back();
+          bucket.pop_back();
+          break;
+        } //if
+    } //for
+} //unfile
+
+/// Insert an object that isn't in the grid yet, or refile one
+/// that is if it has moved into a different range of cells.
+/// \param p Pointer to an object.
+
+void CSpatialGrid::update(CObject* p){
+  int x0, y0, x1, y1;
+  GetCells(p, x0, y0, x1, y1);
+
+  if(p->m_bInGrid){
+    if(x0 == p->m_nCellX0 && y0 == p->m_nCellY0 &&
+      x1 == p->m_nCellX1 && y1 == p->m_nCellY1)
+      return; //same cells as last time, nothing to do
+
+    unfile(p);
+  } //if
+
+  else{ //first time in
+    p->m_bInGrid = true;
+    p->m_nGridID = m_nNextID++;
+  } //else
+
+  p->m_nCellX0 = x0; p->m_nCellY0 = y0;
+  p->m_nCellX1 = x1; p->m_nCellY1 = y1;
+
+  file(p);
+} //update
+
+/// Remove an object from the grid, for example when it dies.
+/// \param p Pointer to an object.
+
+void CSpatialGrid::remove(CObject* p){
+  if(!p->m_bInGrid)return;
+
+  unfile(p);
+  p->m_bInGrid = false;
+} //remove
+
+/// Remove all objects from the grid.
+
+void CSpatialGrid::clear(){
+  for(auto& bucket: m_vBuckets)
+    bucket.clear();
+
+  m_nNextID = 0;
+} //clear
+
+/// Make room in every bucket for twice as many objects as the fullest
+/// bucket holds now, so that objects can crowd together as they move
+/// around without any bucket having to grow. Call this once the objects
+/// in a level have been inserted.
+
+void CSpatialGrid::reserve(){
+  size_t n = 0; //size of the fullest bucket
+
+  for(auto const& bucket: m_vBuckets)
+    n = max(n, bucket.size());
+
+  for(auto& bucket: m_vBuckets)
+    bucket.reserve(2*n);
+} //reserve
+
+/// Get the objects that share at least one cell with a given object.
+/// The object doesn't have to be in the grid, so this can also be used
+/// to ask a grid of things that never move what is near a moving object.
+/// To visit each pair of objects in the grid once, only take the
+/// neighbors with a greater m_nGridID.
+/// \param p Pointer to an object.
+/// \param neighbors [OUT] Objects sharing a cell with p.
+
+void CSpatialGrid::GetNeighbors(CObject* p, vector<CObject*>& neighbors){
+  neighbors.clear();
+
+  int x0, y0, x1, y1;
+  GetCells(p, x0, y0, x1, y1); //where it is now, not where it was filed
+
+  const unsigned stamp = ++m_nStamp;
+
+  for(int y=y0; y<=y1; y++)
+    for(int x=x0; x<=x1; x++)
+      for(auto const& q: m_vBuckets[GetBucket(x, y)])
+        if(q != p && q->m_nGridStamp != stamp){ //not seen yet this query
+          q->m_nGridStamp = stamp;
+          neighbors.push_back(q);
+        } //if
+} //GetNeighbors
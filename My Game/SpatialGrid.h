@@ -0,0 +1,51 @@
+/// \file SpatialGrid.h
+/// \brief Interface for the spatial hash grid CSpatialGrid.
+
+#pragma once
+
+#include <vector>
+
+#include "Object.h"
+
+using namespace std;
+
+const size_t DEFAULT_BUCKET_SIZE = 4; ///< Objects reserved for in each bucket.
+
+/// \brief The spatial hash grid.
+///
+/// The spatial hash grid is used for broad phase collision detection.
+/// The world is divided into square cells, one tile wide, and each
+/// cell is hashed into one of a fixed number of buckets. An object is
+/// filed in every cell that its bounding sphere overlaps, so any two
+/// objects whose bounding spheres intersect are guaranteed to share a
+/// cell. Objects are only refiled when the range of cells that they
+/// cover changes, which for most objects is hardly ever. Buckets keep
+/// their memory when emptied, and reserve() gives them room to spare
+/// once a level is loaded, so once the game is under way filing an
+/// object doesn't touch the heap.
+
+class CSpatialGrid{
+  private:
+    float m_fCellSize = 0.0f; ///< Width and height of a cell.
+    unsigned m_nMask = 0; ///< Number of buckets minus one.
+    vector<vector<CObject*>> m_vBuckets; ///< Objects filed in each bucket.
+
+    unsigned m_nNextID = 0; ///< ID for the next object inserted.
+    unsigned m_nStamp = 0; ///< Stamp for the current query.
+
+    unsigned GetBucket(int x, int y); ///< Hash a cell to a bucket.
+    void GetCells(CObject* p, int& x0, int& y0, int& x1, int& y1); ///< Get cells covered by an object.
+    void file(CObject* p); ///< File object in its cells.
+    void unfile(CObject* p); ///< Remove object from its cells.
+
+  public:
+    CSpatialGrid(float cellsize, unsigned buckets,
+      size_t bucketsize=DEFAULT_BUCKET_SIZE); ///< Constructor.
+
+    void update(CObject* p); ///< Insert or refile an object.
+    void remove(CObject* p); ///< Remove an object.
+    void clear(); ///< Remove all objects.
+    void reserve(); ///< Make room for objects to move around.
+
+    void GetNeighbors(CObject* p, vector<CObject*>& neighbors); ///< Get objects sharing a cell with an object.
+}; //CSpatialGrid
@@ -7,6 +7,13 @@
 #include "ObjectManager.h"
 #include "DebugPrintf.h"
 #include "Abort.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include "Random.h"
+
+#include <string>
+#include <cfloat>
+#include <sys/stat.h>
 
 #define STBI_ASSERT(x)
 #define STB_IMAGE_IMPLEMENTATION
@@ -28,199 +35,175 @@ CTileManager::~CTileManager(){
   delete [] m_chMap;
 } //destructor
 
-/// Make the AABBs for the walls. Care is taken to use the
-/// longest horizontal and vertical AABBs possible so that
-/// there aren't so many of them.
+/// Make the AABBs for the walls using greedy rectangle meshing.
+/// The map is scanned once from the top left. Each wall tile not
+/// already covered starts a new AABB, which is grown to the right
+/// as far as the wall goes, and then down for as many rows as the
+/// whole span is still uncovered wall. Every wall tile ends up in
+/// exactly one AABB, and no AABB covers anything but wall tiles.
+/// Each tile is visited a constant number of times, so this is linear
+/// in the size of the map.
 
 void CTileManager::MakeBoundingBoxes() {
-  bool** used = new bool*[m_nHeight]; //which walls have been used in an AABB already
-
-  for (int i = 0; i < m_nHeight; i++) {
-    used[i] = new bool[m_nWidth];
+  PROFILE_SCOPE("CTileManager::MakeBoundingBoxes");
 
-    for (int j = 0; j < m_nWidth; j++)
-      used[i][j] = false;
-  } //for
+  vector<bool> used(m_nWidth*m_nHeight, false); //which walls have been used in an AABB already
 
   m_vecWalls.clear(); //no walls yet
 
-  BoundingBox aabb; //current bounding box
-  const Vector3 vTileExtents = 0.5f*Vector3(m_fTileSize, m_fTileSize, m_fTileSize);
+  for(int i=0; i<m_nHeight; i++){
+    const int row = i*m_nWidth; //index of first tile in row i
 
-  //vertical walls with more than one tile
-  const Vector2 vstart = m_vTileRadius + Vector2(0, m_fTileSize*(m_nHeight - 1)); //start position
-  Vector2 pos = vstart; //current position
+    for(int j=0; j<m_nWidth; j++){
+      if(m_chMap[i][j] != 'W' || used[row + j])continue;
 
-  for (int j = 0; j < m_nWidth; j++) {
-    int i = 0;
-    pos.y = vstart.y;
-
-    while (i < m_nHeight) {
-      while (i < m_nHeight && (m_chMap[i][j] != 'W' || used[i][j])) {
-        i++; pos.y -= m_fTileSize;
-      } //while
-
-      if (i < m_nHeight) {
-        aabb.Center = Vector3(pos.x, pos.y, 0);
-        aabb.Extents = vTileExtents;
-        used[i][j] = true;
-        int singleI = i;
-        int singleJ = j;
-        i++; pos.y -= m_fTileSize;
-
-        bool bSingleTile = true;
-
-        while (i < m_nHeight && m_chMap[i][j] == 'W' && !used[i][j]) {
-          BoundingBox b;
-          b.Center = Vector3(pos.x, pos.y, 0);
-          b.Extents = vTileExtents;
-          BoundingBox::CreateMerged(aabb, aabb, b);
-          used[i][j] = true;
-          bSingleTile = false;
-          i++; pos.y -= m_fTileSize;
-        } //while
-
-        if (!bSingleTile) {
-          if (m_vecWalls.size() > 0) {
-
-            bool merged = false;
-            // attempt to find any previous walls that are the same height and centered at the 
-            // same Y position. If one is found, merge it with the current aabb, otherwise push the aabb on the vector
-            for (auto &b : m_vecWalls) {
-              if (b.Center.y == aabb.Center.y && b.Extents.y == aabb.Extents.y &&
-                // checks if they are adjacent bounding boxes
-                (b.Center.x + b.Extents.x == aabb.Center.x - aabb.Extents.x)) {
-                // merge and stop loop
-                BoundingBox::CreateMerged(b, b, aabb);
-                merged = true;
-                break;
-              }
-            }
-            // if the box wasnt merged add it to vecWalls
-            if (!merged)
-              m_vecWalls.push_back(aabb);
-          }
-          // push back aabb if first wall
-          else {
-            m_vecWalls.push_back(aabb);
-          }
-        }
-        else {
-          // mark the unused tile
-          used[singleI][singleJ] = false;
-        }
-      }
-    } //while
+      //grow right
 
-    pos.x += m_fTileSize;
-  } //for
+      int j1 = j + 1; //one past the right end of the span
 
-  //horizontal walls with more than one tile
+      while(j1 < m_nWidth && m_chMap[i][j1] == 'W' && !used[row + j1])
+        j1++;
 
-  pos = vstart; //current position
-  int falseCount = 0;
-  for (int i = 0; i < m_nHeight; i++) {
-    int j = 0;
-    pos.x = vstart.x;
+      //grow down while the whole span is uncovered wall
 
-    while (j < m_nWidth) {
-      // while within width and not W
-      while (j < m_nWidth && (m_chMap[i][j] != 'W' || used[i][j])) {
-        j++; pos.x += m_fTileSize;
-      } //while
-
-      // if within width
-      if (j < m_nWidth) {
-        aabb.Center = Vector3(pos.x, pos.y, 0);
-        aabb.Extents = vTileExtents;
-        used[i][j] = true;
-        int singleI = i;
-        int singleJ = j;
-        j++; pos.x += m_fTileSize;
-
-
-        bool bSingleTile = true;
-
-        while (j < m_nWidth && m_chMap[i][j] == 'W' && !used[i][j]) {
-          BoundingBox b;
-          b.Center = Vector3(pos.x, pos.y, 0);
-          b.Extents = vTileExtents;
-          BoundingBox::CreateMerged(aabb, aabb, b);
-          used[i][j] = true;
-          bSingleTile = false;
-          j++; pos.x += m_fTileSize;
-        } //while
-
-        if (!bSingleTile) {
-          if (m_vecWalls.size() > 0) {
-
-            bool merged = false;
-            // attempt to find any previous walls that are the same height and centered at the 
-            // same X position. If one is found, merge it with the current aabb, otherwise push the aabb on the vector
-            for (auto &b : m_vecWalls) {
-              if (b.Center.x == aabb.Center.x && b.Extents.x == aabb.Extents.x &&
-                // checks if they are adjacent bounding boxes
-                (b.Center.y - b.Extents.y == aabb.Center.y + aabb.Extents.y)) {
-                // merge and stop loop
-                BoundingBox::CreateMerged(b, b, aabb);
-                merged = true;
-                break;
-              }
-            }
-            // if the box wasnt merged add it to vecWalls
-            if (!merged)
-              m_vecWalls.push_back(aabb);
-          }
-          // push back aabb if first wall
-          else {
-            m_vecWalls.push_back(aabb);
-          }
-        }
-        else {
-          // mark single tile as unused
-          used[singleI][singleJ] = false;
-        }
+      int i1 = i + 1; //one past the bottom row
 
-      }
-    } //while
+      for(bool bFull=true; bFull && i1 < m_nHeight; ){
+        const int below = i1*m_nWidth;
 
-    pos.y -= m_fTileSize;
-  } //for
+        for(int k=j; k<j1 && bFull; k++)
+          bFull = m_chMap[i1][k] == 'W' && !used[below + k];
 
-  //orphaned single tiles that are not on an edge
-  pos = vstart + Vector2(m_fTileSize, -m_fTileSize);
+        if(bFull)i1++;
+      } //for
 
-  for (int i = 1; i < m_nHeight - 1; i++) {
-    for (int j = 1; j < m_nWidth - 1; j++) {
-      // 'W' tiles that are unused
-      if (m_chMap[i][j] == 'W' && !used[i][j]) {
-        BoundingBox b;
-        b.Center = Vector3(pos.x, pos.y, 0);
-        b.Extents = vTileExtents;
-        m_vecWalls.push_back(b);
-      } //if
+      //mark as used
 
-      pos.x += m_fTileSize;
-    } //for
+      for(int y=i; y<i1; y++)
+        for(int x=j; x<j1; x++)
+          used[y*m_nWidth + x] = true;
 
-    pos.x = vstart.x + m_fTileSize;
-    pos.y -= m_fTileSize;
-  } //for
+      //row i is at the top of the map, so flip to world space
 
-  //clean up and exit
+      const float left = m_fTileSize*j;
+      const float right = m_fTileSize*j1;
+      const float top = m_fTileSize*(m_nHeight - i);
+      const float bottom = m_fTileSize*(m_nHeight - i1);
 
-  for (int i = 0; i < m_nHeight; i++)
-    delete[] used[i];
+      BoundingBox aabb;
+      aabb.Center = Vector3((left + right)/2, (top + bottom)/2, 0);
+      aabb.Extents = Vector3((right - left)/2, (top - bottom)/2, m_fTileSize/2);
+      m_vecWalls.push_back(aabb);
+
+      j = j1 - 1; //skip the rest of the span
+    } //for
+  } //for
 
-  delete[] used;
+  MakeWallIndex();
 } //MakeBoundingBoxes
 
+/// Index the wall AABBs by tile. Each tile gets the list of walls
+/// that overlap or touch it, stored back to back in one array with
+/// a start offset per tile, so a query only has to look at the walls
+/// near the thing being tested instead of every wall in the level.
+/// Tiles are numbered by column from the left and row from the bottom.
+
+void CTileManager::MakeWallIndex(){
+  const unsigned n = (unsigned)(m_nWidth*m_nHeight); //number of tiles
+
+  m_vecWallCellStart.assign(n + 1, 0);
+  m_vecWallCellList.clear();
+  m_vecWallStamp.assign(m_vecWalls.size(), 0);
+  m_vecWallHits.clear();
+  m_vecWallHits.reserve(m_vecWalls.size());
+  m_nWallStamp = 0;
+
+  int x0, y0, x1, y1; //range of tiles
+
+  //count the walls in each tile
+
+  for(auto const& b: m_vecWalls)
+    if(GetCells(b, x0, y0, x1, y1))
+      for(int y=y0; y<=y1; y++)
+        for(int x=x0; x<=x1; x++)
+          m_vecWallCellStart[y*m_nWidth + x + 1]++;
+
+  //prefix sum gives the start of each tile's list
+
+  for(unsigned i=0; i<n; i++)
+    m_vecWallCellStart[i + 1] += m_vecWallCellStart[i];
+
+  m_vecWallCellList.resize(m_vecWallCellStart[n]);
+
+  //fill in the lists
+
+  vector<unsigned> next(m_vecWallCellStart.begin(), m_vecWallCellStart.end() - 1);
+
+  for(unsigned w=0; w<m_vecWalls.size(); w++)
+    if(GetCells(m_vecWalls[w], x0, y0, x1, y1))
+      for(int y=y0; y<=y1; y++)
+        for(int x=x0; x<=x1; x++)
+          m_vecWallCellList[next[y*m_nWidth + x]++] = w;
+} //MakeWallIndex
+
+/// Get the range of tiles touched by a rectangle, clamped to the map.
+/// A rectangle that only touches the edge of a tile counts as touching
+/// it, since Intersects() counts touching as intersecting.
+/// \param left Left edge.
+/// \param bottom Bottom edge.
+/// \param right Right edge.
+/// \param top Top edge.
+/// \param x0 [OUT] Leftmost tile column.
+/// \param y0 [OUT] Bottom tile row.
+/// \param x1 [OUT] Rightmost tile column.
+/// \param y1 [OUT] Top tile row.
+/// \return true if the rectangle touches at least one tile.
+
+bool CTileManager::GetCells(float left, float bottom, float right, float top,
+  int& x0, int& y0, int& x1, int& y1)
+{
+  x0 = max(0, (int)ceilf(left/m_fTileSize) - 1);
+  y0 = max(0, (int)ceilf(bottom/m_fTileSize) - 1);
+  x1 = min(m_nWidth - 1, (int)floorf(right/m_fTileSize));
+  y1 = min(m_nHeight - 1, (int)floorf(top/m_fTileSize));
+
+  return x0 <= x1 && y0 <= y1;
+} //GetCells
+
+/// Get the range of tiles touched by an AABB.
+/// \param b An AABB.
+/// \param x0 [OUT] Leftmost tile column.
+/// \param y0 [OUT] Bottom tile row.
+/// \param x1 [OUT] Rightmost tile column.
+/// \param y1 [OUT] Top tile row.
+/// \return true if the AABB touches at least one tile.
+
+bool CTileManager::GetCells(const BoundingBox& b, int& x0, int& y0, int& x1, int& y1){
+  return GetCells(b.Center.x - b.Extents.x, b.Center.y - b.Extents.y,
+    b.Center.x + b.Extents.x, b.Center.y + b.Extents.y, x0, y0, x1, y1);
+} //GetCells
+
+/// Get the range of tiles touched by a bounding sphere.
+/// \param s A bounding sphere.
+/// \param x0 [OUT] Leftmost tile column.
+/// \param y0 [OUT] Bottom tile row.
+/// \param x1 [OUT] Rightmost tile column.
+/// \param y1 [OUT] Top tile row.
+/// \return true if the sphere touches at least one tile.
+
+bool CTileManager::GetCells(const BoundingSphere& s, int& x0, int& y0, int& x1, int& y1){
+  return GetCells(s.Center.x - s.Radius, s.Center.y - s.Radius,
+    s.Center.x + s.Radius, s.Center.y + s.Radius, x0, y0, x1, y1);
+} //GetCells
+
 /// Delete the old map (if any), allocate the right sized
 /// chunk of memory for the new map, and read it from a
 /// text file.
 /// \param filename Name of the map file.
 
 void CTileManager::LoadMap(char* filename){
+  m_vecPVS.clear(); //only levels loaded through the cache get one
+
   if(m_chMap != nullptr){ //unload any previous maps
     for(int i=0; i<m_nHeight; i++)
       delete [] m_chMap[i];
@@ -290,8 +273,8 @@ void CTileManager::LoadMap(char* filename){
 } //LoadMap
 
 
-// returns a objColor enum based on the color of a given pixel. Used in LoadMapFromImageFile
-objColor CTileManager::getTileColor(unsigned char* buffer, const int &i) {
+// returns a objColor enum based on the color of a given pixel. Used in LoadMapFromPixels
+objColor CTileManager::getTileColor(const unsigned char* buffer, const int &i) {
   int r = buffer[i];
   int g = buffer[i + 1];
   int b = buffer[i + 2];
@@ -358,7 +341,26 @@ objColor CTileManager::getTileColor(unsigned char* buffer, const int &i) {
 }
 
 //sweet function from lab 4
-void CTileManager::LoadMapFromImageFile(char* filename) {
+void CTileManager::LoadMapFromImageFile(const char* filename) {
+  PROFILE_SCOPE("CTileManager::LoadMapFromImageFile");
+
+  //read map file into a byte buffer 
+  int w = 0, h = 0, channels = 0;
+  unsigned char* buffer = stbi_load(filename, &w, &h, &channels, 0);
+
+  LoadMapFromPixels(buffer, w, h, channels);
+  stbi_image_free(buffer);
+} //LoadMapFromImageFile
+
+/// Load a map from the pixels of a level image, top row first, for
+/// example as decoded from a PNG or as made by the level generator.
+/// \param buffer Pixels, at least RGB.
+/// \param w Width in pixels, which is also in tiles.
+/// \param h Height in pixels, which is also in tiles.
+/// \param channels Number of bytes per pixel.
+
+void CTileManager::LoadMapFromPixels(const unsigned char* buffer, int w, int h, int channels){
+  m_vecPVS.clear(); //computed separately by MakePVS()
 
   if (m_chMap != nullptr) { //unload any previous maps
     for (int i = 0; i < m_nHeight; i++)
@@ -366,9 +368,8 @@ void CTileManager::LoadMapFromImageFile(char* filename) {
     delete[] m_chMap;
   } //if
 
-  //read map file into a byte buffer 
-  int channels = 0;
-  unsigned char* buffer = stbi_load(filename, &m_nWidth, &m_nHeight, &channels, 0);
+  m_nWidth = w;
+  m_nHeight = h;
 
   //allocate space for the map 
 
@@ -584,9 +585,500 @@ void CTileManager::LoadMapFromImageFile(char* filename) {
 
   m_vWorldSize = Vector2((float)m_nWidth, (float)m_nHeight)*m_fTileSize;
   MakeBoundingBoxes();
+} //LoadMapFromPixels
+
+//Potentially visible set. For each open tile we keep one bit for each
+//tile in a window around it, set if that tile might be visible from
+//it. This is worked out once when the level cache is built and is
+//then a quick way of rejecting most line of sight queries before
+//casting any rays. The window is big enough for the turrets and guns,
+//anything outside it is assumed to be visible. Breakable walls are
+//objects, not wall tiles, so they are treated as see-through here,
+//which errs on the side of visible whether they are broken or not.
+
+static const int PVS_RANGE_X = 14; ///< Tiles left and right covered by the window.
+static const int PVS_RANGE_Y = 4; ///< Tiles up and down covered by the window.
+static const int PVS_SPAN_X = 2*PVS_RANGE_X + 1; ///< Width of the window in tiles.
+static const int PVS_SPAN_Y = 2*PVS_RANGE_Y + 1; ///< Height of the window in tiles.
+static const int PVS_BITS = PVS_SPAN_X*PVS_SPAN_Y; ///< Bits per open tile.
+static const size_t PVS_WORDS = (PVS_BITS + 31)/32; ///< Words per open tile.
+
+/// Number the open tiles in order, which tells us where in m_vecPVS
+/// the bits for each tile are kept. Tiles are numbered by column from
+/// the left and row from the bottom.
+/// \return Number of open tiles.
+
+unsigned CTileManager::MakePVSRows(){
+  m_vecPVSRow.assign(m_nWidth*m_nHeight, -1);
+  unsigned n = 0; //number of open tiles so far
+
+  for(int y=0; y<m_nHeight; y++)
+    for(int x=0; x<m_nWidth; x++)
+      if(!IsWall(x, y))
+        m_vecPVSRow[y*m_nWidth + x] = n++;
+
+  return n;
+} //MakePVSRows
+
+static const int PVS_SAMPLES = 3; ///< Rays start and end on a grid this many points wide in each tile.
+static const size_t PVS_MAX_TILES = 1 << 18; ///< Most tiles in a level that gets a potentially visible set.
+
+/// Compute the potentially visible set from the wall tiles. A tile is
+/// marked as visible from another if a ray can be cast from one of the
+/// points of a PVS_SAMPLES by PVS_SAMPLES grid spread over the first
+/// tile to one of the points of the same grid over the second. Every
+/// point in a tile is within the half diagonal of a grid square of a
+/// grid point, so any ray between the two tiles that Visible() might
+/// cast is within that distance of one of these rays all the way along.
+/// The walls are therefore shrunk by a little more than that when these
+/// rays are cast, so that a sight line squeezing through a gap too narrow
+/// for any of them is still found, and the set is conservative: it never
+/// hides anything that Visible() would have seen.
+///
+/// Casting all of those rays between tiles that can't see each other
+/// is slow, so the window is swept outwards from the eye and rays are only
+/// cast to a tile if one of its neighbors on the eye's side is visible.
+/// A ray that Visible() casts only passes through open tiles, and the one
+/// it passes through before reaching a tile is one of those neighbors and
+/// is visible along the same ray, so this hides nothing that Visible()
+/// would have seen either. Tiles in the shadow of a wall therefore cost
+/// next to nothing, and only the edges of the shadows cost a full set of
+/// rays. Tiles with no walls in the rectangle between them and the eye
+/// can't be hidden and cost no rays at all. Levels bigger than
+/// PVS_MAX_TILES don't get a potentially visible set at all so that
+/// loading them doesn't stall or take up too much memory, and every
+/// query on them casts rays.
+
+void CTileManager::MakePVS(){
+  PROFILE_SCOPE("CTileManager::MakePVS");
+
+  m_vecPVS.clear();
+  m_vecPVSRow.clear();
+
+  if((size_t)m_nWidth*m_nHeight > PVS_MAX_TILES)
+    return; //too big, PotentiallyVisible() will say yes to everything
+
+  const unsigned rows = MakePVSRows();
+  m_vecPVS.assign((size_t)rows*PVS_WORDS, 0);
+
+  const float cell = m_fTileSize/PVS_SAMPLES; //width of a grid square
+  const float margin = 0.75f*cell; //a little more than half the diagonal, which is 0.707 cells
+
+  float u[PVS_SAMPLES]; //sample offsets
+
+  for(int i=0; i<PVS_SAMPLES; i++)
+    u[i] = (i + 0.5f)*cell;
+
+  const int n = PVS_SAMPLES*PVS_SAMPLES; //samples per tile
+
+  auto bit = [&](int dx, int dy){ //bit for a tile in a window
+    return (dy + PVS_RANGE_Y)*PVS_SPAN_X + dx + PVS_RANGE_X;
+  }; //bit
+
+  auto set = [&](int row, int dx, int dy){ //mark a tile in a window
+    const int b = bit(dx, dy);
+    m_vecPVS[row*PVS_WORDS + (b >> 5)] |= 1U << (b & 31);
+  }; //set
+
+  auto get = [&](int row, int dx, int dy){ //whether a tile in a window is marked
+    const int b = bit(dx, dy);
+    return (m_vecPVS[row*PVS_WORDS + (b >> 5)] & (1U << (b & 31))) != 0;
+  }; //get
+
+  //number of walls in the tiles below and to the left of each corner,
+  //so that we can tell in one go whether a rectangle of tiles is clear
+
+  const int w1 = m_nWidth + 1;
+  vector<unsigned> walls((size_t)w1*(m_nHeight + 1), 0);
+
+  for(int y=0; y<m_nHeight; y++)
+    for(int x=0; x<m_nWidth; x++)
+      walls[(y + 1)*w1 + x + 1] = walls[y*w1 + x + 1] + walls[(y + 1)*w1 + x] -
+        walls[y*w1 + x] + (IsWall(x, y)? 1: 0);
+
+  auto clear = [&](int x0, int y0, int x1, int y1){ //whether a rectangle of tiles has no walls
+    return walls[(y1 + 1)*w1 + x1 + 1] - walls[y0*w1 + x1 + 1] -
+      walls[(y1 + 1)*w1 + x0] + walls[y0*w1 + x0] == 0;
+  }; //clear
+
+  //the window in order of distance from the eye, so that each tile's
+  //neighbors on the eye's side come before it
+
+  vector<pair<int, int>> window;
+
+  for(int dy=-PVS_RANGE_Y; dy<=PVS_RANGE_Y; dy++)
+    for(int dx=-PVS_RANGE_X; dx<=PVS_RANGE_X; dx++)
+      if(dx != 0 || dy != 0)
+        window.push_back(make_pair(dx, dy));
+
+  stable_sort(window.begin(), window.end(), [](const pair<int, int>& a, const pair<int, int>& b){
+    return abs(a.first) + abs(a.second) < abs(b.first) + abs(b.second);
+  }); //stable_sort
+
+  //visibility is symmetric, so only cast rays forwards and set both bits,
+  //the tiles behind have already been done from the other end
+
+  for(int y0=0; y0<m_nHeight; y0++)
+    for(int x0=0; x0<m_nWidth; x0++){
+      const int row0 = m_vecPVSRow[y0*m_nWidth + x0];
+      if(row0 < 0)continue; //eyes aren't in walls
+
+      set(row0, 0, 0); //a tile can see itself
+
+      for(auto const& w: window){
+        const int dx = w.first, dy = w.second;
+        if(dy < 0 || (dy == 0 && dx < 0))continue; //behind, already done
+
+        const int x1 = x0 + dx, y1 = y0 + dy;
+        if(x1 < 0 || x1 >= m_nWidth || y1 >= m_nHeight)continue;
 
-  stbi_image_free(buffer);
-} //LoadMapFromImageFile
+        const int row1 = m_vecPVSRow[y1*m_nWidth + x1];
+        if(row1 < 0)continue; //rays that end in walls are blocked
+
+        const int sx = dx > 0? 1: dx < 0? -1: 0; //steps back towards the eye
+        const int sy = dy > 0? 1: dy < 0? -1: 0;
+
+        const bool bLit = (sx != 0 && get(row0, dx - sx, dy)) ||
+          (sy != 0 && get(row0, dx, dy - sy)) ||
+          (sx != 0 && sy != 0 && get(row0, dx - sx, dy - sy));
+
+        if(!bLit)continue; //in the shadow of a wall
+
+        bool bSeen = clear(min(x0, x1), y0, max(x0, x1), y1); //nothing in the way
+
+
+        for(int k=0; k<n*n && !bSeen; k++){ //every sample to every sample
+          const int a = (k + n*n/2)%(n*n); //start with the centers
+          const int a0 = a%n, a1 = a/n; //sample in each tile
+          const Vector2 p0(m_fTileSize*x0 + u[a0%PVS_SAMPLES], m_fTileSize*y0 + u[a0/PVS_SAMPLES]);
+          const Vector2 p1(m_fTileSize*x1 + u[a1%PVS_SAMPLES], m_fTileSize*y1 + u[a1/PVS_SAMPLES]);
+          bSeen = RayClear(p0, p1, margin);
+        } //for
+
+        if(bSeen){
+          set(row0, dx, dy);
+          set(row1, -dx, -dy);
+        } //if
+      } //for
+    } //for
+} //MakePVS
+
+/// Look up the potentially visible set to find out whether a circle
+/// might be visible from a point, that is, whether any of the tiles
+/// that the circle covers can be seen from the tile that the point
+/// is in. If not then there's no need to cast any rays.
+/// \param p0 A point.
+/// \param p1 Center of circle.
+/// \param radius Radius of circle.
+/// \return false if the circle is definitely hidden.
+
+bool CTileManager::PotentiallyVisible(const Vector2& p0, const Vector2& p1, float radius){
+  if(m_vecPVS.empty())return true; //no potentially visible set, so can't tell
+
+  const int x0 = (int)floorf(p0.x/m_fTileSize);
+  const int y0 = (int)floorf(p0.y/m_fTileSize);
+
+  if(x0 < 0 || x0 >= m_nWidth || y0 < 0 || y0 >= m_nHeight)
+    return true; //off the map
+
+  const int row = m_vecPVSRow[y0*m_nWidth + x0];
+  if(row < 0)return false; //can't see out of a wall
+
+  const unsigned* bits = &m_vecPVS[row*PVS_WORDS];
+
+  //tiles that the rays to the circle can end in, relative to the eye
+
+  const int dx0 = (int)floorf((p1.x - radius)/m_fTileSize) - x0;
+  const int dy0 = (int)floorf((p1.y - radius)/m_fTileSize) - y0;
+  const int dx1 = (int)floorf((p1.x + radius)/m_fTileSize) - x0;
+  const int dy1 = (int)floorf((p1.y + radius)/m_fTileSize) - y0;
+
+  if(dx0 < -PVS_RANGE_X || dx1 > PVS_RANGE_X || dy0 < -PVS_RANGE_Y || dy1 > PVS_RANGE_Y)
+    return true; //outside the window
+
+  if(x0 + dx0 < 0 || x0 + dx1 >= m_nWidth || y0 + dy0 < 0 || y0 + dy1 >= m_nHeight)
+    return true; //off the map, where there are no walls
+
+  for(int dy=dy0; dy<=dy1; dy++)
+    for(int dx=dx0; dx<=dx1; dx++){
+      const int b = (dy + PVS_RANGE_Y)*PVS_SPAN_X + dx + PVS_RANGE_X;
+
+      if(bits[b >> 5] & (1U << (b & 31)))
+        return true;
+    } //for
+
+  return false;
+} //PotentiallyVisible
+
+//Level cache. Decoding the level PNG, classifying every pixel, and
+//meshing the walls is done once per level image and the results are
+//saved next to it in a binary file with the same name and extension
+//.bin. After that the level is loaded by mapping the binary file into
+//memory and copying each section straight into place. The binary file
+//is rebuilt whenever the PNG is newer or the format version changes.
+
+static const unsigned LEVEL_CACHE_MAGIC = 0x564C4144; ///< "DALV" in a little-endian file.
+static const unsigned LEVEL_CACHE_VERSION = 4; ///< Bump this when the format changes.
+
+/// \brief Sections of the level cache, in file order.
+
+enum eCacheSection{
+  CACHE_MAP, CACHE_WALLS, CACHE_LADDERS, CACHE_DOORS, CACHE_ENDPOINTS,
+  CACHE_STOPPOINTS, CACHE_ELEVATORS, CACHE_BREAKABLEWALLS, CACHE_TRAPS,
+  CACHE_SWITCHES, CACHE_TELEPORTERS, CACHE_TELEPORTSPAWNS, CACHE_KEYS,
+  CACHE_ENEMIES, CACHE_GUNS, CACHE_PVS, NUM_CACHE_SECTIONS
+}; //eCacheSection
+
+/// \brief Header at the start of the level cache.
+
+struct LevelCacheHeader{
+  unsigned m_nMagic; ///< Must be LEVEL_CACHE_MAGIC.
+  unsigned m_nVersion; ///< Must be LEVEL_CACHE_VERSION.
+  unsigned m_nHeaderSize; ///< Must be the size of this header in the build reading it.
+  float m_fTileSize; ///< Tile size that the positions were computed for.
+  int m_nWidth; ///< Number of tiles wide.
+  int m_nHeight; ///< Number of tiles high.
+
+  Vector2 m_vExitLocation; ///< Exit position.
+  Vector2 m_vFastLocation; ///< Fast character position.
+  Vector2 m_vFighterLocation; ///< Fighter character position.
+  Vector2 m_vShieldLocation; ///< Shield character position.
+
+  unsigned m_nOffset[NUM_CACHE_SECTIONS]; ///< Byte offset of each section.
+  unsigned m_nCount[NUM_CACHE_SECTIONS]; ///< Number of elements in each section.
+  unsigned m_nSize[NUM_CACHE_SECTIONS]; ///< Size in bytes of an element of each section.
+}; //LevelCacheHeader
+
+/// Get the name of the level cache for a level image.
+/// \param filename Name of the level image.
+/// \return Name of the level cache.
+
+static string GetCacheName(const char* filename){
+  string name(filename);
+  const size_t dot = name.rfind('.');
+
+  if(dot != string::npos)
+    name.erase(dot);
+
+  return name + ".bin";
+} //GetCacheName
+
+/// Get the last modification time of a file.
+/// \param filename Name of the file.
+/// \param t [OUT] Modification time.
+/// \return true if the file exists.
+
+static bool GetModifiedTime(const char* filename, time_t& t){
+  struct stat st;
+  if(stat(filename, &st) != 0)return false;
+
+  t = st.st_mtime;
+  return true;
+} //GetModifiedTime
+
+/// Copy a section of the level cache into a vector. A cache written by a
+/// build in which the elements are a different size, for example one in
+/// which SimpleMath or DirectXCollision pads them differently, is rejected.
+/// \param f The mapped level cache.
+/// \param h The level cache header.
+/// \param s Which section.
+/// \param v [OUT] Vector to copy the section into.
+/// \return true if the section has elements of the right size and lies within the file.
+
+template<class T> static bool ReadSection(const CMappedFile& f,
+  const LevelCacheHeader& h, eCacheSection s, vector<T>& v)
+{
+  if(h.m_nSize[s] != sizeof(T))
+    return false;
+
+  const size_t bytes = (size_t)h.m_nCount[s]*sizeof(T);
+  if(h.m_nOffset[s] > f.GetSize() || bytes > f.GetSize() - h.m_nOffset[s])
+    return false;
+
+  const T* p = (const T*)(f.GetData() + h.m_nOffset[s]);
+  v.assign(p, p + h.m_nCount[s]);
+  return true;
+} //ReadSection
+
+/// Append a section to the level cache, padded to a 16-byte boundary
+/// so that every section is aligned in the mapped view.
+/// \param output Level cache file handle.
+/// \param h [OUT] The level cache header.
+/// \param s Which section.
+/// \param p Pointer to the first element.
+/// \param n Number of elements.
+/// \param size Size of an element in bytes.
+
+static void WriteSection(FILE* output, LevelCacheHeader& h, eCacheSection s,
+  const void* p, size_t n, size_t size)
+{
+  static const char pad[16] = {0};
+  const long pos = ftell(output);
+  const long aligned = (pos + 15) & ~15L;
+
+  fwrite(pad, 1, aligned - pos, output);
+
+  h.m_nOffset[s] = (unsigned)aligned;
+  h.m_nCount[s] = (unsigned)n;
+  h.m_nSize[s] = (unsigned)size;
+
+  if(n > 0)
+    fwrite(p, size, n, output);
+} //WriteSection
+
+/// Load a level, from the level cache if it is up to date, otherwise
+/// from the level image, in which case the level cache is rebuilt.
+/// \param filename Name of the level image.
+
+void CTileManager::LoadLevel(const char* filename){
+  PROFILE_SCOPE("CTileManager::LoadLevel");
+
+  const string cachename = GetCacheName(filename);
+  time_t tImage = 0, tCache = 0;
+
+  const bool bImage = GetModifiedTime(filename, tImage);
+  const bool bCache = GetModifiedTime(cachename.c_str(), tCache);
+
+  if(bCache && (!bImage || tCache >= tImage) && LoadLevelCache(cachename.c_str()))
+    return; //cache hit
+
+  LoadMapFromImageFile(filename);
+  MakePVS();
+  SaveLevelCache(cachename.c_str());
+} //LoadLevel
+
+/// Load a level from a level cache.
+/// \param filename Name of the level cache.
+/// \return true if the level cache was valid and has been loaded.
+
+bool CTileManager::LoadLevelCache(const char* filename){
+  PROFILE_SCOPE("CTileManager::LoadLevelCache");
+
+  CMappedFile f;
+  if(!f.open(filename) || f.GetSize() < sizeof(LevelCacheHeader))
+    return false;
+
+  const LevelCacheHeader& h = *(const LevelCacheHeader*)f.GetData();
+
+  if(h.m_nMagic != LEVEL_CACHE_MAGIC || h.m_nVersion != LEVEL_CACHE_VERSION ||
+    h.m_nHeaderSize != sizeof(LevelCacheHeader) || h.m_fTileSize != m_fTileSize ||
+    h.m_nWidth <= 0 || h.m_nHeight <= 0 ||
+    h.m_nCount[CACHE_MAP] != (unsigned)(h.m_nWidth*h.m_nHeight))
+    return false;
+
+  vector<char> map;
+  vector<BoundingBox> walls;
+
+  if(!ReadSection(f, h, CACHE_MAP, map) ||
+    !ReadSection(f, h, CACHE_WALLS, walls) ||
+    !ReadSection(f, h, CACHE_LADDERS, m_vecLadders) ||
+    !ReadSection(f, h, CACHE_DOORS, m_vecDoors) ||
+    !ReadSection(f, h, CACHE_ENDPOINTS, m_vecEndPoints) ||
+    !ReadSection(f, h, CACHE_STOPPOINTS, m_vecStopPoints) ||
+    !ReadSection(f, h, CACHE_ELEVATORS, m_vecElevators) ||
+    !ReadSection(f, h, CACHE_BREAKABLEWALLS, m_vecBreakableWalls) ||
+    !ReadSection(f, h, CACHE_TRAPS, m_vecTraps) ||
+    !ReadSection(f, h, CACHE_SWITCHES, m_vecSwitches) ||
+    !ReadSection(f, h, CACHE_TELEPORTERS, m_vecTeleporters) ||
+    !ReadSection(f, h, CACHE_TELEPORTSPAWNS, m_vecTeleportSpawns) ||
+    !ReadSection(f, h, CACHE_KEYS, m_vecKeys) ||
+    !ReadSection(f, h, CACHE_ENEMIES, m_vecEnemies) ||
+    !ReadSection(f, h, CACHE_GUNS, m_vecGuns) ||
+    !ReadSection(f, h, CACHE_PVS, m_vecPVS))
+  {
+    clear(); //don't leave half a level behind
+    return false;
+  } //if
+
+  if(m_chMap != nullptr){ //unload any previous maps
+    for(int i=0; i<m_nHeight; i++)
+      delete [] m_chMap[i];
+
+    delete [] m_chMap;
+  } //if
+
+  m_nWidth = h.m_nWidth;
+  m_nHeight = h.m_nHeight;
+  m_chMap = new char*[m_nHeight];
+
+  for(int i=0; i<m_nHeight; i++){
+    m_chMap[i] = new char[m_nWidth];
+    memcpy(m_chMap[i], &map[i*m_nWidth], m_nWidth);
+  } //for
+
+  m_vecWalls.swap(walls);
+  MakeWallIndex();
+
+  if(m_vecPVS.size() != (size_t)MakePVSRows()*PVS_WORDS) //wrong size, so don't use it
+    m_vecPVS.clear();
+
+  m_vExitLocation = h.m_vExitLocation;
+  m_vFastLocation = h.m_vFastLocation;
+  m_vFighterLocation = h.m_vFighterLocation;
+  m_vShieldLocation = h.m_vShieldLocation;
+
+  m_vWorldSize = Vector2((float)m_nWidth, (float)m_nHeight)*m_fTileSize;
+  return true;
+} //LoadLevelCache
+
+/// Save the current level to a level cache. Failure to write it is not
+/// an error, it just means that the level image is parsed next time too.
+/// \param filename Name of the level cache.
+
+void CTileManager::SaveLevelCache(const char* filename){
+  PROFILE_SCOPE("CTileManager::SaveLevelCache");
+
+  FILE* output = nullptr;
+  fopen_s(&output, filename, "wb");
+  if(output == nullptr)return;
+
+  LevelCacheHeader h = {};
+  h.m_nMagic = 0; //written last so that a partial file is never valid
+  h.m_nVersion = LEVEL_CACHE_VERSION;
+  h.m_nHeaderSize = sizeof(LevelCacheHeader);
+  h.m_fTileSize = m_fTileSize;
+  h.m_nWidth = m_nWidth;
+  h.m_nHeight = m_nHeight;
+  h.m_vExitLocation = m_vExitLocation;
+  h.m_vFastLocation = m_vFastLocation;
+  h.m_vFighterLocation = m_vFighterLocation;
+  h.m_vShieldLocation = m_vShieldLocation;
+
+  fwrite(&h, sizeof(h), 1, output);
+
+  vector<char> map(m_nWidth*m_nHeight);
+
+  for(int i=0; i<m_nHeight; i++)
+    memcpy(&map[i*m_nWidth], m_chMap[i], m_nWidth);
+
+  #define WRITE_SECTION(s, v) WriteSection(output, h, s, v.data(), v.size(), sizeof(v[0]))
+
+  WRITE_SECTION(CACHE_MAP, map);
+  WRITE_SECTION(CACHE_WALLS, m_vecWalls);
+  WRITE_SECTION(CACHE_LADDERS, m_vecLadders);
+  WRITE_SECTION(CACHE_DOORS, m_vecDoors);
+  WRITE_SECTION(CACHE_ENDPOINTS, m_vecEndPoints);
+  WRITE_SECTION(CACHE_STOPPOINTS, m_vecStopPoints);
+  WRITE_SECTION(CACHE_ELEVATORS, m_vecElevators);
+  WRITE_SECTION(CACHE_BREAKABLEWALLS, m_vecBreakableWalls);
+  WRITE_SECTION(CACHE_TRAPS, m_vecTraps);
+  WRITE_SECTION(CACHE_SWITCHES, m_vecSwitches);
+  WRITE_SECTION(CACHE_TELEPORTERS, m_vecTeleporters);
+  WRITE_SECTION(CACHE_TELEPORTSPAWNS, m_vecTeleportSpawns);
+  WRITE_SECTION(CACHE_KEYS, m_vecKeys);
+  WRITE_SECTION(CACHE_ENEMIES, m_vecEnemies);
+  WRITE_SECTION(CACHE_GUNS, m_vecGuns);
+  WRITE_SECTION(CACHE_PVS, m_vecPVS);
+
+  #undef WRITE_SECTION
+
+  //now that the sections are down, fill in the header
+
+  h.m_nMagic = LEVEL_CACHE_MAGIC;
+  fseek(output, 0, SEEK_SET);
+  fwrite(&h, sizeof(h), 1, output);
+  fclose(output);
+} //SaveLevelCache
 
 /// This is for debug purposes so that you can verify that
 /// the collision shapes are in the right places.
@@ -618,6 +1110,8 @@ void CTileManager::clear(){
 /// \param t Sprite type for a 3-frame sprite: 0 is floor, 1 is wall, 2 is an error flag.
  
 void CTileManager::Draw(eSpriteType t){
+  PROFILE_SCOPE("CTileManager::Draw");
+
   CSpriteDesc2D desc;
   desc.m_nSpriteIndex = t;
 
@@ -663,17 +1157,172 @@ void CTileManager::Draw(eSpriteType t){
   } //for
 } //Draw
 
+/// Check whether a tile is a wall. Tiles are numbered by column from
+/// the left and row from the bottom. Anything outside the map is open.
+/// \param x Tile column.
+/// \param y Tile row.
+/// \return true if the tile is a wall.
+
+bool CTileManager::IsWall(int x, int y) const{
+  if(x < 0 || x >= m_nWidth || y < 0 || y >= m_nHeight)
+    return false;
+
+  return m_chMap[m_nHeight - 1 - y][x] == 'W'; //row 0 is at the top
+} //IsWall
+
+/// Check whether a line segment crosses a rectangle, using the clipping
+/// of Liang and Barsky. Touching the edge counts as crossing.
+/// \param p0 Start of line segment.
+/// \param d End of line segment minus start.
+/// \param left Left edge of rectangle.
+/// \param bottom Bottom edge of rectangle.
+/// \param right Right edge of rectangle.
+/// \param top Top edge of rectangle.
+/// \return true if the line segment crosses the rectangle.
+
+static bool SegmentHitsRect(const Vector2& p0, const Vector2& d,
+  float left, float bottom, float right, float top)
+{
+  const float p[4] = {-d.x, d.x, -d.y, d.y}; //rate of approach to each edge
+  const float q[4] = {p0.x - left, right - p0.x, p0.y - bottom, top - p0.y}; //distance inside each edge
+
+  float t0 = 0.0f, t1 = 1.0f; //fractions of the way along the segment that are inside
+
+  for(int i=0; i<4; i++)
+    if(p[i] == 0.0f){ //parallel to the edge
+      if(q[i] < 0.0f)return false; //and outside it
+    } //if
+
+    else{
+      const float t = q[i]/p[i]; //where the segment crosses the edge
+
+      if(p[i] < 0.0f)t0 = max(t0, t); //going in
+      else t1 = min(t1, t); //coming out
+    } //else
+
+  return t0 <= t1;
+} //SegmentHitsRect
+
+/// Check whether a line segment gets from one end to the other without
+/// passing through a wall tile. This walks the tiles that the segment
+/// passes through in order, using the DDA of Amanatides and Woo, and
+/// stops at the first wall, so the cost depends on the length of the
+/// segment and not on the number of walls in the level. With a margin,
+/// a wall tile only blocks the segment if the segment crosses what is
+/// left of the tile after shrinking it by the margin on every side.
+/// \param p0 Start of line segment.
+/// \param p1 End of line segment.
+/// \param margin Amount to shrink each wall tile by on every side.
+/// \return true if the line segment misses all of the walls.
+
+bool CTileManager::RayClear(const Vector2& p0, const Vector2& p1, float margin){
+  const Vector2 d = p1 - p0; //direction, not normalized
+
+  int x = (int)floorf(p0.x/m_fTileSize); //current tile
+  int y = (int)floorf(p0.y/m_fTileSize);
+
+  const int x1 = (int)floorf(p1.x/m_fTileSize); //last tile
+  const int y1 = (int)floorf(p1.y/m_fTileSize);
+
+  const int stepx = d.x > 0.0f? 1: -1;
+  const int stepy = d.y > 0.0f? 1: -1;
+
+  //tmax is the fraction of the way along the segment at which it crosses
+  //into the next column or row, tdelta is the fraction between crossings
+
+  float tmaxx = FLT_MAX, tdeltax = FLT_MAX;
+  float tmaxy = FLT_MAX, tdeltay = FLT_MAX;
+
+  if(d.x != 0.0f){
+    tmaxx = (m_fTileSize*(x + (stepx > 0? 1: 0)) - p0.x)/d.x;
+    tdeltax = m_fTileSize/fabsf(d.x);
+  } //if
+
+  if(d.y != 0.0f){
+    tmaxy = (m_fTileSize*(y + (stepy > 0? 1: 0)) - p0.y)/d.y;
+    tdeltay = m_fTileSize/fabsf(d.y);
+  } //if
+
+  //one step per column or row crossed, which also guards
+  //against rounding making us miss the last tile
+
+  for(int n=abs(x1 - x) + abs(y1 - y); n>=0; n--){
+    if(IsWall(x, y) && (margin == 0.0f ||
+      SegmentHitsRect(p0, d, m_fTileSize*x + margin, m_fTileSize*y + margin,
+        m_fTileSize*(x + 1) - margin, m_fTileSize*(y + 1) - margin)))
+      return false;
+
+    if(tmaxx < tmaxy){
+      x += stepx;
+      tmaxx += tdeltax;
+    } //if
+
+    else{
+      y += stepy;
+      tmaxy += tdeltay;
+    } //else
+  } //for
+
+  return true;
+} //RayClear
+
+/// Check whether a circle is visible from a point by casting rays through
+/// the tile map towards the left and right sides of the circle (from the
+/// perspective of the point), aimed at the middle of the sliver that the
+/// old triangle test used, see VisibleTriangles().
+/// \param p0 A point.
+/// \param p1 Center of circle.
+/// \param radius Radius of circle.
+/// \return true If either ray misses the walls.
+
+bool CTileManager::VisibleRays(const Vector2& p0, const Vector2& p1, float radius){
+  Vector2 direction = p0 - p1;
+  direction.Normalize();
+  const Vector2 norm = Vector2(-direction.y, direction.x);
+
+  const float r = radius - min(radius, 16.0f)/2; //middle of the sliver
+
+  return RayClear(p0, p1 + r*norm) || RayClear(p0, p1 - r*norm);
+} //VisibleRays
+
+/// Check whether a circle is visible from a point, that is, either the left
+/// or the right side of the circle (from the perspective of the point)
+/// has no walls between it and the point. The potentially visible set is
+/// asked first, and only if it can't rule the circle out are rays cast.
+/// \param p0 A point.
+/// \param p1 Center of circle.
+/// \param radius Radius of circle.
+/// \return true If the circle is visible from the point.
+
+bool CTileManager::Visible(const Vector2& p0, const Vector2& p1, float radius){
+  if(!PotentiallyVisible(p0, p1, radius))
+    return false; //no need to cast any rays
+
+  return VisibleRays(p0, p1, radius);
+} //Visible
+
+/// Check visibility for a batch of line of sight queries.
+/// \param lines [OUT] The queries, with their m_bVisible fields filled in.
+
+void CTileManager::Visible(vector<SightLine>& lines){
+  for(auto& l: lines)
+    l.m_bVisible = Visible(l.m_vEye, l.m_vTarget, l.m_fRadius);
+} //Visible
+
+#ifdef HEADLESS //only the headless harness checks visibility
+
 /// Check whether a circle is visible from a point, that is, either the left
 /// or the right side of the object (from the perspective of the point)
 /// has no walls between it and the point. This gives some weird behavior
 /// when the circle is partially hidden by a block, but it doesn't seem
-/// particularly unnatural in practice. It'll do.
+/// particularly unnatural in practice. It'll do. This tests every wall
+/// in the level, and is kept only to check Visible() against.
 /// \param p0 A point.
 /// \param p1 Center of circle.
 /// \param radius Radius of circle.
 /// \return true If the circle is visible from the point.
 
-bool CTileManager::Visible(const Vector2& p0, const Vector2& p1, float radius){
+bool CTileManager::VisibleTriangles(const Vector2& p0, const Vector2& p1, float radius){
   bool visible = true;
 
   for(auto i=m_vecWalls.begin(); i!=m_vecWalls.end() && visible; i++){
@@ -696,4 +1345,54 @@ bool CTileManager::Visible(const Vector2& p0, const Vector2& p1, float radius){
   } //for
 
   return visible;
-} //Visible
+} //VisibleTriangles
+
+/// Check the ways of working out visibility against each other on random
+/// sight lines from open tiles to circles centered in open tiles up to a
+/// tile beyond the potentially visible set's window, with radii like those of
+/// the characters. The potentially visible set should never rule out a
+/// circle that the rays can see, and Visible() should mostly agree with
+/// VisibleTriangles(), which it replaced. This tests every wall in the
+/// level for every sight line, so it is slow on big levels.
+/// \param n Number of sight lines.
+/// \param seed Seed for the random sight lines, which doesn't disturb the game's.
+/// \param check [OUT] What the different ways made of the sight lines.
+
+void CTileManager::CheckVisibility(unsigned n, int seed, VisibilityCheck& check){
+  check = VisibilityCheck();
+
+  CRandom random;
+  random.srand(seed);
+
+  const float rx = m_fTileSize*(PVS_RANGE_X + 1); //reach of the sight lines
+  const float ry = m_fTileSize*(PVS_RANGE_Y + 1);
+
+  auto open = [&](const Vector2& p){ //whether a point is in an open tile on the map
+    const int x = (int)floorf(p.x/m_fTileSize);
+    const int y = (int)floorf(p.y/m_fTileSize);
+    return x >= 0 && x < m_nWidth && y >= 0 && y < m_nHeight && !IsWall(x, y);
+  }; //open
+
+  while(check.m_nLines < n){
+    const Vector2 p0(m_nWidth*m_fTileSize*random.randf(), m_nHeight*m_fTileSize*random.randf());
+    const Vector2 p1 = p0 + Vector2(rx*(2*random.randf() - 1), ry*(2*random.randf() - 1));
+    if(!open(p0) || !open(p1))continue;
+
+    const float radius = 16.0f + 16.0f*random.randf();
+
+    const bool pvs = PotentiallyVisible(p0, p1, radius);
+    const bool rays = VisibleRays(p0, p1, radius);
+    const bool seen = pvs && rays; //what Visible() says
+    const bool triangles = VisibleTriangles(p0, p1, radius);
+
+    check.m_nLines++;
+    if(seen)check.m_nSeen++;
+    if(triangles)check.m_nSeenTriangles++;
+    if(seen && !triangles)check.m_nOnlyRays++;
+    if(triangles && !seen)check.m_nOnlyTriangles++;
+    if(!pvs)check.m_nRejected++;
+    if(!pvs && rays)check.m_nWronglyHidden++;
+  } //while
+} //CheckVisibility
+
+#endif //HEADLESS
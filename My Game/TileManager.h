@@ -4,6 +4,7 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>
 
 using namespace std;
 
@@ -37,6 +38,38 @@ using namespace std;
 	50 50 0 - breakable wall
 	75 75 75 - Enemy Spawn
 */
+/// \brief A line of sight query.
+///
+/// A request to find out whether a circle can be seen from a point,
+/// with room for the answer, so that many of them can be cast in a
+/// single call to CTileManager::Visible.
+
+struct SightLine{
+  Vector2 m_vEye; ///< Where we are looking from.
+  Vector2 m_vTarget; ///< Center of the circle we are looking at.
+  float m_fRadius = 0.0f; ///< Radius of the circle we are looking at.
+  bool m_bVisible = false; ///< [OUT] Whether the circle can be seen.
+}; //SightLine
+
+#ifdef HEADLESS //only the headless harness checks visibility
+
+/// \brief Results of CTileManager::CheckVisibility.
+///
+/// Counts of random sight lines, sorted by what the different ways of
+/// checking visibility made of them.
+
+struct VisibilityCheck{
+  unsigned m_nLines = 0; ///< Number of sight lines.
+  unsigned m_nSeen = 0; ///< Seen by Visible().
+  unsigned m_nSeenTriangles = 0; ///< Seen by VisibleTriangles().
+  unsigned m_nOnlyRays = 0; ///< Seen by Visible() but not VisibleTriangles().
+  unsigned m_nOnlyTriangles = 0; ///< Seen by VisibleTriangles() but not Visible().
+  unsigned m_nRejected = 0; ///< Rejected by the potentially visible set without casting rays.
+  unsigned m_nWronglyHidden = 0; ///< Rejected by the potentially visible set, but seen by the rays.
+}; //VisibilityCheck
+
+#endif //HEADLESS
+
 enum class objColor { NONE, WALL, LADDER_R, LADDER_L, EXIT,
   FAST, FIGHTER, SHIELD, DOOR, ELEVATOR, ENDPOINT, STOPPOINT, 
   ELECTRICITY, SWITCH_ELECTRIC, TELEPORTER, BREAKABLEWALL , 
@@ -56,6 +89,14 @@ class CTileManager: public CCommon{
     char** m_chMap = nullptr; ///< The level map.
 
     vector<BoundingBox> m_vecWalls; ///< AABBs for the walls.
+    vector<unsigned> m_vecWallCellStart; ///< Where each cell's walls start in m_vecWallCellList.
+    vector<unsigned> m_vecWallCellList; ///< Indices into m_vecWalls, grouped by cell.
+    vector<unsigned> m_vecWallStamp; ///< Last query that tested each wall.
+    vector<unsigned> m_vecWallHits; ///< Walls hit by the current query.
+    unsigned m_nWallStamp = 0; ///< Stamp for the current query.
+
+    vector<unsigned> m_vecPVS; ///< Visibility bits for the window around each open tile.
+    vector<int> m_vecPVSRow; ///< Which set of bits in m_vecPVS belongs to each tile, -1 for walls.
 
     vector<Vector3> m_vecLadders; ///< Positions of ladders.
 		vector<Vector3> m_vecDoors; //positions of the doors
@@ -75,7 +116,22 @@ class CTileManager: public CCommon{
 		Vector2 m_vFastLocation;
 		Vector2 m_vShieldLocation;
 
-    objColor CTileManager::getTileColor(unsigned char* buffer, const int &i); //used to simplify the map parsing
+    objColor getTileColor(const unsigned char* buffer, const int &i); //used to simplify the map parsing
+
+    void MakeWallIndex(); ///< Index the wall AABBs by the cells they cover.
+    bool GetCells(const BoundingBox& b, int& x0, int& y0, int& x1, int& y1); ///< Cells touched by an AABB.
+    bool GetCells(const BoundingSphere& s, int& x0, int& y0, int& x1, int& y1); ///< Cells touched by a sphere.
+    bool GetCells(float left, float bottom, float right, float top, int& x0, int& y0, int& x1, int& y1); ///< Cells touched by a rectangle.
+
+    bool RayClear(const Vector2& p0, const Vector2& p1, float margin=0.0f); ///< Whether a line segment misses the walls.
+    bool VisibleRays(const Vector2& p0, const Vector2& p1, float radius); ///< Check visibility by casting rays.
+
+    unsigned MakePVSRows(); ///< Index the potentially visible set by tile.
+    void MakePVS(); ///< Compute the potentially visible set.
+    bool PotentiallyVisible(const Vector2& p0, const Vector2& p1, float radius); ///< Look up the potentially visible set.
+
+    bool LoadLevelCache(const char* filename); ///< Load a level from its cache.
+    void SaveLevelCache(const char* filename); ///< Save a level to its cache.
 
 		//moved this over to public so that the object manager can call it
     //void MakeBoundingBoxes(char* filename); ///< Make bounding boxes for walls.
@@ -85,27 +141,40 @@ class CTileManager: public CCommon{
     ~CTileManager(); ///< Destructor.
 
     void LoadMap(char* filename); ///< Load a map.
-		void LoadMapFromImageFile(char* filename);//got this from lab 4
+		void LoadMapFromImageFile(const char* filename);//got this from lab 4
+    void LoadMapFromPixels(const unsigned char* buffer, int w, int h, int channels); ///< Load a map from a level image's pixels.
+    void LoadLevel(const char* filename); ///< Load a level image via its cache.
 		void MakeBoundingBoxes(); ///< Make bounding boxes for walls
     void Draw(eSpriteType t); ///< Draw the map with a given tile.
     void DrawBoundingBoxes(eSpriteType t); ///< Draw the bounding boxes.
 		void clear();
 
+    bool IsWall(int x, int y) const; ///< Whether a tile is a wall.
     bool Visible(const Vector2& v0, const Vector2& v1, float radius); ///< Check visibility.
-
-    vector<Vector3> GetLadders() { return m_vecLadders; }; ///< Get Ladders
-		vector<Vector3> getDoors() { return m_vecDoors; }// get the vector of dooors
-		vector<Vector2> getEndPoints() { return m_vecEndPoints; }//ya know
-		vector<Vector2> getElevators() { return m_vecElevators; }//ya know
-		vector<Vector2> getStopPoints() { return m_vecStopPoints; }
-		vector<Vector3> getTraps() { return m_vecTraps; }
-		vector<Vector3> getSwitches() { return m_vecSwitches; }
-		vector<Vector3> getTeleporters() { return m_vecTeleporters; }
-		vector<Vector2> getBreakableWalls() { return m_vecBreakableWalls; }
-		vector<Vector2> getTeleporterSpawns() { return m_vecTeleportSpawns; }
-		vector<Vector2> getEnemies() { return m_vecEnemies; }
-		vector<Vector3> getKeys() { return m_vecKeys; }
-    vector<Vector2> getGuns() { return m_vecGuns; }
+    void Visible(vector<SightLine>& lines); ///< Check visibility of many circles.
+
+  #ifdef HEADLESS
+    bool VisibleTriangles(const Vector2& v0, const Vector2& v1, float radius); ///< Check visibility the old way.
+    void CheckVisibility(unsigned n, int seed, VisibilityCheck& check); ///< Compare the ways of checking visibility.
+  #endif //HEADLESS
+
+    int GetWidth() const { return m_nWidth; }; ///< Get width in tiles.
+    int GetHeight() const { return m_nHeight; }; ///< Get height in tiles.
+    float GetTileSize() const { return m_fTileSize; }; ///< Get tile size.
+    const vector<BoundingBox>& GetWalls() const { return m_vecWalls; }; ///< Get wall AABBs.
+    const vector<Vector3>& GetLadders() const { return m_vecLadders; }; ///< Get Ladders
+		const vector<Vector3>& getDoors() const { return m_vecDoors; }// get the vector of dooors
+		const vector<Vector2>& getEndPoints() const { return m_vecEndPoints; }//ya know
+		const vector<Vector2>& getElevators() const { return m_vecElevators; }//ya know
+		const vector<Vector2>& getStopPoints() const { return m_vecStopPoints; }
+		const vector<Vector3>& getTraps() const { return m_vecTraps; }
+		const vector<Vector3>& getSwitches() const { return m_vecSwitches; }
+		const vector<Vector3>& getTeleporters() const { return m_vecTeleporters; }
+		const vector<Vector2>& getBreakableWalls() const { return m_vecBreakableWalls; }
+		const vector<Vector2>& getTeleporterSpawns() const { return m_vecTeleportSpawns; }
+		const vector<Vector2>& getEnemies() const { return m_vecEnemies; }
+		const vector<Vector3>& getKeys() const { return m_vecKeys; }
+    const vector<Vector2>& getGuns() const { return m_vecGuns; }
 		Vector2 getExitLocation() { return m_vExitLocation; };//"this must be my exit" --- Oso Oso
 		Vector2 getFastLocation() { return m_vFastLocation; }
 		Vector2 getFighterLocation() { return m_vFighterLocation; }
@@ -121,20 +190,43 @@ class CTileManager: public CCommon{
 /// Determine whether a bounding shape intersects a wall. If it does,
 /// then the second parameter is set to the walls that it collided with,
 /// which will usually be one or two walls (one horizontal, one vertical).
+/// Only the walls indexed under the cells that the shape touches are
+/// tested, so the cost depends on the size of the shape, not the size
+/// of the level. The walls are reported in the same order as they
+/// appear in m_vecWalls.
 /// \param s A bounding shape.
 /// \param walls [OUT] A vector of the walls that collided with. 
 /// \return true if the bounding shape intersects a wall.
 
 template<class t> bool CTileManager::CollideWithWall(const t& s, vector<BoundingBox>& walls){
-  bool hit = false;
   walls.clear();
 
-  for(auto wall: m_vecWalls){
-    if(s.Intersects(wall)){
-      hit = true;
-      walls.push_back(wall);
-    } //if
-  } //for
+  int x0, y0, x1, y1; //range of cells touched
+  if(!GetCells(s, x0, y0, x1, y1))return false;
+
+  m_vecWallHits.clear();
+  m_nWallStamp++;
+
+  for(int y=y0; y<=y1; y++)
+    for(int x=x0; x<=x1; x++){
+      const int cell = y*m_nWidth + x;
+
+      for(unsigned k=m_vecWallCellStart[cell]; k<m_vecWallCellStart[cell + 1]; k++){
+        const unsigned w = m_vecWallCellList[k]; //index of wall
+
+        if(m_vecWallStamp[w] != m_nWallStamp){ //not tested yet
+          m_vecWallStamp[w] = m_nWallStamp;
+
+          if(s.Intersects(m_vecWalls[w]))
+            m_vecWallHits.push_back(w);
+        } //if
+      } //for
+    } //for
+
+  sort(m_vecWallHits.begin(), m_vecWallHits.end()); //m_vecWalls order
+
+  for(auto const& w: m_vecWallHits)
+    walls.push_back(m_vecWalls[w]);
 
-  return hit;
-} //CollideWithWall
\ No newline at end of file
+  return !walls.empty();
+} //CollideWithWall 
\ No newline at end of file
@@ -79,7 +79,7 @@ void Switch::flipTrapSwitch()
 	else
 		state = true;
 
-	for (auto t : m_pObjectManager->getVecTraps())
+	for (auto const& t : m_pObjectManager->getVecTraps())
 	{
 		if (((Trap*)t)->getIndex() == ((Switch*)this)->getIndex())
 		{
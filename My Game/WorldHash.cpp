@@ -0,0 +1,104 @@
+/// \file WorldHash.cpp
+/// \brief Code for the world hash CWorldHash.
+
+#include "WorldHash.h"
+
+#include <string.h>
+
+static const unsigned PRIME1 = 0x9E3779B1U; ///< xxHash32 prime 1.
+static const unsigned PRIME2 = 0x85EBCA77U; ///< xxHash32 prime 2.
+static const unsigned PRIME3 = 0xC2B2AE3DU; ///< xxHash32 prime 3.
+static const unsigned PRIME4 = 0x27D4EB2FU; ///< xxHash32 prime 4.
+static const unsigned PRIME5 = 0x165667B1U; ///< xxHash32 prime 5.
+
+/// Rotate left.
+/// \param x Value to rotate.
+/// \param r Number of bits to rotate by, from 1 to 31.
+/// \return x rotated left by r bits.
+
+static inline unsigned rotl(unsigned x, unsigned r){
+  return (x << r) | (x >> (32 - r));
+} //rotl
+
+/// Start the accumulators off the way that xxHash32 does with seed 0.
+
+CWorldHash::CWorldHash(){
+  m_nAcc[0] = PRIME1 + PRIME2;
+  m_nAcc[1] = PRIME2;
+  m_nAcc[2] = 0;
+  m_nAcc[3] = 0 - PRIME1;
+} //constructor
+
+/// Hash an unsigned integer. This is the one that does
+/// the actual work: the others turn what they are given
+/// into unsigned integers and pass them on to this one.
+/// When a stripe is full, it is folded into the accumulators.
+/// \param n An unsigned integer.
+
+void CWorldHash::add(unsigned n){
+  m_nStripe[m_nWords++] = n;
+  m_nTotal++;
+
+  if(m_nWords == 4){ //stripe is full
+    for(int i=0; i<4; i++) //independent, so can be done in parallel
+      m_nAcc[i] = rotl(m_nAcc[i] + m_nStripe[i]*PRIME2, 13)*PRIME1;
+
+    m_nWords = 0;
+  } //if
+} //add
+
+/// Hash an integer.
+/// \param n An integer.
+
+void CWorldHash::add(int n){
+  add((unsigned)n);
+} //add
+
+/// Hash a Boolean.
+/// \param b A Boolean.
+
+void CWorldHash::add(bool b){
+  add(b? 1U: 0U);
+} //add
+
+/// Hash a float, bit for bit.
+/// \param x A float.
+
+void CWorldHash::add(float x){
+  unsigned n;
+  memcpy(&n, &x, sizeof(n));
+  add(n);
+} //add
+
+/// Hash a 2D vector.
+/// \param v A 2D vector.
+
+void CWorldHash::add(const Vector2& v){
+  add(v.x);
+  add(v.y);
+} //add
+
+/// Get the hash of everything hashed so far. More can be
+/// added afterwards, and the digest taken again.
+/// \return The hash.
+
+unsigned CWorldHash::digest(){
+  unsigned h = (m_nTotal >= 4)?
+    rotl(m_nAcc[0], 1) + rotl(m_nAcc[1], 7) + rotl(m_nAcc[2], 12) + rotl(m_nAcc[3], 18):
+    PRIME5;
+
+  h += 4*m_nTotal; //length in bytes
+
+  for(unsigned i=0; i<m_nWords; i++) //the words left over
+    h = rotl(h + m_nStripe[i]*PRIME3, 17)*PRIME4;
+
+  //avalanche
+
+  h ^= h >> 15;
+  h *= PRIME2;
+  h ^= h >> 13;
+  h *= PRIME3;
+  h ^= h >> 16;
+
+  return h;
+} //digest
@@ -0,0 +1,37 @@
+/// \file WorldHash.h
+/// \brief Interface for the world hash CWorldHash.
+
+#pragma once
+
+#include "Defines.h"
+
+/// \brief A hash of the state of the world.
+///
+/// CWorldHash is a streaming version of the 32-bit xxHash function for
+/// a sequence of 32-bit words. Words are gathered into stripes of 4,
+/// and each word of a stripe goes into its own accumulator, so the 4
+/// accumulators are independent and the compiler is free to do a
+/// stripe as a single SIMD operation. Floats are hashed bit for bit, so
+/// two worlds hash the same only if they are exactly the same, which
+/// is what is needed to check that a change didn't change gameplay.
+/// The result is the same as xxHash32 of the words laid out
+/// little-endian in memory, with seed 0.
+
+class CWorldHash{
+  private:
+    unsigned m_nAcc[4]; ///< Accumulators, one per word of a stripe.
+    unsigned m_nStripe[4]; ///< Words of the current stripe so far.
+    unsigned m_nWords = 0; ///< Number of words in the current stripe.
+    unsigned m_nTotal = 0; ///< Number of words hashed so far.
+
+  public:
+    CWorldHash(); ///< Constructor.
+
+    void add(unsigned n); ///< Hash an unsigned integer.
+    void add(int n); ///< Hash an integer.
+    void add(bool b); ///< Hash a Boolean.
+    void add(float x); ///< Hash a float.
+    void add(const Vector2& v); ///< Hash a 2D vector.
+
+    unsigned digest(); ///< Get the hash of everything so far.
+}; //CWorldHash